@@ -1,9 +1,11 @@
 #include "address_manager.h"
 #include "avltree.h"
+#include "bootstrap.h"
 #include "log.h"
 #include "socket.h"
 #include "worker.h"
 #include <limits.h>
+#include <pthread.h>
 
 #define BITMASK(b)     (1 << ((b) % CHAR_BIT))
 #define BITSLOT(b)     ((b) / CHAR_BIT)
@@ -15,6 +17,8 @@
 #define NPORTS (32768 - 1024)
 
 struct avl_tree_t address_map;
+/* written by the main thread, read by every shard */
+static pthread_rwlock_t address_map_lock = PTHREAD_RWLOCK_INITIALIZER;
 static char used_ports_bitset[BITNSLOTS(NPORTS)];
 
 void address_mngr_init()
@@ -54,7 +58,7 @@ static int create_unique_port_from_ip(const char *address)
 
 void address_mngr_add_address_by_port(int port, const char *address)
 {
-    int fd;
+    int fd, shard;
     struct soap_instance *instance;
 
     if (BITTEST(used_ports_bitset, port - 1024))
@@ -64,18 +68,21 @@ void address_mngr_add_address_by_port(int port, const char *address)
 
     fd = socket_create_udp(port);
 
-    instance = soap_instance_allocate(address);
-    if (instance == NULL)
-        return;
+    shard = worker_pick_shard();
+
+    instance = soap_instance_allocate(address, shard);
 
-    worker_add_udp_fd(fd);
+    log("add address map fd %d -> port %d -> address %s shard %d", fd, port, address, shard);
 
-    log("add address map fd %d -> port %d -> address %s", fd, port, address);
+    /* the instance must be findable before the shard can receive on fd */
+    pthread_rwlock_wrlock(&address_map_lock);
     avl_tree_insert(&address_map, fd, instance);
+    pthread_rwlock_unlock(&address_map_lock);
 
-    soap_instance_print_info(instance);
+    /* the socket answers right away, the camera's onvif side comes up in the background */
+    worker_add_udp_fd(fd, shard);
 
-    log(" ");
+    bootstrap_submit(instance);
 }
 
 void address_mngr_add_address(const char *address)
@@ -89,7 +96,12 @@ void address_mngr_add_address(const char *address)
 
 struct soap_instance* address_mngr_get_soap_instance_from_fd(int fd)
 {
-    struct soap_instance* instance = avl_tree_find(&address_map, fd);
+    struct soap_instance* instance;
+
+    pthread_rwlock_rdlock(&address_map_lock);
+    instance = avl_tree_find(&address_map, fd);
+    pthread_rwlock_unlock(&address_map_lock);
+
     if (instance == NULL)
         die(ERR_SOCKET, "address manager: failed to find fd = %d", fd);
 
@@ -119,10 +131,13 @@ static struct soap_instance* find_soap_instance_matching_ip(struct avl_node_t *n
 
 struct soap_instance* address_mngr_find_soap_instance_matching_ip(const char *ip)
 {
-    if (address_map.root == NULL)
-        return NULL;
+    struct soap_instance *instance;
 
-    return find_soap_instance_matching_ip(address_map.root, ip);
+    pthread_rwlock_rdlock(&address_map_lock);
+    instance = find_soap_instance_matching_ip(address_map.root, ip);
+    pthread_rwlock_unlock(&address_map_lock);
+
+    return instance;
 }
 
 static void node_destruction_cb(struct avl_node_t *node)
@@ -0,0 +1,186 @@
+#include "bootstrap.h"
+#include "camera_cache.h"
+#include "errors.h"
+#include "log.h"
+#include "soap_global.h"
+#include "timer_wheel.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* a camera waiting for its onvif bootstrap, due is the earliest time to try it */
+struct bootstrap_job
+{
+    struct soap_instance *instance;
+    uint64_t due;
+    struct bootstrap_job *next;
+};
+
+/* cameras are bootstrapped by g_bootstrap_jobs threads with blocking calls on their own soap
+   contexts, so a rack of cameras comes up in parallel and offline ones only hold one thread
+   each for the length of their timeouts */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static struct bootstrap_job *jobs;
+static pthread_t *threads;
+static int threads_count;
+static int stop;
+
+static void push(struct bootstrap_job *job)
+{
+    job->next = jobs;
+    jobs = job;
+
+    pthread_cond_signal(&cond);
+}
+
+/* unlinks the first due job, otherwise sets *wait_ms to the time until the next one is due
+   or to -1 if there is none */
+static struct bootstrap_job* take_due(int64_t *wait_ms)
+{
+    struct bootstrap_job **it = &jobs, *job;
+    uint64_t now = timer_wheel_now_ms();
+
+    *wait_ms = -1;
+
+    for (; *it != NULL; it = &(*it)->next) {
+        job = *it;
+
+        if (job->due <= now) {
+            *it = job->next;
+            return job;
+        }
+
+        if (*wait_ms == -1 || (int64_t)(job->due - now) < *wait_ms)
+            *wait_ms = (int64_t)(job->due - now);
+    }
+
+    return NULL;
+}
+
+static void wait_for_job(int64_t wait_ms)
+{
+    struct timespec deadline;
+
+    if (wait_ms == -1) {
+        pthread_cond_wait(&cond, &lock);
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += wait_ms / 1000;
+    deadline.tv_nsec += (wait_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_cond_timedwait(&cond, &lock, &deadline);
+}
+
+static void* thread_main(void *arg)
+{
+    struct bootstrap_job *job;
+    int64_t wait_ms;
+    int err;
+
+    g_soap = soap_global_new_context();
+
+    pthread_mutex_lock(&lock);
+
+    while (!stop) {
+        job = take_due(&wait_ms);
+        if (job == NULL) {
+            wait_for_job(wait_ms);
+            continue;
+        }
+
+        pthread_mutex_unlock(&lock);
+        err = soap_instance_bootstrap(job->instance);
+        pthread_mutex_lock(&lock);
+
+        if (err == 0) {
+            free(job);
+            continue;
+        }
+
+        log("bootstrap: %s failed, retrying in %d s", job->instance->service_endpoint,
+                BOOTSTRAP_RETRY_MS / 1000);
+
+        job->due = timer_wheel_now_ms() + BOOTSTRAP_RETRY_MS;
+        push(job);
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    soap_global_destruct();
+
+    return NULL;
+}
+
+/* cameras known from the last run are usable right away, their jobs revalidate them */
+void bootstrap_init()
+{
+    int err;
+
+    camera_cache_load();
+
+    for (struct bootstrap_job *job = jobs; job != NULL; job = job->next)
+        soap_instance_warm_start(job->instance);
+
+    threads = malloc(g_bootstrap_jobs * sizeof(pthread_t));
+    if (threads == NULL)
+        die(ERR_NOMEM, "failed to malloc(%zd)", g_bootstrap_jobs * sizeof(pthread_t));
+
+    for (threads_count = 0; threads_count < g_bootstrap_jobs; ++threads_count) {
+        err = pthread_create(&threads[threads_count], NULL, thread_main, NULL);
+        if (err != 0)
+            die(ERR_THREAD, "pthread_create() failed: %s", strerror(err));
+    }
+}
+
+/* may be called before bootstrap_init(), the job waits for the threads then */
+void bootstrap_submit(struct soap_instance *instance)
+{
+    struct bootstrap_job *job = malloc(sizeof(struct bootstrap_job));
+    if (job == NULL)
+        die(ERR_NOMEM, "failed to malloc(%zd)", sizeof(struct bootstrap_job));
+
+    job->instance = instance;
+    job->due = 0;
+
+    /* before bootstrap_init() the cache is not loaded yet, the job is warm started there */
+    if (threads != NULL)
+        soap_instance_warm_start(instance);
+
+    pthread_mutex_lock(&lock);
+    push(job);
+    pthread_mutex_unlock(&lock);
+}
+
+/* a thread in the middle of a bootstrap finishes it first */
+void bootstrap_destruct()
+{
+    struct bootstrap_job *next;
+
+    pthread_mutex_lock(&lock);
+    stop = 1;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < threads_count; ++i)
+        pthread_join(threads[i], NULL);
+
+    free(threads);
+
+    while (jobs != NULL) {
+        next = jobs->next;
+        free(jobs);
+        jobs = next;
+    }
+
+    camera_cache_destruct();
+}
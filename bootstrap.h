@@ -0,0 +1,11 @@
+#pragma once
+
+#include "soap_instance.h"
+
+#define BOOTSTRAP_RETRY_MS 30000
+
+extern int g_bootstrap_jobs;
+
+void bootstrap_init();
+void bootstrap_submit(struct soap_instance *instance);
+void bootstrap_destruct();
@@ -0,0 +1,17 @@
+#include "bridge.h"
+#include "address_manager.h"
+#include "log.h"
+#include "soap_instance.h"
+
+/* for the camera the controller on fd talks to */
+int bridge_camera_in_service(int fd)
+{
+    struct soap_instance *instance = address_mngr_get_soap_instance_from_fd(fd);
+
+    if (soap_instance_in_service(instance))
+        return 1;
+
+    log("visca: %s can't take commands now", instance->service_endpoint);
+
+    return 0;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+/* what the visca side asks about the camera behind a controller's socket. it stays clear of
+   the soap headers, so the visca code builds without the generated onvif sources */
+int bridge_camera_in_service(int fd);
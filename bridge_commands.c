@@ -1,5 +1,6 @@
 #include "bridge_commands.h"
 #include "log.h"
+#include "soap_imaging.h"
 #include "soap_ptz.h"
 #include "soap_utils.h"
 #include "soap_instance.h"
@@ -12,22 +13,31 @@ static void log_p5t4(uint8_t p[5], uint8_t t[4])
 
 void bridge_cmd_color_bgain_direct(int p)
 {
-    log("bridge_cmd_color_bgain_direct STUB");
+    /* from -128 to 127 */
+    log("bridge_cmd_color_bgain_direct %d", p);
+
+    soap_imaging_set_fraction(SIF_CB_GAIN, (float)(p + 128) / 255.f);
 }
 
 void bridge_cmd_color_bgain_down()
 {
-    log("bridge_cmd_color_bgain_down STUB");
+    log("bridge_cmd_color_bgain_down");
+
+    soap_imaging_step(SIF_CB_GAIN, -1, 255);
 }
 
 void bridge_cmd_color_bgain_reset()
 {
-    log("bridge_cmd_color_bgain_reset STUB");
+    log("bridge_cmd_color_bgain_reset");
+
+    soap_imaging_reset(SIF_CB_GAIN);
 }
 
 void bridge_cmd_color_bgain_up()
 {
-    log("bridge_cmd_color_bgain_up STUB");
+    log("bridge_cmd_color_bgain_up");
+
+    soap_imaging_step(SIF_CB_GAIN, 1, 255);
 }
 
 void bridge_cmd_color_bg(int p)
@@ -57,22 +67,31 @@ void bridge_cmd_color_gr(int p)
 
 void bridge_cmd_color_level_direct(uint8_t p)
 {
-    log("bridge_cmd_color_level_direct STUB");
+    /* from 0 to 14 */
+    log("bridge_cmd_color_level_direct %d", p);
+
+    soap_imaging_set_fraction(SIF_SATURATION, (float)p / 14.f);
 }
 
 void bridge_cmd_color_level_down()
 {
-    log("bridge_cmd_color_level_down STUB");
+    log("bridge_cmd_color_level_down");
+
+    soap_imaging_step(SIF_SATURATION, -1, 14);
 }
 
 void bridge_cmd_color_level_reset()
 {
-    log("bridge_cmd_color_level_reset STUB");
+    log("bridge_cmd_color_level_reset");
+
+    soap_imaging_reset(SIF_SATURATION);
 }
 
 void bridge_cmd_color_level_up()
 {
-    log("bridge_cmd_color_level_up STUB");
+    log("bridge_cmd_color_level_up");
+
+    soap_imaging_step(SIF_SATURATION, 1, 14);
 }
 
 void bridge_cmd_color_matrix_select(uint8_t p)
@@ -132,22 +151,31 @@ void bridge_cmd_color_rb(int p)
 
 void bridge_cmd_color_rgain_direct(int p)
 {
-    log("bridge_cmd_color_rgain_direct STUB");
+    /* from -128 to 127 */
+    log("bridge_cmd_color_rgain_direct %d", p);
+
+    soap_imaging_set_fraction(SIF_CR_GAIN, (float)(p + 128) / 255.f);
 }
 
 void bridge_cmd_color_rgain_down()
 {
-    log("bridge_cmd_color_rgain_down STUB");
+    log("bridge_cmd_color_rgain_down");
+
+    soap_imaging_step(SIF_CR_GAIN, -1, 255);
 }
 
 void bridge_cmd_color_rgain_reset()
 {
-    log("bridge_cmd_color_rgain_reset STUB");
+    log("bridge_cmd_color_rgain_reset");
+
+    soap_imaging_reset(SIF_CR_GAIN);
 }
 
 void bridge_cmd_color_rgain_up()
 {
-    log("bridge_cmd_color_rgain_up STUB");
+    log("bridge_cmd_color_rgain_up");
+
+    soap_imaging_step(SIF_CR_GAIN, 1, 255);
 }
 
 void bridge_cmd_color_rg(int p)
@@ -162,32 +190,45 @@ void bridge_cmd_color_speed(uint8_t speed)
 
 void bridge_cmd_color_white_balance_auto1()
 {
-    log("bridge_cmd_color_white_balance_auto1 STUB");
+    log("bridge_cmd_color_white_balance_auto1");
+
+    soap_imaging_set(SIF_WHITE_BALANCE_MODE, tt__WhiteBalanceMode__AUTO);
 }
 
 void bridge_cmd_color_white_balance_auto2()
 {
-    log("bridge_cmd_color_white_balance_auto2 STUB");
+    log("bridge_cmd_color_white_balance_auto2");
+
+    soap_imaging_set(SIF_WHITE_BALANCE_MODE, tt__WhiteBalanceMode__AUTO);
 }
 
 void bridge_cmd_color_white_balance_indoor()
 {
-    log("bridge_cmd_color_white_balance_indoor STUB");
+    /* onvif has no fixed presets, manual keeps the gains the camera has */
+    log("bridge_cmd_color_white_balance_indoor");
+
+    soap_imaging_set(SIF_WHITE_BALANCE_MODE, tt__WhiteBalanceMode__MANUAL);
 }
 
 void bridge_cmd_color_white_balance_manual()
 {
-    log("bridge_cmd_color_white_balance_manual STUB");
+    log("bridge_cmd_color_white_balance_manual");
+
+    soap_imaging_set(SIF_WHITE_BALANCE_MODE, tt__WhiteBalanceMode__MANUAL);
 }
 
 void bridge_cmd_color_white_balance_one_push_wb()
 {
-    log("bridge_cmd_color_white_balance_one_push_wb STUB");
+    log("bridge_cmd_color_white_balance_one_push_wb");
+
+    soap_imaging_set(SIF_WHITE_BALANCE_MODE, tt__WhiteBalanceMode__AUTO);
 }
 
 void bridge_cmd_color_white_balance_outdoor()
 {
-    log("bridge_cmd_color_white_balance_outdoor STUB");
+    log("bridge_cmd_color_white_balance_outdoor");
+
+    soap_imaging_set(SIF_WHITE_BALANCE_MODE, tt__WhiteBalanceMode__MANUAL);
 }
 
 void bridge_cmd_detail_bandwidth()
@@ -257,47 +298,69 @@ void bridge_cmd_exposure_ae_speed(uint8_t p)
 
 void bridge_cmd_exposure_back_light_set(uint8_t on)
 {
-    log("bridge_cmd_exposure_back_light_set STUB");
+    log("bridge_cmd_exposure_back_light_set %d", on);
+
+    soap_imaging_set(SIF_BACKLIGHT,
+            on ? tt__BacklightCompensationMode__ON : tt__BacklightCompensationMode__OFF);
 }
 
 void bridge_cmd_exposure_exp_comp_direct(uint8_t p)
 {
-    log("bridge_cmd_exposure_exp_comp_direct STUB");
+    /* from 0 to 14, 7 is no compensation */
+    log("bridge_cmd_exposure_exp_comp_direct %d", p);
+
+    soap_imaging_set_fraction(SIF_BRIGHTNESS, (float)p / 14.f);
 }
 
 void bridge_cmd_exposure_exp_comp_down()
 {
-    log("bridge_cmd_exposure_exp_comp_down STUB");
+    log("bridge_cmd_exposure_exp_comp_down");
+
+    soap_imaging_step(SIF_BRIGHTNESS, -1, 14);
 }
 
 void bridge_cmd_exposure_exp_comp_reset()
 {
-    log("bridge_cmd_exposure_exp_comp_reset STUB");
+    log("bridge_cmd_exposure_exp_comp_reset");
+
+    soap_imaging_reset(SIF_BRIGHTNESS);
 }
 
 void bridge_cmd_exposure_exp_comp_set(uint8_t onoff)
 {
-    log("bridge_cmd_exposure_exp_comp_set STUB");
+    /* onvif has no switch for it, off goes back to the brightness the camera had */
+    log("bridge_cmd_exposure_exp_comp_set %d", onoff);
+
+    if (!onoff)
+        soap_imaging_reset(SIF_BRIGHTNESS);
 }
 
 void bridge_cmd_exposure_exp_comp_up()
 {
-    log("bridge_cmd_exposure_exp_comp_up STUB");
+    log("bridge_cmd_exposure_exp_comp_up");
+
+    soap_imaging_step(SIF_BRIGHTNESS, 1, 14);
 }
 
 void bridge_cmd_exposure_gain_direct(int db)
 {
-    log("bridge_cmd_exposure_gain_direct STUB");
+    log("bridge_cmd_exposure_gain_direct %d", db);
+
+    soap_imaging_set(SIF_GAIN, db);
 }
 
 void bridge_cmd_exposure_gain_down()
 {
-    log("bridge_cmd_exposure_gain_down STUB");
+    log("bridge_cmd_exposure_gain_down");
+
+    soap_imaging_step(SIF_GAIN, -1, 15);
 }
 
 void bridge_cmd_exposure_gain_limit(int db)
 {
-    log("bridge_cmd_exposure_gain_limit STUB");
+    log("bridge_cmd_exposure_gain_limit %d", db);
+
+    soap_imaging_set(SIF_MAX_GAIN, db);
 }
 
 void bridge_cmd_exposure_gain_point_position(int db)
@@ -312,37 +375,53 @@ void bridge_cmd_exposure_gain_point_set(uint8_t on)
 
 void bridge_cmd_exposure_gain_reset()
 {
-    log("bridge_cmd_exposure_gain_reset STUB");
+    log("bridge_cmd_exposure_gain_reset");
+
+    soap_imaging_reset(SIF_GAIN);
 }
 
 void bridge_cmd_exposure_gain_up()
 {
-    log("bridge_cmd_exposure_gain_up STUB");
+    log("bridge_cmd_exposure_gain_up");
+
+    soap_imaging_step(SIF_GAIN, 1, 15);
 }
 
 void bridge_cmd_exposure_ir_cut_filter_set(uint8_t on)
 {
-    log("bridge_cmd_exposure_ir_cut_filter_set STUB");
+    /* on is night mode, the filter is taken out */
+    log("bridge_cmd_exposure_ir_cut_filter_set %d", on);
+
+    soap_imaging_set(SIF_IR_CUT_FILTER, on ? tt__IrCutFilterMode__OFF : tt__IrCutFilterMode__ON);
 }
 
 void bridge_cmd_exposure_iris_direct(uint8_t position)
 {
-    log("bridge_cmd_exposure_iris_direct STUB");
+    /* from 0 (closed) to 17 */
+    log("bridge_cmd_exposure_iris_direct %d", position);
+
+    soap_imaging_set_fraction(SIF_IRIS, (float)position / 17.f);
 }
 
 void bridge_cmd_exposure_iris_down()
 {
-    log("bridge_cmd_exposure_iris_down STUB");
+    log("bridge_cmd_exposure_iris_down");
+
+    soap_imaging_step(SIF_IRIS, -1, 17);
 }
 
 void bridge_cmd_exposure_iris_reset()
 {
-    log("bridge_cmd_exposure_iris_reset STUB");
+    log("bridge_cmd_exposure_iris_reset");
+
+    soap_imaging_reset(SIF_IRIS);
 }
 
 void bridge_cmd_exposure_iris_up()
 {
-    log("bridge_cmd_exposure_iris_up STUB");
+    log("bridge_cmd_exposure_iris_up");
+
+    soap_imaging_step(SIF_IRIS, 1, 17);
 }
 
 void bridge_cmd_exposure_low_light_basis_brightness_direct(uint8_t p)
@@ -362,27 +441,38 @@ void bridge_cmd_exposure_minmax_shutter_set(uint8_t min, uint8_t p)
 
 void bridge_cmd_exposure_mode_full_auto()
 {
-    log("bridge_cmd_exposure_mode_full_auto STUB");
+    log("bridge_cmd_exposure_mode_full_auto");
+
+    soap_imaging_set(SIF_EXPOSURE_MODE, tt__ExposureMode__AUTO);
 }
 
 void bridge_cmd_exposure_mode_gain_pri()
 {
-    log("bridge_cmd_exposure_mode_gain_pri STUB");
+    /* onvif has no priority modes, in manual the value the operator sets takes effect */
+    log("bridge_cmd_exposure_mode_gain_pri");
+
+    soap_imaging_set(SIF_EXPOSURE_MODE, tt__ExposureMode__MANUAL);
 }
 
 void bridge_cmd_exposure_mode_iris_pri()
 {
-    log("bridge_cmd_exposure_mode_iris_pri STUB");
+    log("bridge_cmd_exposure_mode_iris_pri");
+
+    soap_imaging_set(SIF_EXPOSURE_MODE, tt__ExposureMode__MANUAL);
 }
 
 void bridge_cmd_exposure_mode_manual()
 {
-    log("bridge_cmd_exposure_mode_manual STUB");
+    log("bridge_cmd_exposure_mode_manual");
+
+    soap_imaging_set(SIF_EXPOSURE_MODE, tt__ExposureMode__MANUAL);
 }
 
 void bridge_cmd_exposure_mode_shutter_pri()
 {
-    log("bridge_cmd_exposure_mode_shutter_pri STUB");
+    log("bridge_cmd_exposure_mode_shutter_pri");
+
+    soap_imaging_set(SIF_EXPOSURE_MODE, tt__ExposureMode__MANUAL);
 }
 
 void bridge_cmd_exposure_nd_filter(uint8_t p)
@@ -392,22 +482,31 @@ void bridge_cmd_exposure_nd_filter(uint8_t p)
 
 void bridge_cmd_exposure_shutter_direct(uint8_t position)
 {
-    log("bridge_cmd_exposure_shutter_direct STUB");
+    /* from 0 (slowest) to 21, the exposure time runs the other way */
+    log("bridge_cmd_exposure_shutter_direct %d", position);
+
+    soap_imaging_set_fraction(SIF_EXPOSURE_TIME, 1.f - (float)position / 21.f);
 }
 
 void bridge_cmd_exposure_shutter_fast()
 {
-    log("bridge_cmd_exposure_shutter_fast STUB");
+    log("bridge_cmd_exposure_shutter_fast");
+
+    soap_imaging_step(SIF_EXPOSURE_TIME, -1, 21);
 }
 
 void bridge_cmd_exposure_shutter_reset()
 {
-    log("bridge_cmd_exposure_shutter_reset STUB");
+    log("bridge_cmd_exposure_shutter_reset");
+
+    soap_imaging_reset(SIF_EXPOSURE_TIME);
 }
 
 void bridge_cmd_exposure_shutter_slow()
 {
-    log("bridge_cmd_exposure_shutter_slow STUB");
+    log("bridge_cmd_exposure_shutter_slow");
+
+    soap_imaging_step(SIF_EXPOSURE_TIME, 1, 21);
 }
 
 void bridge_cmd_exposure_spot_light_set(uint8_t on)
@@ -437,22 +536,36 @@ void bridge_cmd_focus_af_sensitivity(uint8_t normal)
 
 void bridge_cmd_focus_direct(uint32_t p)
 {
-    log("bridge_cmd_focus_direct STUB");
+    /* from 0x1000 (infinity) to 0xf000 */
+    float position = ((float)p - 0x1000) / 0xe000;
+
+    log("bridge_cmd_focus_direct %u", p);
+
+    soap_imaging_focus_absolute(position < 0.f ? 0.f : position > 1.f ? 1.f : position);
 }
 
 void bridge_cmd_focus_far()
 {
-    log("bridge_cmd_focus_far STUB");
+    log("bridge_cmd_focus_far");
+
+    soap_imaging_focus_continuous(0.5f);
 }
 
 void bridge_cmd_focus_far_var(uint8_t p)
 {
-    log("bridge_cmd_focus_far_var STUB");
+    /* p from 0 to 7, 0 is the slowest speed and not a stop */
+    float speed = (float)(p + 1) / 8.f;
+
+    log("bridge_cmd_focus_far_var %d", p);
+
+    soap_imaging_focus_continuous(speed);
 }
 
 void bridge_cmd_focus_focus_inf()
 {
-    log("bridge_cmd_focus_focus_inf STUB");
+    log("bridge_cmd_focus_focus_inf");
+
+    soap_imaging_focus_absolute(0.f);
 }
 
 void bridge_cmd_focus_ir_correction(uint8_t ir_light)
@@ -462,22 +575,30 @@ void bridge_cmd_focus_ir_correction(uint8_t ir_light)
 
 void bridge_cmd_focus_mode_auto()
 {
-    log("bridge_cmd_focus_mode_auto STUB");
+    log("bridge_cmd_focus_mode_auto");
+
+    soap_imaging_set(SIF_FOCUS_MODE, tt__AutoFocusMode__AUTO);
 }
 
 void bridge_cmd_focus_mode_manual()
 {
-    log("bridge_cmd_focus_mode_manual STUB");
+    log("bridge_cmd_focus_mode_manual");
+
+    soap_imaging_set(SIF_FOCUS_MODE, tt__AutoFocusMode__MANUAL);
 }
 
 void bridge_cmd_focus_mode_toggle()
 {
-    log("bridge_cmd_focus_mode_toggle STUB");
+    log("bridge_cmd_focus_mode_toggle");
+
+    soap_imaging_toggle(SIF_FOCUS_MODE);
 }
 
 void bridge_cmd_focus_near()
 {
-    log("bridge_cmd_focus_near STUB");
+    log("bridge_cmd_focus_near");
+
+    soap_imaging_focus_continuous(-0.5f);
 }
 
 void bridge_cmd_focus_near_limit(uint32_t p)
@@ -487,7 +608,12 @@ void bridge_cmd_focus_near_limit(uint32_t p)
 
 void bridge_cmd_focus_near_var(uint8_t p)
 {
-    log("bridge_cmd_focus_near_var STUB");
+    /* p from 0 to 7, 0 is the slowest speed and not a stop */
+    float speed = (float)(p + 1) / 8.f;
+
+    log("bridge_cmd_focus_near_var %d", p);
+
+    soap_imaging_focus_continuous(-speed);
 }
 
 void bridge_cmd_focus_one_push_trigger()
@@ -497,7 +623,9 @@ void bridge_cmd_focus_one_push_trigger()
 
 void bridge_cmd_focus_stop()
 {
-    log("bridge_cmd_focus_stop STUB");
+    log("bridge_cmd_focus_stop");
+
+    soap_imaging_focus_stop();
 }
 
 void bridge_cmd_gamma_black_gamma_level(uint8_t p)
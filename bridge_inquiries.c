@@ -1,9 +1,27 @@
 #include "bridge_inquiries.h"
 #include "log.h"
+#include "soap_instance.h"
 #include "soap_ptz.h"
 #include "address_manager.h"
 #include "worker.h"
 
+/* visca positions are two's complement, one nibble per byte */
+static void to_retarded_integer_encoding(int value, uint8_t *out, int n)
+{
+    for (int i = 0; i < n; ++i)
+        out[i] = ((unsigned)value >> (4u * (unsigned)(n - 1 - i))) & 0x0fu;
+}
+
+static int round_to_int(float value)
+{
+    return (int)(value < 0 ? value - 0.5f : value + 0.5f);
+}
+
+static float clamp_unit(float value)
+{
+    return value < 0.f ? 0.f : value > 1.f ? 1.f : value;
+}
+
 void bridge_inq_color_bg()
 {
     log("bridge_inq_color_bg STUB");
@@ -234,11 +252,18 @@ void bridge_inq_focus_near_limit()
     log("bridge_inq_focus_near_limit STUB");
 }
 
-buffer_t* bridge_inq_focus_position()
+/* 0x1000 is infinity, 0xf000 the near end. cameras reporting focus in [0, 1] map to it */
+buffer_t* bridge_inq_focus_position(buffer_t *inquiry)
 {
+    struct soap_instance *instance = address_mngr_get_soap_instance_from_fd(g_current_event_fd);
+    buffer_t *response = buffer_zero(inquiry, 4);
+
     log("bridge_inq_focus_position");
 
-    return cons_buffer_with_value(4, 0x1);
+    to_retarded_integer_encoding(0x1000 + round_to_int(clamp_unit(instance->shadow.focus) * 0xe000),
+            response->data, 4);
+
+    return response;
 }
 
 void bridge_inq_focus_sensitivity()
@@ -336,88 +361,24 @@ void bridge_inq_pan_tilt_limit()
     log("bridge_inq_pan_tilt_limit STUB");
 }
 
-static void pan_to_retarded_integer_encoding(float degrees, int p[5])
-{
-    const float onedegree = 235.9f;
-    unsigned int value = 0;
-
-    if (degrees > 0)
-        value = degrees * onedegree + 0.5f;
-    else if (degrees < 0)
-        value = -degrees * onedegree + 0x100000 + 0.5f;
-
-    p[0] = 0;
-    p[1] = (value & 0xf000) >> 12;
-    p[2] = (value & 0x0f00) >> 8;
-    p[3] = (value & 0x00f0) >> 4;
-    p[4] = (value & 0x000f) >> 0;
-}
-
-static void tilt_to_retarded_integer_encoding(float degrees, int t[4])
+/* the generic onvif spaces map the camera's whole range to [-1, 1] for pan and tilt and to
+   [0, 1] for zoom */
+buffer_t* bridge_inq_pan_tilt_position(buffer_t *inquiry)
 {
     const float onedegree = 235.9f;
-    unsigned int value = 0;
-
-    if (degrees > 0)
-        value = degrees * onedegree + 0.5f;
-    else if (degrees < 0)
-        value = -degrees * onedegree + 0x10000 + 0.5f;
-
-    t[0] = (value & 0xf000) >> 12;
-    t[1] = (value & 0x0f00) >> 8;
-    t[2] = (value & 0x00f0) >> 4;
-    t[3] = (value & 0x000f) >> 0;
-}
-
-buffer_t* bridge_inq_pan_tilt_position()
-{
-    buffer_t *preset_response = cons_buffer(8);
     struct soap_instance *instance = address_mngr_get_soap_instance_from_fd(g_current_event_fd);
+    const struct soap_ptz_shadow *shadow = &instance->shadow;
+    buffer_t *response = buffer_zero(inquiry, 9);
 
     log("bridge_inq_pan_tilt_position");
 
-    if ((++instance->current_preset) > instance->preset_range_max)
-        instance->current_preset = instance->preset_range_min;
-
-    soap_ptz_set_preset(instance->current_preset);
-
-    preset_response->data[0] = 0x00;
-    preset_response->data[1] = 0x00;
-    preset_response->data[2] = 0x00;
-    preset_response->data[3] = 0x00;
-    preset_response->data[4] = 0x00;
-    preset_response->data[5] = 0x00;
-    preset_response->data[6] = (instance->current_preset & 0xff00) >> 8u;
-    preset_response->data[7] = instance->current_preset & 0xff;
-
-    return preset_response;
-
-#if 0
-    float pan, tilt;
-    int p[5], t[4];
-    buffer_t *response = cons_buffer(9);
-
-    log("bridge_inq_pan_tilt_position");
-
-    soap_ptz_get_position(&pan, &tilt, NULL);
-
-    log("we got pan %.2f tilt %.2f", pan, tilt);
-
-    pan_to_retarded_integer_encoding(pan * 180.f, p);
-    pan_to_retarded_integer_encoding(tilt * 180.f, t);
+    if (!shadow->valid)
+        log("bridge_inq_pan_tilt_position: no position of %s yet", instance->service_endpoint);
 
-    response->data[0] = p[0];
-    response->data[1] = p[1];
-    response->data[2] = p[2];
-    response->data[3] = p[3];
-    response->data[4] = p[4];
-    response->data[5] = t[0];
-    response->data[6] = t[1];
-    response->data[7] = t[2];
-    response->data[8] = t[3];
+    to_retarded_integer_encoding(round_to_int(shadow->pan * 180.f * onedegree), response->data, 5);
+    to_retarded_integer_encoding(round_to_int(shadow->tilt * 90.f * onedegree), response->data + 5, 4);
 
     return response;
-#endif
 }
 
 void bridge_inq_pan_tilt_ramp_curve()
@@ -510,11 +471,18 @@ void bridge_inq_tally_on()
     log("bridge_inq_tally_on STUB");
 }
 
-buffer_t* bridge_inq_zoom_position()
+/* 0x0000 is wide, 0x4000 the optical tele end */
+buffer_t* bridge_inq_zoom_position(buffer_t *inquiry)
 {
+    struct soap_instance *instance = address_mngr_get_soap_instance_from_fd(g_current_event_fd);
+    buffer_t *response = buffer_zero(inquiry, 4);
+
     log("bridge_inq_zoom_position");
 
-    return cons_buffer_with_value(4, 0x1);
+    to_retarded_integer_encoding(round_to_int(clamp_unit(instance->shadow.zoom) * 0x4000),
+            response->data, 4);
+
+    return response;
 }
 
 void bridge_inq_focus_af_mode()
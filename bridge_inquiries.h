@@ -48,7 +48,7 @@ void bridge_inq_flicker_reduction_on();
 void bridge_inq_focus_ir_correction();
 void bridge_inq_focus_mode();
 void bridge_inq_focus_near_limit();
-buffer_t* bridge_inq_focus_position();
+buffer_t* bridge_inq_focus_position(buffer_t *inquiry);
 void bridge_inq_focus_sensitivity();
 void bridge_inq_gamma_black_gamma_level();
 void bridge_inq_gamma_black_gamma_range();
@@ -68,7 +68,7 @@ void bridge_inq_menu_display_status();
 void bridge_inq_noise_reduction_manual_setting();
 void bridge_inq_noise_reduction_mode_level();
 void bridge_inq_pan_tilt_limit();
-buffer_t* bridge_inq_pan_tilt_position();
+buffer_t* bridge_inq_pan_tilt_position(buffer_t *inquiry);
 void bridge_inq_pan_tilt_ramp_curve();
 void bridge_inq_pan_tilt_slow_mode();
 void bridge_inq_pan_tilt_status();
@@ -87,7 +87,7 @@ void bridge_inq_system_ir_receive();
 void bridge_inq_system_pan_reverse();
 void bridge_inq_system_tilt_reverse();
 void bridge_inq_tally_on();
-buffer_t* bridge_inq_zoom_position();
+buffer_t* bridge_inq_zoom_position(buffer_t *inquiry);
 
 void bridge_inq_focus_af_mode();
 void bridge_inq_wb_mode();
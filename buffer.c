@@ -28,6 +28,18 @@ void free_buffer(buffer_t *buffer)
     free(buffer);
 }
 
+/* the length of buffer is the size of its storage until this sets it */
+buffer_t* buffer_zero(buffer_t *buffer, size_t length)
+{
+    if (length > buffer->length)
+        die(ERR_WRITE, "buffer_zero: %zu bytes don't fit in %zu", length, buffer->length);
+
+    memset(buffer->data, 0, length);
+    buffer->length = length;
+
+    return buffer;
+}
+
 static int print_byte(char *writebuf, uint8_t x, int base)
 {
     int len = 8, i = 0;
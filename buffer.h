@@ -9,9 +9,13 @@ typedef struct
     uint8_t *data;
 } buffer_t;
 
+/* initializer of a buffer over an array the caller owns, usually one on its stack */
+#define BUFFER_OF(A) { sizeof(A), (A) }
+
 buffer_t* cons_buffer(size_t length);
 buffer_t* cons_buffer_with_value(size_t length, uint8_t value);
 void free_buffer(buffer_t *buffer);
+buffer_t* buffer_zero(buffer_t *buffer, size_t length);
 void print_buffer_msg(const char *msg, const buffer_t *buffer, int base);
 void print_buffer(const buffer_t *buffer, int base);
 
@@ -0,0 +1,643 @@
+#include "camera_cache.h"
+#include "errors.h"
+#include "log.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CAMERA_CACHE_MAX_FILENAME_LEN 512
+#define CAMERA_CACHE_NULL_STRING 0xffffu
+/* a string the blob already holds, followed by the 32 bit offset of its first copy */
+#define CAMERA_CACHE_SEEN_STRING 0xfffeu
+
+/* the file is the magic, the version, the number of entries and then every entry as its
+   length and blob. a blob holds the endpoint, the serial number, the services and the
+   profiles. integers are in host byte order, strings are a 16 bit length, the bytes and a
+   terminating nul, so the deserialized structures can point right into the blob. a string
+   that repeats, like the space uris every profile of a camera shares, is stored once and
+   referenced after that */
+struct cache_entry
+{
+    char *endpoint;
+    uint8_t *blob;
+    size_t blob_len;
+    struct cache_entry *next;
+};
+
+struct writer
+{
+    uint8_t *data;
+    size_t len, cap;
+    /* offsets of the strings written so far */
+    uint32_t *strings;
+    int string_count, string_cap;
+};
+
+struct reader
+{
+    uint8_t *start, *it, *end;
+    int error;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct cache_entry *entries;
+
+static void put(struct writer *w, const void *data, size_t len)
+{
+    size_t new_cap = w->cap ? w->cap : 512;
+    uint8_t *new_data;
+
+    if (w->len + len > w->cap) {
+        while (new_cap < w->len + len)
+            new_cap *= 2;
+
+        new_data = realloc(w->data, new_cap);
+        if (new_data == NULL)
+            die(ERR_NOMEM, "failed to realloc(%zd)", new_cap);
+
+        w->data = new_data;
+        w->cap = new_cap;
+    }
+
+    memcpy(w->data + w->len, data, len);
+    w->len += len;
+}
+
+static void put_u8(struct writer *w, uint8_t value)
+{
+    put(w, &value, sizeof(value));
+}
+
+static void put_u16(struct writer *w, uint16_t value)
+{
+    put(w, &value, sizeof(value));
+}
+
+static void put_u32(struct writer *w, uint32_t value)
+{
+    put(w, &value, sizeof(value));
+}
+
+static void put_f32(struct writer *w, float value)
+{
+    put(w, &value, sizeof(value));
+}
+
+/* returns the offset of an earlier copy of str, 0 if there is none. no string starts at 0 */
+static uint32_t find_str(const struct writer *w, const char *str, size_t len)
+{
+    const char *seen;
+
+    for (int i = 0; i < w->string_count; ++i) {
+        seen = (const char*)w->data + w->strings[i];
+        if (strncmp(seen, str, len) == 0 && seen[len] == '\0')
+            return w->strings[i];
+    }
+
+    return 0;
+}
+
+static void remember_str(struct writer *w, uint32_t offset)
+{
+    int new_cap = w->string_cap ? w->string_cap * 2 : 32;
+    uint32_t *new_strings;
+
+    if (w->string_count == w->string_cap) {
+        new_strings = realloc(w->strings, new_cap * sizeof(uint32_t));
+        if (new_strings == NULL)
+            die(ERR_NOMEM, "failed to realloc(%zd)", new_cap * sizeof(uint32_t));
+
+        w->strings = new_strings;
+        w->string_cap = new_cap;
+    }
+
+    w->strings[w->string_count++] = offset;
+}
+
+static void put_str(struct writer *w, const char *str)
+{
+    uint32_t seen;
+    size_t len;
+
+    if (str == NULL) {
+        put_u16(w, CAMERA_CACHE_NULL_STRING);
+        return;
+    }
+
+    len = strlen(str);
+    if (len >= CAMERA_CACHE_SEEN_STRING)
+        len = CAMERA_CACHE_SEEN_STRING - 1;
+
+    /* a reference only pays off for strings longer than it */
+    if (len > sizeof(uint32_t) && (seen = find_str(w, str, len)) != 0) {
+        put_u16(w, CAMERA_CACHE_SEEN_STRING);
+        put_u32(w, seen);
+        return;
+    }
+
+    put_u16(w, (uint16_t)len);
+    remember_str(w, (uint32_t)w->len);
+    put(w, str, len);
+    put_u8(w, 0);
+}
+
+static void* get(struct reader *r, size_t len)
+{
+    void *data = r->it;
+
+    if (r->error || (size_t)(r->end - r->it) < len) {
+        r->error = 1;
+        return NULL;
+    }
+
+    r->it += len;
+
+    return data;
+}
+
+static uint8_t get_u8(struct reader *r)
+{
+    uint8_t *data = get(r, sizeof(uint8_t));
+
+    return data ? *data : 0;
+}
+
+static uint16_t get_u16(struct reader *r)
+{
+    uint16_t value = 0;
+    void *data = get(r, sizeof(value));
+
+    if (data)
+        memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+static uint32_t get_u32(struct reader *r)
+{
+    uint32_t value = 0;
+    void *data = get(r, sizeof(value));
+
+    if (data)
+        memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+static float get_f32(struct reader *r)
+{
+    float value = 0;
+    void *data = get(r, sizeof(value));
+
+    if (data)
+        memcpy(&value, data, sizeof(value));
+
+    return value;
+}
+
+/* a reference must point back at a string that ends before it */
+static char* get_seen_str(struct reader *r)
+{
+    uint32_t offset = get_u32(r);
+    char *str = (char*)r->start + offset;
+
+    if (r->error || offset == 0 || str >= (char*)r->it
+            || memchr(str, '\0', (char*)r->it - str) == NULL) {
+        r->error = 1;
+        return NULL;
+    }
+
+    return str;
+}
+
+static char* get_str(struct reader *r)
+{
+    uint16_t len = get_u16(r);
+    char *str;
+
+    if (len == CAMERA_CACHE_NULL_STRING)
+        return NULL;
+
+    if (len == CAMERA_CACHE_SEEN_STRING)
+        return get_seen_str(r);
+
+    str = get(r, (size_t)len + 1);
+    if (str != NULL && str[len] != '\0')
+        r->error = 1;
+
+    return r->error ? NULL : str;
+}
+
+static void* xcalloc(size_t count, size_t size)
+{
+    void *data = calloc(count ? count : 1, size);
+    if (data == NULL)
+        die(ERR_NOMEM, "failed to calloc(%zd)", count * size);
+
+    return data;
+}
+
+static void put_ptz_configuration(struct writer *w, const struct tt__PTZConfiguration *ptz)
+{
+    const struct tt__PTZSpeed *speed = ptz->DefaultPTZSpeed;
+
+    put_str(w, ptz->token);
+    put_str(w, ptz->NodeToken);
+    put_str(w, ptz->DefaultAbsolutePantTiltPositionSpace);
+    put_str(w, ptz->DefaultAbsoluteZoomPositionSpace);
+    put_str(w, ptz->DefaultRelativePanTiltTranslationSpace);
+    put_str(w, ptz->DefaultRelativeZoomTranslationSpace);
+    put_str(w, ptz->DefaultContinuousPanTiltVelocitySpace);
+    put_str(w, ptz->DefaultContinuousZoomVelocitySpace);
+
+    put_u8(w, speed != NULL && speed->PanTilt != NULL);
+    if (speed != NULL && speed->PanTilt != NULL) {
+        put_f32(w, speed->PanTilt->x);
+        put_f32(w, speed->PanTilt->y);
+        put_str(w, speed->PanTilt->space);
+    }
+
+    put_u8(w, speed != NULL && speed->Zoom != NULL);
+    if (speed != NULL && speed->Zoom != NULL) {
+        put_f32(w, speed->Zoom->x);
+        put_str(w, speed->Zoom->space);
+    }
+}
+
+static struct tt__PTZConfiguration* get_ptz_configuration(struct reader *r)
+{
+    struct tt__PTZConfiguration *ptz = xcalloc(1, sizeof(struct tt__PTZConfiguration));
+    struct tt__PTZSpeed *speed = xcalloc(1, sizeof(struct tt__PTZSpeed));
+
+    ptz->token = get_str(r);
+    ptz->NodeToken = get_str(r);
+    ptz->DefaultAbsolutePantTiltPositionSpace = get_str(r);
+    ptz->DefaultAbsoluteZoomPositionSpace = get_str(r);
+    ptz->DefaultRelativePanTiltTranslationSpace = get_str(r);
+    ptz->DefaultRelativeZoomTranslationSpace = get_str(r);
+    ptz->DefaultContinuousPanTiltVelocitySpace = get_str(r);
+    ptz->DefaultContinuousZoomVelocitySpace = get_str(r);
+    ptz->DefaultPTZSpeed = speed;
+
+    if (get_u8(r)) {
+        speed->PanTilt = xcalloc(1, sizeof(struct tt__Vector2D));
+        speed->PanTilt->x = get_f32(r);
+        speed->PanTilt->y = get_f32(r);
+        speed->PanTilt->space = get_str(r);
+    }
+
+    if (get_u8(r)) {
+        speed->Zoom = xcalloc(1, sizeof(struct tt__Vector1D));
+        speed->Zoom->x = get_f32(r);
+        speed->Zoom->space = get_str(r);
+    }
+
+    return ptz;
+}
+
+static void free_profiles(profiles_t *profiles)
+{
+    struct tt__PTZConfiguration *ptz;
+
+    if (profiles == NULL)
+        return;
+
+    for (int i = 0; i < profiles->__sizeProfiles; ++i) {
+        free(profiles->Profiles[i].VideoSourceConfiguration);
+
+        ptz = profiles->Profiles[i].PTZConfiguration;
+        if (ptz == NULL)
+            continue;
+
+        free(ptz->DefaultPTZSpeed->PanTilt);
+        free(ptz->DefaultPTZSpeed->Zoom);
+        free(ptz->DefaultPTZSpeed);
+        free(ptz);
+    }
+
+    free(profiles->Profiles);
+    free(profiles);
+}
+
+static void free_services(services_t *services)
+{
+    if (services == NULL)
+        return;
+
+    free(services->Service);
+    free(services);
+}
+
+void camera_caps_free(struct camera_caps *caps)
+{
+    if (caps == NULL)
+        return;
+
+    free_services(caps->services);
+    free_profiles(caps->profiles);
+    free(caps->blob);
+    free(caps);
+}
+
+/* takes over blob, returns NULL if it is malformed */
+static struct camera_caps* caps_from_blob(uint8_t *blob, size_t blob_len)
+{
+    struct camera_caps *caps = xcalloc(1, sizeof(struct camera_caps));
+    struct reader r = { blob, blob, blob + blob_len, 0 };
+    struct tt__Profile *profile;
+    int count;
+
+    caps->blob = blob;
+    caps->blob_len = blob_len;
+
+    get_str(&r);
+    get_str(&r);
+
+    caps->services = xcalloc(1, sizeof(services_t));
+    count = get_u16(&r);
+    caps->services->Service = xcalloc(count, sizeof(struct tds__Service));
+    caps->services->__sizeService = count;
+
+    for (int i = 0; i < count && !r.error; ++i) {
+        caps->services->Service[i].Namespace = get_str(&r);
+        caps->services->Service[i].XAddr = get_str(&r);
+    }
+
+    caps->profiles = xcalloc(1, sizeof(profiles_t));
+    count = get_u16(&r);
+    caps->profiles->Profiles = xcalloc(count, sizeof(struct tt__Profile));
+    caps->profiles->__sizeProfiles = count;
+
+    for (int i = 0; i < count && !r.error; ++i) {
+        profile = &caps->profiles->Profiles[i];
+        profile->Name = get_str(&r);
+        profile->token = get_str(&r);
+        if (get_u8(&r)) {
+            profile->VideoSourceConfiguration = xcalloc(1,
+                    sizeof(struct tt__VideoSourceConfiguration));
+            profile->VideoSourceConfiguration->SourceToken = get_str(&r);
+        }
+        if (get_u8(&r))
+            profile->PTZConfiguration = get_ptz_configuration(&r);
+    }
+
+    if (r.error || r.it != r.end || caps->services->__sizeService == 0
+            || caps->profiles->__sizeProfiles == 0) {
+        camera_caps_free(caps);
+        return NULL;
+    }
+
+    return caps;
+}
+
+struct camera_caps* camera_caps_from_soap(const char *endpoint, const char *serial,
+        const services_t *services, const profiles_t *profiles)
+{
+    struct writer w = { 0 };
+    const struct tt__Profile *profile;
+
+    put_str(&w, endpoint);
+    put_str(&w, serial);
+
+    put_u16(&w, (uint16_t)services->__sizeService);
+    for (int i = 0; i < services->__sizeService; ++i) {
+        put_str(&w, services->Service[i].Namespace);
+        put_str(&w, services->Service[i].XAddr);
+    }
+
+    put_u16(&w, (uint16_t)profiles->__sizeProfiles);
+    for (int i = 0; i < profiles->__sizeProfiles; ++i) {
+        profile = &profiles->Profiles[i];
+
+        put_str(&w, profile->Name);
+        put_str(&w, profile->token);
+
+        put_u8(&w, profile->VideoSourceConfiguration != NULL);
+        if (profile->VideoSourceConfiguration != NULL)
+            put_str(&w, profile->VideoSourceConfiguration->SourceToken);
+
+        put_u8(&w, profile->PTZConfiguration != NULL);
+        if (profile->PTZConfiguration != NULL)
+            put_ptz_configuration(&w, profile->PTZConfiguration);
+    }
+
+    free(w.strings);
+
+    return caps_from_blob(w.data, w.len);
+}
+
+/* equal blobs mean equal endpoint, serial number and capabilities */
+int camera_caps_equal(const struct camera_caps *a, const struct camera_caps *b)
+{
+    return a->blob_len == b->blob_len && memcmp(a->blob, b->blob, a->blob_len) == 0;
+}
+
+static char* get_filename(int create_dirs)
+{
+    char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+    char *home = getenv("HOME");
+    char *filename = malloc(CAMERA_CACHE_MAX_FILENAME_LEN);
+    int len;
+
+    if (filename == NULL)
+        die(ERR_ALLOC, "failed to allocate string buffer");
+
+    if (xdg_cache_home)
+        len = snprintf(filename, CAMERA_CACHE_MAX_FILENAME_LEN, "%s", xdg_cache_home);
+    else if (home)
+        len = snprintf(filename, CAMERA_CACHE_MAX_FILENAME_LEN, "%s/.cache", home);
+    else {
+        free(filename);
+        return NULL;
+    }
+
+    if (create_dirs)
+        mkdir(filename, 0700);
+
+    len += snprintf(filename + len, CAMERA_CACHE_MAX_FILENAME_LEN - len, "/" CAMERA_CACHE_DIR_NAME);
+
+    if (create_dirs)
+        mkdir(filename, 0700);
+
+    snprintf(filename + len, CAMERA_CACHE_MAX_FILENAME_LEN - len, "/" CAMERA_CACHE_FILE_NAME);
+
+    return filename;
+}
+
+static void add_entry(uint8_t *blob, size_t blob_len)
+{
+    struct reader r = { blob, blob, blob + blob_len, 0 };
+    struct cache_entry *entry;
+    char *endpoint = get_str(&r);
+
+    if (endpoint == NULL) {
+        free(blob);
+        return;
+    }
+
+    entry = xcalloc(1, sizeof(struct cache_entry));
+    entry->endpoint = endpoint;
+    entry->blob = blob;
+    entry->blob_len = blob_len;
+    entry->next = entries;
+    entries = entry;
+}
+
+/* a missing, foreign or damaged file just means an empty cache */
+void camera_cache_load()
+{
+    char *filename = get_filename(0), magic[4];
+    uint32_t version, count, blob_len;
+    uint8_t *blob;
+    FILE *f;
+
+    if (filename == NULL)
+        return;
+
+    f = fopen(filename, "rb");
+    if (f == NULL) {
+        free(filename);
+        return;
+    }
+
+    if (fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, CAMERA_CACHE_MAGIC, 4) != 0
+            || fread(&version, sizeof(version), 1, f) != 1 || version != CAMERA_CACHE_VERSION
+            || fread(&count, sizeof(count), 1, f) != 1) {
+        log("camera_cache: ignoring %s, unknown format", filename);
+        count = 0;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (fread(&blob_len, sizeof(blob_len), 1, f) != 1 || blob_len > 1u << 20u)
+            break;
+
+        blob = malloc(blob_len ? blob_len : 1);
+        if (blob == NULL)
+            die(ERR_NOMEM, "failed to malloc(%u)", blob_len);
+
+        if (fread(blob, blob_len, 1, f) != 1) {
+            free(blob);
+            break;
+        }
+
+        add_entry(blob, blob_len);
+    }
+
+    log("camera_cache: loaded %s", filename);
+
+    fclose(f);
+    free(filename);
+}
+
+/* returns the cached capabilities of the camera or NULL */
+struct camera_caps* camera_cache_find(const char *endpoint)
+{
+    struct camera_caps *caps = NULL;
+    struct cache_entry *it;
+    uint8_t *blob;
+
+    pthread_mutex_lock(&lock);
+
+    for (it = entries; it != NULL; it = it->next) {
+        if (strcmp(it->endpoint, endpoint) != 0)
+            continue;
+
+        blob = malloc(it->blob_len);
+        if (blob == NULL)
+            die(ERR_NOMEM, "failed to malloc(%zd)", it->blob_len);
+
+        memcpy(blob, it->blob, it->blob_len);
+        caps = caps_from_blob(blob, it->blob_len);
+        break;
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return caps;
+}
+
+/* the file is rewritten as a whole and renamed into place, readers never see half of it */
+static void save()
+{
+    char *filename = get_filename(1), tmp_filename[CAMERA_CACHE_MAX_FILENAME_LEN + 8];
+    uint32_t version = CAMERA_CACHE_VERSION, count = 0, blob_len;
+    struct cache_entry *it;
+    FILE *f;
+    int ok;
+
+    if (filename == NULL)
+        return;
+
+    snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", filename);
+
+    f = fopen(tmp_filename, "wb");
+    if (f == NULL) {
+        log("camera_cache: failed to open %s: %s", tmp_filename, strerror(errno));
+        free(filename);
+        return;
+    }
+
+    for (it = entries; it != NULL; it = it->next)
+        ++count;
+
+    ok = fwrite(CAMERA_CACHE_MAGIC, 4, 1, f) == 1 && fwrite(&version, sizeof(version), 1, f) == 1
+        && fwrite(&count, sizeof(count), 1, f) == 1;
+
+    for (it = entries; it != NULL && ok; it = it->next) {
+        blob_len = (uint32_t)it->blob_len;
+        ok = fwrite(&blob_len, sizeof(blob_len), 1, f) == 1 && fwrite(it->blob, it->blob_len, 1, f) == 1;
+    }
+
+    if (fclose(f) != 0 || !ok || rename(tmp_filename, filename) == -1) {
+        log("camera_cache: failed to write %s", filename);
+        unlink(tmp_filename);
+    }
+
+    free(filename);
+}
+
+void camera_cache_store(const struct camera_caps *caps)
+{
+    struct cache_entry **it;
+    struct cache_entry *old;
+    uint8_t *blob = malloc(caps->blob_len);
+
+    if (blob == NULL)
+        die(ERR_NOMEM, "failed to malloc(%zd)", caps->blob_len);
+
+    memcpy(blob, caps->blob, caps->blob_len);
+
+    pthread_mutex_lock(&lock);
+
+    add_entry(blob, caps->blob_len);
+
+    for (it = &entries->next; *it != NULL; it = &(*it)->next) {
+        if (strcmp((*it)->endpoint, entries->endpoint) != 0)
+            continue;
+
+        old = *it;
+        *it = old->next;
+        free(old->blob);
+        free(old);
+        break;
+    }
+
+    save();
+
+    pthread_mutex_unlock(&lock);
+}
+
+void camera_cache_destruct()
+{
+    struct cache_entry *next;
+
+    while (entries != NULL) {
+        next = entries->next;
+        free(entries->blob);
+        free(entries);
+        entries = next;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "soap_header.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define CAMERA_CACHE_MAGIC "VPXC"
+#define CAMERA_CACHE_VERSION 3
+#define CAMERA_CACHE_DIR_NAME "voproxyd"
+#define CAMERA_CACHE_FILE_NAME "cameras"
+
+/* what the bootstrap learns about a camera, reduced to the fields the proxy uses. blob is
+   its serialized form, the strings of services and profiles point into it */
+struct camera_caps
+{
+    services_t *services;
+    profiles_t *profiles;
+    uint8_t *blob;
+    size_t blob_len;
+};
+
+struct camera_caps* camera_caps_from_soap(const char *endpoint, const char *serial,
+        const services_t *services, const profiles_t *profiles);
+int camera_caps_equal(const struct camera_caps *a, const struct camera_caps *b);
+void camera_caps_free(struct camera_caps *caps);
+
+void camera_cache_load();
+struct camera_caps* camera_cache_find(const char *endpoint);
+void camera_cache_store(const struct camera_caps *caps);
+void camera_cache_destruct();
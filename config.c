@@ -101,6 +101,7 @@ static void write_to_xdg_file()
         "\n"
         "# [192.168.1.2]\n"
         "# profile_idx = 0\n"
+        "# auth = wsse # or none for cameras without credentials\n"
         "\n";
 
     f = fopen(filename, "w+");
@@ -208,6 +209,7 @@ static int ini_cb(void *user, const char *section, const char *name, const char
 #define streq(X, Y) (strcmp((X), (Y)) == 0)
 
     struct soap_instance *instance;
+    int mode;
 
     if (streq(section, "ports"))
         address_mngr_add_address_by_port(atoi(value), name);
@@ -220,11 +222,13 @@ static int ini_cb(void *user, const char *section, const char *name, const char
 
         if (streq(name, "profile_idx"))
             instance->profile_idx = atoi(value);
-        else if (streq(name, "preset_range_min"))
-            instance->preset_range_min = atoi(value);
-        else if (streq(name, "preset_range_max"))
-            instance->preset_range_max = atoi(value);
-        else
+        else if (streq(name, "auth")) {
+            mode = soap_auth_parse_mode(value);
+            if (mode == -1)
+                die(ERR_CONFIG, "config file %s:%d: auth must be \"wsse\" or \"none\"",
+                        (char*)user, line);
+            soap_instance_set_auth_mode(instance, mode);
+        } else
             log("config file %s:%d warning: unknown option \"%s\"", (char*)user, line, name);
     } else { /* no section */
         if (streq(name, "username"))
@@ -4,6 +4,7 @@
 #include "errors.h"
 #include "log.h"
 #include "socket.h"
+#include "udp_outbox.h"
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -11,85 +12,184 @@
 #include <sys/epoll.h>
 #include <unistd.h>
 
-static struct event_t* mk_event_t()
+static struct event_t* slab_slot(struct event_slab *slab, int fd)
 {
-    struct event_t *event = calloc(1, sizeof(struct event_t));
+    size_t chunk = (size_t)fd / EVENT_SLAB_CHUNK, new_count;
+    struct event_t **chunks;
 
-    if (!event) {
-        die(ERR_NOMEM, "failed to calloc(%zd)", sizeof(struct event_t));
+    if (chunk >= slab->chunks_count) {
+        new_count = chunk + 1;
+
+        chunks = realloc(slab->chunks, new_count * sizeof(struct event_t*));
+        if (chunks == NULL)
+            die(ERR_NOMEM, "failed to realloc(%zd)", new_count * sizeof(struct event_t*));
+
+        memset(chunks + slab->chunks_count, 0,
+                (new_count - slab->chunks_count) * sizeof(struct event_t*));
+
+        slab->chunks = chunks;
+        slab->chunks_count = new_count;
     }
 
-    return event;
+    if (slab->chunks[chunk] == NULL) {
+        slab->chunks[chunk] = aligned_alloc(EVENT_CACHE_LINE,
+                EVENT_SLAB_CHUNK * sizeof(struct event_t));
+        if (slab->chunks[chunk] == NULL)
+            die(ERR_NOMEM, "failed to aligned_alloc(%zd)", EVENT_SLAB_CHUNK * sizeof(struct event_t));
+
+        for (int i = 0; i < EVENT_SLAB_CHUNK; ++i) {
+            slab->chunks[chunk][i].fd = -1;
+            slab->chunks[chunk][i].generation = 0;
+        }
+    }
+
+    return &slab->chunks[chunk][(size_t)fd % EVENT_SLAB_CHUNK];
+}
+
+static void release_event(struct event_t *event)
+{
+    free(event->command_output);
+    event->command_output = NULL;
+
+    udp_outbox_destroy(event->outbox);
+    event->outbox = NULL;
+    event->fd = -1;
 }
 
-static void ll_free_entitiy(struct tracking_ll_t *node)
+static int is_ready(struct ap_state *state, struct event_t *event)
 {
-    free(node->event);
-    free(node);
+    return event->next_ready != NULL || state->ready_tail == event;
 }
 
-void ll_free_list(struct tracking_ll_t **head)
+static void unlink_ready(struct ap_state *state, struct event_t *event)
 {
-    struct tracking_ll_t *it = *head;
+    struct event_t **it = &state->ready_head, *prev = NULL;
 
-    while (it) {
-        it = it->next;
-        ll_free_entitiy(*head);
-        *head = it;
+    if (!is_ready(state, event))
+        return;
+
+    while (*it != event) {
+        prev = *it;
+        it = &(*it)->next_ready;
     }
+
+    *it = event->next_ready;
+    if (state->ready_tail == event)
+        state->ready_tail = prev;
+
+    event->next_ready = NULL;
+    --state->ready_count;
 }
 
-static void ll_push_event(struct tracking_ll_t **head, struct event_t *event)
+void epoll_push_ready(struct ap_state *state, struct event_t *event)
 {
-    struct tracking_ll_t *new_node = malloc(sizeof(struct tracking_ll_t));
-    if (!new_node) {
-        die(ERR_NOMEM, "failed to malloc(%zd)", sizeof(struct tracking_ll_t));
-    }
+    if (is_ready(state, event))
+        return;
+
+    if (state->ready_tail == NULL)
+        state->ready_head = event;
+    else
+        state->ready_tail->next_ready = event;
 
-    new_node->event = event;
-    new_node->next = *head;
-    *head = new_node;
+    state->ready_tail = event;
+    ++state->ready_count;
 }
 
-void ll_delete_node(struct tracking_ll_t **head, struct tracking_ll_t *node)
+struct event_t* epoll_pop_ready(struct ap_state *state)
 {
-    while (*head != node) {
-        head = &(*head)->next;
-    }
+    struct event_t *event = state->ready_head;
 
-    if (*head == NULL) {
-        log("ll_delete_node: can't find node");
-        return;
+    if (event == NULL)
+        return NULL;
+
+    state->ready_head = event->next_ready;
+    if (state->ready_head == NULL)
+        state->ready_tail = NULL;
+
+    event->next_ready = NULL;
+    --state->ready_count;
+
+    return event;
+}
+
+struct event_t* epoll_find_event(struct ap_state *state, int fd)
+{
+    struct event_slab *slab = &state->events;
+    size_t chunk = (size_t)fd / EVENT_SLAB_CHUNK;
+    struct event_t *event;
+
+    if (fd < 0 || chunk >= slab->chunks_count || slab->chunks[chunk] == NULL)
+        return NULL;
+
+    event = &slab->chunks[chunk][(size_t)fd % EVENT_SLAB_CHUNK];
+
+    return event->fd == fd ? event : NULL;
+}
+
+void epoll_free_events(struct ap_state *state)
+{
+    struct event_slab *slab = &state->events;
+
+    for (size_t chunk = 0; chunk < slab->chunks_count; ++chunk) {
+        if (slab->chunks[chunk] == NULL)
+            continue;
+
+        for (int i = 0; i < EVENT_SLAB_CHUNK; ++i)
+            if (slab->chunks[chunk][i].fd != -1)
+                release_event(&slab->chunks[chunk][i]);
+
+        free(slab->chunks[chunk]);
     }
 
-    *head = node->next;
+    free(slab->chunks);
 
-    ll_free_entitiy(node);
+    slab->chunks = NULL;
+    slab->chunks_count = 0;
 }
 
-void epoll_add_fd(struct ap_state *state, int fd, int type, int in)
+struct event_t* epoll_add_fd(struct ap_state *state, int fd, int type, int in)
 {
-    struct event_t *event = mk_event_t();
+    struct event_t *event = slab_slot(&state->events, fd);
     struct epoll_event ep_event = { 0 };
+    uint16_t generation;
+
+    /* a closed fd leaves the epoll set on its own, its number may come back before the
+       record was released */
+    if (event->fd != -1) {
+        log("epoll_add_fd: reusing stale record of fd = %d", fd);
+        release_event(event);
+    }
+
+    generation = event->generation + 1;
+
+    memset(event, 0, sizeof(struct event_t));
 
     event->fd = fd;
+    event->generation = generation;
     event->type = type;
     event->addr = NULL;
 
     ep_event.events = (unsigned)(in ? EPOLLIN : EPOLLOUT) | (unsigned)EPOLLRDHUP | EPOLLET;
     ep_event.data.ptr = event;
 
-    log("add fd = %d to epoll set", fd);
+#ifdef VOPROXYD_URING
+    /* camera sockets are read by the ring, see uring.c */
+    if (type == FDT_UDP) {
+        log("add fd = %d to io_uring", fd);
+        uring_arm_recv(state, event);
+        return event;
+    }
+#endif
 
-    ll_push_event(&state->tracked_events, event);
+    log("add fd = %d to epoll set", fd);
 
     if (epoll_ctl(state->epoll_fd, EPOLL_CTL_ADD, event->fd, &ep_event) != -1) {
-        return;
+        return event;
     }
 
     if (errno == EEXIST) {
         log("epoll_add_fd: fd fd = %d already exists", fd);
-        return;
+        return event;
     }
 
     close(state->epoll_fd);
@@ -97,15 +197,69 @@ void epoll_add_fd(struct ap_state *state, int fd, int type, int in)
     die(ERR_EPOLL_CTL, "error adding fd = %d to epoll: %s", fd, strerror(errno));
 }
 
+static void mod_events(struct ap_state *state, struct event_t *event, uint32_t events)
+{
+    struct epoll_event ep_event = { 0 };
+
+    ep_event.events = events | (unsigned)EPOLLRDHUP | EPOLLET;
+    ep_event.data.ptr = event;
+
+    if (epoll_ctl(state->epoll_fd, EPOLL_CTL_MOD, event->fd, &ep_event) == -1) {
+        close(state->epoll_fd);
+        die(ERR_EPOLL_CTL, "error modifying fd = %d in epoll: %s", event->fd, strerror(errno));
+    }
+}
+
+void epoll_mod_fd(struct ap_state *state, struct event_t *event, int in)
+{
+    mod_events(state, event, in ? EPOLLIN : EPOLLOUT);
+}
+
+/* keeps reading and additionally waits for the fd to become writable */
+void epoll_want_write(struct ap_state *state, struct event_t *event, int want)
+{
+    mod_events(state, event, want ? (unsigned)EPOLLIN | (unsigned)EPOLLOUT : EPOLLIN);
+}
+
+/* unlike epoll_close_fd() this leaves the fd open: the owner of the fd closes it. an fd that
+   its owner already closed has left the epoll set on its own */
+void epoll_remove_event(struct ap_state *state, struct event_t *event)
+{
+    if (epoll_ctl(state->epoll_fd, EPOLL_CTL_DEL, event->fd, NULL) == -1
+            && errno != EBADF && errno != ENOENT) {
+        close(state->epoll_fd);
+        die(ERR_EPOLL_CTL, "error removing fd = %d from epoll: %s", event->fd, strerror(errno));
+    }
+
+    log("del fd = %d from epoll set", event->fd);
+
+    unlink_ready(state, event);
+    release_event(event);
+}
+
 void epoll_close_fd(struct ap_state *state, int fd)
 {
+    struct event_t *event;
+
+#ifdef VOPROXYD_URING
+    uring_cancel_fd(state, fd);
+
+    if (epoll_ctl(state->epoll_fd, EPOLL_CTL_DEL, fd, NULL) == -1 && errno != ENOENT) {
+#else
     if (epoll_ctl(state->epoll_fd, EPOLL_CTL_DEL, fd, NULL) == -1) {
+#endif
         close(state->epoll_fd);
         die(ERR_EPOLL_CTL, "error removing fd = %d from epoll: %s", fd, strerror(errno));
     }
 
     log("del fd = %d from epoll set", fd);
 
+    event = epoll_find_event(state, fd);
+    if (event != NULL) {
+        unlink_ready(state, event);
+        release_event(event);
+    }
+
     close(fd);
 }
 
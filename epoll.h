@@ -1,9 +1,12 @@
 #pragma once
 
 #include "buffer.h"
+#include "uring.h"
 #include <netdb.h>
 #include <sys/epoll.h>
 
+struct udp_outbox;
+
 enum fd_type
 {
     FDT_TCP_LISTEN = 0,
@@ -12,24 +15,38 @@ enum fd_type
     FDT_SIGNAL,
     FDT_INOTIFY,
     FDT_PIPE,
-    FDT_TIMER,
+    FDT_SOAP,
+    FDT_EVENTFD,
+    FDT_WAKE,
+    FDT_URING,
 };
 
+#define EVENT_CACHE_LINE 64
+#define EVENT_SLAB_CHUNK 64
+
+/* one cache line per fd, fd is -1 while the record is free. generation counts the sockets
+   the record served, so a late io_uring completion is told from one of the current socket */
 struct event_t
 {
-    int fd;
-    int type;
+    _Alignas(EVENT_CACHE_LINE) int fd;
+    uint16_t type;
+    uint16_t generation;
     struct sockaddr *addr;
     socklen_t addr_len;
     int child_pid;
     char *command_output;
     size_t command_output_len;
+    void *data;
+    struct udp_outbox *outbox;
+    struct event_t *next_ready;
 };
 
-struct tracking_ll_t
+/* event records indexed by fd. records live in fixed chunks that are never moved, so
+   pointers to them stay valid and a closed fd's record is reused by the next fd */
+struct event_slab
 {
-    struct event_t *event;
-    struct tracking_ll_t *next;
+    struct event_t **chunks;
+    size_t chunks_count;
 };
 
 struct ap_state
@@ -38,12 +55,23 @@ struct ap_state
     int close_after_read;
     int current;
     struct event_t *current_event;
-    struct tracking_ll_t *tracked_events;
+    struct event_slab events;
+    /* sockets that used up their read budget with data left, served round robin */
+    struct event_t *ready_head, *ready_tail;
+    size_t ready_count;
+#ifdef VOPROXYD_URING
+    struct uring_t uring;
+#endif
 };
 
-void epoll_add_fd(struct ap_state *state, int fd, int type, int in);
+struct event_t* epoll_add_fd(struct ap_state *state, int fd, int type, int in);
+void epoll_mod_fd(struct ap_state *state, struct event_t *event, int in);
+void epoll_want_write(struct ap_state *state, struct event_t *event, int want);
+void epoll_remove_event(struct ap_state *state, struct event_t *event);
 void epoll_close_fd(struct ap_state *state, int fd);
 void epoll_handle_event_errors(struct ap_state *state, const struct epoll_event *event);
-void ll_free_list(struct tracking_ll_t **head);
-void ll_delete_node(struct tracking_ll_t **head, struct tracking_ll_t *node);
+struct event_t* epoll_find_event(struct ap_state *state, int fd);
+void epoll_push_ready(struct ap_state *state, struct event_t *event);
+struct event_t* epoll_pop_ready(struct ap_state *state);
+void epoll_free_events(struct ap_state *state);
 
@@ -37,5 +37,7 @@ enum {
     ERR_INOTIFY        = 33,
     ERR_CONFIG         = 34,
     ERR_TIMER          = 35,
+    ERR_THREAD         = 36,
+    ERR_URING          = 37,
 };
 
@@ -5,8 +5,11 @@
 #include "log.h"
 #include "worker.h"
 #include "soap_global.h"
+#include "soap_thread.h"
 #include "soap_utils.h"
 #include "address_manager.h"
+#include "bootstrap.h"
+#include "visca_decode.h"
 
 #include <assert.h>
 #include <getopt.h>
@@ -18,12 +21,15 @@
 int g_daemonize = 0;
 FILE *g_log_output_file;
 int g_timestamps = 0;
+int g_soap_threads = 0;
+int g_shards = 1;
+int g_bootstrap_jobs = 8;
 
 static void usage(const char *progname)
 {
     assert(progname != NULL);
-    printf("Usage: %s [-h,--help] [-d,--daemonize] [-l,--log=<filename>] [-t,--timestamps]\n",
-            progname);
+    printf("Usage: %s [-h,--help] [-d,--daemonize] [-l,--log=<filename>] [-t,--timestamps]\n"
+           "       [-T,--soap-threads] [-s,--shards=<n>] [-b,--bootstrap-jobs=<n>]\n", progname);
 }
 
 static void parse_daemonize()
@@ -47,15 +53,18 @@ static void parse_daemonize()
 static void parse_arguments(int argc, char *argv[])
 {
     struct option const long_options[] = {
-        { "daemonize",  optional_argument, NULL, 'd' },
-        { "help",       no_argument,       NULL, 'h' },
-        { "log",        required_argument, NULL, 'l' },
-        { "timestamps", no_argument,       NULL, 't' },
-        { 0,            0,                 0,    0   }
+        { "daemonize",      optional_argument, NULL, 'd' },
+        { "help",           no_argument,       NULL, 'h' },
+        { "log",            required_argument, NULL, 'l' },
+        { "timestamps",     no_argument,       NULL, 't' },
+        { "soap-threads",   no_argument,       NULL, 'T' },
+        { "shards",         required_argument, NULL, 's' },
+        { "bootstrap-jobs", required_argument, NULL, 'b' },
+        { 0,                0,                 0,    0   }
     };
     int opt = 0, option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "d::hl:t", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "d::hl:tTs:b:", long_options, &option_index)) != -1) {
         switch (opt) {
         case 'd':
             parse_daemonize();
@@ -70,6 +79,23 @@ static void parse_arguments(int argc, char *argv[])
         case 't':
             g_timestamps = 1;
             break;
+        case 'T':
+            g_soap_threads = 1;
+            break;
+        case 's':
+            g_shards = atoi(optarg);
+            if (g_shards < 1) {
+                fprintf(stderr, "Bad number of shards \"%s\"\n", optarg);
+                exit(ERR_INVALID_ARGS);
+            }
+            break;
+        case 'b':
+            g_bootstrap_jobs = atoi(optarg);
+            if (g_bootstrap_jobs < 1) {
+                fprintf(stderr, "Bad number of bootstrap jobs \"%s\"\n", optarg);
+                exit(ERR_INVALID_ARGS);
+            }
+            break;
         default:
             usage(argv[0]);
             exit(ERR_INVALID_ARGS);
@@ -118,13 +144,17 @@ int main(int argc, char *argv[])
     worker_init();
     soap_global_construct();
     address_mngr_init();
+    visca_decode_init();
     /* discovery_init(); */
 
     /* discovery_do(3000); */
     config_read();
+    /* only now, so the per camera options of the config are in place for the bootstrap */
+    bootstrap_init();
     worker_do_external_discovery();
     worker_start();
 
+    bootstrap_destruct();
     config_destruct();
     soap_global_destruct();
     discovery_destruct();
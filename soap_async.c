@@ -0,0 +1,777 @@
+#define _GNU_SOURCE
+
+#include "soap_async.h"
+#include "soap_global.h"
+#include "soap_instance.h"
+#include "soap_thread.h"
+#include "soap_utils.h"
+#include "timer_wheel.h"
+#include "log.h"
+#include "worker.h"
+#include <errno.h>
+#include <netdb.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define SOAP_ASYNC_READ_CHUNK 4096
+/* anything bigger is not an answer to one of our calls */
+#define SOAP_ASYNC_MAX_RESPONSE (1024 * 1024)
+
+/* gsoap opens its connections through soap->fopen, hand it the socket we connected ourselves */
+static SOAP_SOCKET fopen_connected(soap_t *soap, const char *endpoint, const char *host, int port)
+{
+    struct soap_async_call *call = soap->user;
+
+    (void)endpoint;
+    (void)host;
+    (void)port;
+
+    call->fd_handed_over = 1;
+
+    return call->fd;
+}
+
+/* gsoap closes a socket it was handed on errors and after reading a response */
+static void reclaim_fd(struct soap_async_call *call, soap_t *soap)
+{
+    if (call->fd_handed_over && !soap_valid_socket(soap->socket))
+        call->fd = -1;
+}
+
+static void buf_reserve(struct soap_async_buf *buf, size_t len)
+{
+    size_t new_cap = buf->cap ? buf->cap : SOAP_ASYNC_READ_CHUNK;
+    char *data;
+
+    if (buf->len + len <= buf->cap)
+        return;
+
+    while (new_cap < buf->len + len)
+        new_cap *= 2;
+
+    data = realloc(buf->data, new_cap);
+    if (data == NULL)
+        die(ERR_NOMEM, "failed to realloc(%zd)", new_cap);
+
+    buf->data = data;
+    buf->cap = new_cap;
+}
+
+static void buf_append(struct soap_async_buf *buf, const char *data, size_t len)
+{
+    buf_reserve(buf, len);
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+/* gsoap serializes into the queue's out buffer, the event loop writes it once the socket
+   has room */
+static int fsend_buffered(soap_t *soap, const char *s, size_t n)
+{
+    struct soap_async_call *call = soap->user;
+
+    buf_append(&call->queue->out, s, n);
+
+    return SOAP_OK;
+}
+
+/* and parses a response that was read completely before, so it never waits on the camera */
+static size_t frecv_buffered(soap_t *soap, char *s, size_t n)
+{
+    struct soap_async_call *call = soap->user;
+    struct soap_async_buf *in = &call->queue->in;
+
+    if (n > in->len - in->pos)
+        n = in->len - in->pos;
+
+    memcpy(s, in->data + in->pos, n);
+    in->pos += n;
+
+    return n;
+}
+
+/* finds a header in the header block [it, end), which ends in an empty line */
+static const char* http_header(const char *it, const char *end, const char *name)
+{
+    size_t name_len = strlen(name);
+
+    while ((it = memmem(it, end - it, "\r\n", 2)) != NULL) {
+        it += 2;
+        if ((size_t)(end - it) > name_len && strncasecmp(it, name, name_len) == 0)
+            return it + name_len;
+    }
+
+    return NULL;
+}
+
+/* tells if the bytes read so far hold a whole http response: the headers and a body of
+   Content-Length bytes or chunks up to the last one. a response with neither ends when the
+   camera closes the connection */
+static int http_complete(const char *buf, size_t len)
+{
+    const char *end = buf + len, *body, *value, *it, *line_end;
+    size_t chunk;
+
+    body = memmem(buf, len, "\r\n\r\n", 4);
+    if (body == NULL)
+        return 0;
+
+    body += 4;
+
+    /* an interim 100 Continue is followed by the actual response */
+    if (len > 12 && strncmp(buf + 8, " 100", 4) == 0)
+        return http_complete(body, end - body);
+
+    value = http_header(buf, body, "Content-Length:");
+    if (value != NULL)
+        return (size_t)(end - body) >= strtoul(value, NULL, 10);
+
+    value = http_header(buf, body, "Transfer-Encoding:");
+    if (value == NULL || strncasecmp(value + strspn(value, " "), "chunked", 7) != 0)
+        return 0;
+
+    for (it = body;; it = line_end + 2 + chunk + 2) {
+        line_end = memmem(it, end - it, "\r\n", 2);
+        if (line_end == NULL)
+            return 0;
+
+        chunk = strtoul(it, NULL, 16);
+        /* the last chunk, its trailers end in an empty line */
+        if (chunk == 0)
+            return memmem(line_end, end - line_end, "\r\n\r\n", 4) != NULL;
+
+        if (chunk > SOAP_ASYNC_MAX_RESPONSE || (size_t)(end - line_end) < 2 + chunk + 2)
+            return 0;
+    }
+}
+
+static void start_next(struct soap_async_queue *queue);
+
+/* only the event loop of the queue's shard takes and releases calls, so the list needs no lock */
+static void release(struct soap_async_call *call)
+{
+    struct soap_async_queue *queue = call->queue;
+
+    call->next = queue->spare;
+    queue->spare = call;
+}
+
+static void complete(struct soap_async_call *call)
+{
+    struct soap_async_queue *queue = call->queue;
+
+    call->state = SAS_DONE;
+
+    if (call->error)
+        log("soap_async: %s failed for %s", call->op->name, call->xaddr);
+
+    if (call->done)
+        call->done(call);
+
+    queue->inflight = NULL;
+    release(call);
+
+    start_next(queue);
+}
+
+/* drops the connection of the call and everything gsoap allocated for it */
+static void reset(struct soap_async_call *call)
+{
+    soap_t *soap = call->queue->soap;
+
+    timer_wheel_cancel(&call->timer);
+
+    if (call->event != NULL) {
+        worker_forget_fd(call->event);
+        call->event = NULL;
+    }
+
+    if (call->fd >= 0) {
+        close(call->fd);
+        if (soap->socket == call->fd)
+            soap->socket = SOAP_INVALID_SOCKET;
+        call->fd = -1;
+    }
+
+    soap_destroy(soap);
+    soap_end(soap);
+}
+
+static void finish(struct soap_async_call *call, int error)
+{
+    reset(call);
+
+    call->error = error;
+
+    if (call->queue->breaker != NULL)
+        soap_breaker_record(call->queue->breaker, error == SAE_UNREACHABLE, call->probe);
+
+    complete(call);
+}
+
+static int split_xaddr(const char *xaddr, char *host, char *port)
+{
+    const char *it = xaddr, *host_end, *port_start;
+    size_t host_len;
+
+    if (strncmp(it, "http://", 7) != 0) {
+        log("soap_async: unsupported endpoint '%s'", xaddr);
+        return 1;
+    }
+
+    it += 7;
+
+    host_end = it + strcspn(it, ":/");
+    host_len = host_end - it;
+
+    if (host_len == 0 || host_len >= SOAP_POOL_MAX_HOST_LEN)
+        return 1;
+
+    memcpy(host, it, host_len);
+    host[host_len] = '\0';
+
+    if (*host_end != ':') {
+        strcpy(port, "80");
+        return 0;
+    }
+
+    port_start = host_end + 1;
+
+    if (strcspn(port_start, "/") >= SOAP_POOL_MAX_PORT_LEN)
+        return 1;
+
+    snprintf(port, SOAP_POOL_MAX_PORT_LEN, "%.*s", (int)strcspn(port_start, "/"), port_start);
+
+    return 0;
+}
+
+static int connect_nonblocking(struct soap_async_call *call, int *in_progress)
+{
+    const char *host = call->host, *port = call->port;
+    struct addrinfo ai_hint = { 0 }, *ai_result;
+    int err, fd;
+
+    ai_hint.ai_family = AF_INET;
+    ai_hint.ai_socktype = SOCK_STREAM;
+    /* a dns lookup would hold up every camera of the shard, hosts are resolved by the
+       bootstrap, see soap_utils_resolve_xaddrs() */
+    ai_hint.ai_flags = AI_NUMERICSERV | AI_NUMERICHOST;
+
+    err = getaddrinfo(host, port, &ai_hint, &ai_result);
+    if (err == EAI_NONAME) {
+        log("soap_async: %s is not a numeric address", host);
+        return 1;
+    } else if (err != 0) {
+        log("soap_async: getaddrinfo() for %s failed: %s", host, gai_strerror(err));
+        return 1;
+    }
+
+    fd = socket(ai_result->ai_family, (unsigned)ai_result->ai_socktype | (unsigned)SOCK_NONBLOCK
+            | (unsigned)SOCK_CLOEXEC, ai_result->ai_protocol);
+    if (fd == -1) {
+        freeaddrinfo(ai_result);
+        log("soap_async: socket() failed: %s", strerror(errno));
+        return 1;
+    }
+
+    call->fd = fd;
+    *in_progress = 0;
+
+    if (connect(fd, ai_result->ai_addr, ai_result->ai_addrlen) == -1) {
+        if (errno != EINPROGRESS) {
+            log("soap_async: connect() to %s:%s failed: %s", host, port, strerror(errno));
+            freeaddrinfo(ai_result);
+            return 1;
+        }
+
+        *in_progress = 1;
+    }
+
+    freeaddrinfo(ai_result);
+
+    return 0;
+}
+
+static void connect_call(struct soap_async_call *call);
+
+/* a pooled connection the camera closed while it sat idle fails on first use, such a call
+   gets one more try on a fresh connection */
+static int retry_fresh(struct soap_async_call *call)
+{
+    soap_t *soap = call->queue->soap;
+
+    if (!call->reused || (soap->error != SOAP_EOF && soap->error != SOAP_TCP_ERROR))
+        return 0;
+
+    log("soap_async: kept-alive connection to %s:%s failed, reconnecting", call->host, call->port);
+
+    reset(call);
+
+    call->reused = 0;
+    call->fd_handed_over = 0;
+
+    connect_call(call);
+
+    return 1;
+}
+
+/* the response is still parsed by gsoap, as if it had sent the request itself */
+static int send_template(struct soap_async_call *call, soap_t *soap, struct soap_template *t)
+{
+    call->op->patch(t, call);
+
+    if (soap_template_sign(t, &call->queue->auth) != 0) {
+        soap->error = SOAP_TCP_ERROR;
+        return soap->error;
+    }
+
+    buf_append(&call->queue->out, t->buf, t->len);
+
+    soap->socket = call->fd;
+    soap->keep_alive = -1;
+    call->fd_handed_over = 1;
+
+    return SOAP_OK;
+}
+
+static int send_call(struct soap_async_call *call, soap_t *soap)
+{
+    struct soap_template *t = &call->instance->templates[call->op->tmpl];
+
+    if (call->op->tmpl != STI_NONE && t->buf != NULL)
+        return send_template(call, soap, t);
+
+    soap_auth_apply(&call->queue->auth, soap);
+
+    return call->op->send(soap, call);
+}
+
+static void watch(struct soap_async_call *call, int in)
+{
+    if (call->event == NULL)
+        call->event = worker_add_fd(call->fd, FDT_SOAP, in, call);
+    else
+        worker_watch_fd(call->event, in);
+}
+
+/* writes what the socket takes, returns 1 once the whole request is out and -1 on failure */
+static int write_request(struct soap_async_call *call)
+{
+    struct soap_async_buf *out = &call->queue->out;
+    ssize_t len;
+
+    while (out->pos < out->len) {
+        len = send(call->fd, out->data + out->pos, out->len - out->pos, MSG_NOSIGNAL);
+        if (len >= 0) {
+            out->pos += (size_t)len;
+            continue;
+        }
+
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+
+        log("soap_async: send() to %s failed: %s", call->xaddr, strerror(errno));
+        return -1;
+    }
+
+    return 1;
+}
+
+static void send_pending(struct soap_async_call *call)
+{
+    soap_t *soap = call->queue->soap;
+    int written = write_request(call);
+
+    if (written < 0) {
+        soap->error = SOAP_TCP_ERROR;
+        if (retry_fresh(call))
+            return;
+        finish(call, SAE_UNREACHABLE);
+        return;
+    }
+
+    /* the rest goes out when the socket has room again */
+    if (written == 0) {
+        watch(call, 0);
+        return;
+    }
+
+    call->state = SAS_RECEIVING;
+    call->queue->in.len = call->queue->in.pos = 0;
+    timer_wheel_schedule(&call->timer, (uint64_t)soap->recv_timeout * 1000u);
+    watch(call, 1);
+}
+
+static void send_request(struct soap_async_call *call)
+{
+    soap_t *soap = call->queue->soap;
+
+    soap->user = call;
+    soap->fopen = fopen_connected;
+    /* gsoap would close a socket it still holds, it must always ask fopen_connected() */
+    soap->socket = SOAP_INVALID_SOCKET;
+    call->queue->out.len = call->queue->out.pos = 0;
+
+    if (send_call(call, soap) != SOAP_OK) {
+        reclaim_fd(call, soap);
+        if (retry_fresh(call))
+            return;
+        soap_utils_log_error(soap);
+        finish(call, soap_async_error_of(soap->error));
+        return;
+    }
+
+    call->state = SAS_SENDING;
+    timer_wheel_schedule(&call->timer, (uint64_t)soap->send_timeout * 1000u);
+    send_pending(call);
+}
+
+/* gsoap leaves the socket open after a response only if the camera agreed to keep it alive */
+static void keep_alive(struct soap_async_call *call, soap_t *soap)
+{
+    if (call->fd < 0 || soap->socket != call->fd || !soap->keep_alive)
+        return;
+
+    soap_pool_release(&call->instance->pool, call->fd, call->host, call->port);
+
+    soap->socket = SOAP_INVALID_SOCKET;
+    call->fd = -1;
+}
+
+/* reads what arrived, returns 1 once nothing more is to come for this response */
+static int read_response(struct soap_async_call *call)
+{
+    struct soap_async_buf *in = &call->queue->in;
+    ssize_t len;
+
+    for (;;) {
+        if (in->len >= SOAP_ASYNC_MAX_RESPONSE) {
+            log("soap_async: response of %s from %s is too large", call->op->name, call->xaddr);
+            return 1;
+        }
+
+        buf_reserve(in, SOAP_ASYNC_READ_CHUNK);
+
+        len = recv(call->fd, in->data + in->len, in->cap - in->len, 0);
+        if (len > 0) {
+            in->len += (size_t)len;
+            continue;
+        }
+
+        /* whatever came until the camera closed is left for gsoap to judge */
+        if (len == 0)
+            return 1;
+
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return http_complete(in->data, in->len);
+
+        log("soap_async: recv() from %s failed: %s", call->xaddr, strerror(errno));
+        return 1;
+    }
+}
+
+static void receive_response(struct soap_async_call *call)
+{
+    soap_t *soap = call->queue->soap;
+    int error;
+
+    if (!read_response(call))
+        return;
+
+    worker_forget_fd(call->event);
+    call->event = NULL;
+
+    error = soap_async_error_of(call->op->recv(soap, call));
+
+    reclaim_fd(call, soap);
+
+    if (error) {
+        if (retry_fresh(call))
+            return;
+        soap_utils_log_error(soap);
+    } else
+        keep_alive(call, soap);
+
+    finish(call, error);
+}
+
+static void connect_call(struct soap_async_call *call)
+{
+    int in_progress;
+
+    if (connect_nonblocking(call, &in_progress) != 0) {
+        finish(call, SAE_UNREACHABLE);
+        return;
+    }
+
+    if (!in_progress) {
+        send_request(call);
+        return;
+    }
+
+    call->state = SAS_CONNECTING;
+    timer_wheel_schedule(&call->timer, (uint64_t)call->queue->soap->connect_timeout * 1000u);
+    call->event = worker_add_fd(call->fd, FDT_SOAP, 0, call);
+}
+
+static void start(struct soap_async_call *call)
+{
+    struct soap_async_queue *queue = call->queue;
+
+    queue->inflight = call;
+
+    if (queue->thread != NULL) {
+        if (soap_thread_push(queue->thread, call) != 0) {
+            call->error = SAE_UNREACHABLE;
+            complete(call);
+        }
+        return;
+    }
+
+    if (split_xaddr(call->xaddr, call->host, call->port) != 0) {
+        finish(call, SAE_UNREACHABLE);
+        return;
+    }
+
+    call->fd = soap_pool_acquire(&call->instance->pool, call->host, call->port);
+    if (call->fd >= 0) {
+        call->reused = 1;
+        send_request(call);
+        return;
+    }
+
+    connect_call(call);
+}
+
+/* fails a call the breaker turned away without it ever reaching the camera */
+static void reject(struct soap_async_call *call)
+{
+    log("soap_async: %s is out of service, rejecting %s", call->instance->service_endpoint,
+            call->op->name);
+
+    call->state = SAS_DONE;
+    call->error = SAE_UNREACHABLE;
+
+    if (call->done)
+        call->done(call);
+
+    release(call);
+}
+
+static void start_next(struct soap_async_queue *queue)
+{
+    struct soap_async_call *call;
+
+    while (queue->inflight == NULL && (call = queue->head) != NULL) {
+        queue->head = call->next;
+        if (queue->head == NULL)
+            queue->tail = NULL;
+
+        call->next = NULL;
+
+        if (queue->pending[call->op->pending] == call)
+            queue->pending[call->op->pending] = NULL;
+
+        if (queue->breaker == NULL || soap_breaker_admit(queue->breaker, call->probe)) {
+            start(call);
+            return;
+        }
+
+        reject(call);
+    }
+}
+
+/* every call of a queue talks to the same service, its namespace table is set once */
+void soap_async_queue_construct(struct soap_async_queue *queue, int shard,
+        const struct Namespace *namespaces, struct soap_breaker *breaker)
+{
+    queue->soap = soap_global_new_context();
+    soap_set_namespaces(queue->soap, namespaces);
+    /* http/1.1 keep-alive, the connections are pooled per instance between calls */
+    soap_set_mode(queue->soap, SOAP_IO_KEEPALIVE);
+    queue->inflight = NULL;
+    queue->head = queue->tail = NULL;
+    memset(queue->pending, 0, sizeof(queue->pending));
+    queue->breaker = breaker;
+    queue->spare = NULL;
+    soap_auth_construct(&queue->auth);
+    memset(&queue->out, 0, sizeof(queue->out));
+    memset(&queue->in, 0, sizeof(queue->in));
+    queue->thread = g_soap_threads ? soap_thread_create(queue->soap, shard) : NULL;
+
+    /* a thread of its own may block on the camera, the event loop must not */
+    if (queue->thread == NULL) {
+        queue->soap->fsend = fsend_buffered;
+        queue->soap->frecv = frecv_buffered;
+    }
+}
+
+void soap_async_queue_destruct(struct soap_async_queue *queue)
+{
+    struct soap_async_call *it = queue->head, *next;
+
+    /* the thread owns and frees the call it is running */
+    if (queue->thread != NULL) {
+        soap_thread_destroy(queue->thread);
+        soap_force_closesock(queue->soap);
+        queue->inflight = NULL;
+    }
+
+    while (it != NULL) {
+        next = it->next;
+        free(it);
+        it = next;
+    }
+
+    for (it = queue->spare; it != NULL; it = next) {
+        next = it->next;
+        free(it);
+    }
+
+    /* the event loop is gone by now, so only the socket is left to clean up */
+    if (queue->inflight != NULL) {
+        if (queue->inflight->fd >= 0)
+            close(queue->inflight->fd);
+        free(queue->inflight);
+    }
+
+    queue->soap->socket = SOAP_INVALID_SOCKET;
+
+    free(queue->out.data);
+    free(queue->in.data);
+
+    soap_destroy(queue->soap);
+    soap_end(queue->soap);
+    soap_free(queue->soap);
+}
+
+/* connect, send or receive deadline of the call passed */
+static void expire(void *data)
+{
+    struct soap_async_call *call = data;
+
+    log("soap_async: %s to %s timed out", call->op->name, call->xaddr);
+
+    finish(call, SAE_UNREACHABLE);
+}
+
+struct soap_async_call* soap_async_call_new(struct soap_instance *instance,
+        struct soap_async_queue *queue, const struct soap_async_op *op, const char *xaddr)
+{
+    struct soap_async_call *call = queue->spare;
+
+    if (call == NULL)
+        call = malloc(sizeof(struct soap_async_call));
+    else
+        queue->spare = call->next;
+
+    if (call == NULL)
+        die(ERR_NOMEM, "failed to malloc(%zd)", sizeof(struct soap_async_call));
+
+    memset(call, 0, sizeof(struct soap_async_call));
+    call->op = op;
+    call->instance = instance;
+    call->queue = queue;
+    call->xaddr = xaddr;
+    call->state = SAS_QUEUED;
+    call->fd = -1;
+
+    wheel_timer_init(&call->timer, expire, call);
+
+    return call;
+}
+
+/* while a call is in flight a newer velocity command or status request is folded into the
+   one still queued, wherever that sits. a slow camera then has at most one move and one
+   status queued, however many joystick packets and polls come in */
+void soap_async_submit(struct soap_async_call *call)
+{
+    struct soap_async_queue *queue = call->queue;
+    int pending = call->op->pending;
+
+    if (pending != SAP_NONE && queue->pending[pending] != NULL
+            && call->op->coalesce(queue->pending[pending], call)) {
+        release(call);
+        return;
+    }
+
+    if (queue->tail == NULL)
+        queue->head = queue->tail = call;
+    else
+        queue->tail = queue->tail->next = call;
+
+    /* any other call keeps its place, what comes after it is queued behind it */
+    if (pending == SAP_NONE)
+        memset(queue->pending, 0, sizeof(queue->pending));
+    else
+        queue->pending[pending] = call;
+
+    start_next(queue);
+}
+
+/* tells if a call of the pending slot is queued or in flight */
+int soap_async_busy(const struct soap_async_queue *queue, int pending)
+{
+    return queue->pending[pending] != NULL
+        || (queue->inflight != NULL && queue->inflight->op->pending == pending);
+}
+
+/* eof and tcp errors are all gsoap reports for a camera that never answered, anything else
+   came from a camera that did */
+int soap_async_error_of(int soap_error)
+{
+    if (soap_error == SOAP_OK)
+        return SAE_NONE;
+
+    return soap_error == SOAP_EOF || soap_error == SOAP_TCP_ERROR ? SAE_UNREACHABLE : SAE_FAULT;
+}
+
+/* called on the event loop for calls that finished on a camera thread */
+void soap_async_complete(struct soap_async_call *call)
+{
+    if (call->queue->breaker != NULL)
+        soap_breaker_record(call->queue->breaker, call->error == SAE_UNREACHABLE, call->probe);
+
+    complete(call);
+}
+
+void soap_async_handle_event(struct event_t *event, uint32_t events)
+{
+    struct soap_async_call *call = event->data;
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+
+    switch (call->state) {
+    case SAS_CONNECTING:
+        if (getsockopt(call->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) == -1)
+            err = errno;
+
+        if (err != 0) {
+            log("soap_async: failed to connect to %s: %s", call->xaddr, strerror(err));
+            finish(call, SAE_UNREACHABLE);
+            return;
+        }
+
+        send_request(call);
+        break;
+    case SAS_SENDING:
+        send_pending(call);
+        break;
+    case SAS_RECEIVING:
+        if (!(events & (unsigned)(EPOLLIN | EPOLLHUP | EPOLLRDHUP | EPOLLERR)))
+            return;
+
+        receive_response(call);
+        break;
+    default:
+        log("soap_async: unexpected event on fd = %d in state %d", call->fd, call->state);
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "epoll.h"
+#include "soap_auth.h"
+#include "soap_header.h"
+#include "soap_pool.h"
+#include "soap_template.h"
+#include "timer_wheel.h"
+#include <stdint.h>
+
+struct soap_instance;
+struct soap_async_call;
+struct soap_thread;
+struct soap_breaker;
+
+/* one onvif operation split in the two halves gsoap generates for every call:
+   send() serializes the request, recv() parses the response. neither touches the socket,
+   gsoap works on the queue's buffers and the event loop moves them in and out.
+   ops with a pending slot have at most one call of that kind queued: coalesce() folds a
+   newer call into it and returns 1 if it did. ops with a template skip send(): patch()
+   writes the call's values into the instance's pre-serialized request, which goes out as is */
+struct soap_async_op
+{
+    const char *name;
+    int (*send)(soap_t *soap, struct soap_async_call *call);
+    int (*recv)(soap_t *soap, struct soap_async_call *call);
+    int (*coalesce)(struct soap_async_call *pending, const struct soap_async_call *call);
+    int pending;
+    int tmpl;
+    void (*patch)(struct soap_template *t, const struct soap_async_call *call);
+};
+
+enum soap_async_pending
+{
+    SAP_NONE = 0,
+    SAP_VELOCITY,
+    SAP_STATUS,
+    SAP_COUNT,
+};
+
+enum soap_async_state
+{
+    SAS_QUEUED = 0,
+    SAS_CONNECTING,
+    SAS_SENDING,
+    SAS_RECEIVING,
+    SAS_DONE,
+};
+
+/* how a call failed. a camera that answered, even with a fault, is up, only calls that got
+   no answer at all count against its breaker */
+enum soap_async_error
+{
+    SAE_NONE = 0,
+    SAE_FAULT,
+    SAE_UNREACHABLE,
+};
+
+union soap_async_args
+{
+    struct { float pan_x, pan_y, zoom; } move;
+    struct { int pantilt, zoom; } stop;
+    struct { float pan_speed, tilt_speed; int preset; } preset;
+    struct { float pan, tilt, zoom; int moving; } position;
+    struct { float position, speed; } focus;
+    struct { int ptz, imaging; } events;
+};
+
+/* bytes of the call in flight, read by gsoap from pos on */
+struct soap_async_buf
+{
+    char *data;
+    size_t len, cap, pos;
+};
+
+struct soap_async_queue
+{
+    soap_t *soap;
+    /* the request until it is written and the response until it is whole. only one call is
+       in flight per queue, so they are reused from call to call */
+    struct soap_async_buf out, in;
+    /* signs the calls of the queue. queues may run on threads of their own, so none shares
+       its nonces and header with another */
+    struct soap_auth auth;
+    struct soap_async_call *inflight;
+    struct soap_async_call *head, *tail;
+    /* the queued call of each slot, which newer calls of its kind are folded into */
+    struct soap_async_call *pending[SAP_COUNT];
+    /* set when calls run on a dedicated thread instead of the event loop */
+    struct soap_thread *thread;
+    /* accounts the calls of the queue, NULL for calls that don't tell if a camera is healthy */
+    struct soap_breaker *breaker;
+    /* calls that finished, soap_async_call_new() takes them before it allocates another */
+    struct soap_async_call *spare;
+};
+
+struct soap_async_call
+{
+    const struct soap_async_op *op;
+    struct soap_instance *instance;
+    struct soap_async_queue *queue;
+    const char *xaddr;
+    char host[SOAP_POOL_MAX_HOST_LEN];
+    char port[SOAP_POOL_MAX_PORT_LEN];
+    int state;
+    int fd;
+    int fd_handed_over;
+    /* fd came from the instance's pool of kept-alive connections */
+    int reused;
+    /* sent by the instance's breaker to find out if the camera is back */
+    int probe;
+    /* enum soap_async_error */
+    int error;
+    struct wheel_timer timer;
+    struct event_t *event;
+    union soap_async_args args;
+    void (*done)(struct soap_async_call *call);
+    struct soap_async_call *next;
+};
+
+void soap_async_queue_construct(struct soap_async_queue *queue, int shard,
+        const struct Namespace *namespaces, struct soap_breaker *breaker);
+void soap_async_queue_destruct(struct soap_async_queue *queue);
+struct soap_async_call* soap_async_call_new(struct soap_instance *instance,
+        struct soap_async_queue *queue, const struct soap_async_op *op, const char *xaddr);
+void soap_async_submit(struct soap_async_call *call);
+int soap_async_busy(const struct soap_async_queue *queue, int pending);
+int soap_async_error_of(int soap_error);
+void soap_async_complete(struct soap_async_call *call);
+void soap_async_handle_event(struct event_t *event, uint32_t events);
@@ -0,0 +1,126 @@
+#include "soap_auth.h"
+#include "config.h"
+#include "log.h"
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <string.h>
+
+#define WSSE_NS "http://docs.oasis-open.org/wss/2004/01/"
+
+static char password_digest_uri[] =
+    WSSE_NS "oasis-200401-wss-username-token-profile-1.0#PasswordDigest";
+static char base64_binary_uri[] =
+    WSSE_NS "oasis-200401-wss-soap-message-security-1.0#Base64Binary";
+static char timestamp_id[] = "Time";
+static char token_id[] = "Auth";
+
+void soap_auth_construct(struct soap_auth *auth)
+{
+    memset(auth, 0, sizeof(struct soap_auth));
+
+    auth->mode = SAM_WSSE;
+}
+
+/* returns -1 for an unknown mode */
+int soap_auth_parse_mode(const char *value)
+{
+    if (strcmp(value, "wsse") == 0)
+        return SAM_WSSE;
+
+    if (strcmp(value, "none") == 0)
+        return SAM_NONE;
+
+    return -1;
+}
+
+static void format_time(time_t t, char *out)
+{
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    strftime(out, SOAP_AUTH_TIME_WIDTH + 1, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
+
+/* nonces are drawn from the rng a batch at a time */
+static const unsigned char* next_nonce(struct soap_auth *auth)
+{
+    if (auth->nonces_left == 0) {
+        if (RAND_bytes(auth->nonces[0], sizeof(auth->nonces)) != 1) {
+            log("soap_auth: RAND_bytes() failed");
+            return NULL;
+        }
+
+        auth->nonces_left = SOAP_AUTH_NONCE_BATCH;
+    }
+
+    return auth->nonces[--auth->nonces_left];
+}
+
+/* every request gets a nonce of its own, cameras turn down one they have seen before.
+   digest = base64(sha1(nonce + created + password)) */
+int soap_auth_refresh(struct soap_auth *auth)
+{
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    const unsigned char *nonce;
+    const char *password = g_config.password ? g_config.password : "";
+    time_t now = time(NULL);
+    SHA_CTX sha;
+
+    nonce = next_nonce(auth);
+    if (nonce == NULL)
+        return 1;
+
+    if (now != auth->signed_at) {
+        format_time(now, auth->created);
+        format_time(now + SOAP_AUTH_EXPIRES_S, auth->expires);
+        auth->signed_at = now;
+    }
+
+    SHA1_Init(&sha);
+    SHA1_Update(&sha, nonce, SOAP_AUTH_NONCE_LEN);
+    SHA1_Update(&sha, auth->created, SOAP_AUTH_TIME_WIDTH);
+    SHA1_Update(&sha, password, strlen(password));
+    SHA1_Final(digest, &sha);
+
+    EVP_EncodeBlock((unsigned char*)auth->nonce, nonce, SOAP_AUTH_NONCE_LEN);
+    EVP_EncodeBlock((unsigned char*)auth->digest, digest, sizeof(digest));
+
+    return 0;
+}
+
+/* gsoap parses the response header into soap->header, so the links are set again on every call */
+void soap_auth_apply(struct soap_auth *auth, soap_t *soap)
+{
+    if (auth->mode == SAM_NONE || soap_auth_refresh(auth) != 0) {
+        soap->header = NULL;
+        return;
+    }
+
+    memset(&auth->header, 0, sizeof(auth->header));
+    memset(&auth->security, 0, sizeof(auth->security));
+
+    auth->timestamp.wsu__Id = timestamp_id;
+    auth->timestamp.Created = auth->created;
+    auth->timestamp.Expires = auth->expires;
+
+    auth->password.__item = auth->digest;
+    auth->password.Type = password_digest_uri;
+
+    auth->encoded_nonce.__item = auth->nonce;
+    auth->encoded_nonce.EncodingType = base64_binary_uri;
+    auth->encoded_nonce.wsu__Id = NULL;
+
+    auth->token.Username = g_config.username;
+    auth->token.Password = &auth->password;
+    auth->token.Nonce = &auth->encoded_nonce;
+    auth->token.wsu__Created = auth->created;
+    auth->token.wsu__Id = token_id;
+
+    auth->security.wsu__Timestamp = &auth->timestamp;
+    auth->security.UsernameToken = &auth->token;
+
+    auth->header.wsse__Security = &auth->security;
+
+    soap->header = &auth->header;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "soap_header.h"
+#include <time.h>
+
+#define SOAP_AUTH_NONCE_LEN 16
+#define SOAP_AUTH_NONCE_BATCH 64
+/* base64 of a nonce and of a sha1 digest */
+#define SOAP_AUTH_NONCE_WIDTH 24
+#define SOAP_AUTH_DIGEST_WIDTH 28
+/* "2006-01-02T15:04:05Z" */
+#define SOAP_AUTH_TIME_WIDTH 20
+#define SOAP_AUTH_EXPIRES_S 10
+
+enum soap_auth_mode
+{
+    SAM_WSSE = 0,
+    SAM_NONE,
+};
+
+/* ws-security state of one camera. the header handed to gsoap lives here and points into
+   the strings below, so signing a call only takes a nonce and hashes the digest */
+struct soap_auth
+{
+    int mode;
+    unsigned char nonces[SOAP_AUTH_NONCE_BATCH][SOAP_AUTH_NONCE_LEN];
+    int nonces_left;
+    /* second created and expires were formatted for */
+    time_t signed_at;
+    char created[SOAP_AUTH_TIME_WIDTH + 1];
+    char expires[SOAP_AUTH_TIME_WIDTH + 1];
+    char nonce[SOAP_AUTH_NONCE_WIDTH + 1];
+    char digest[SOAP_AUTH_DIGEST_WIDTH + 1];
+    struct SOAP_ENV__Header header;
+    struct _wsse__Security security;
+    struct _wsu__Timestamp timestamp;
+    struct _wsse__UsernameToken token;
+    struct _wsse__Password password;
+    struct wsse__EncodedString encoded_nonce;
+};
+
+void soap_auth_construct(struct soap_auth *auth);
+int soap_auth_parse_mode(const char *value);
+int soap_auth_refresh(struct soap_auth *auth);
+void soap_auth_apply(struct soap_auth *auth, soap_t *soap);
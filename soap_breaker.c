@@ -0,0 +1,78 @@
+#include "soap_breaker.h"
+#include "log.h"
+
+static void half_open(void *data)
+{
+    struct soap_breaker *breaker = data;
+
+    log("soap_breaker: probing %s", breaker->name);
+
+    breaker->state = SBS_HALF_OPEN;
+    breaker->probe(breaker->data);
+}
+
+static void trip(struct soap_breaker *breaker, uint64_t open_ms)
+{
+    if (open_ms > SOAP_BREAKER_MAX_OPEN_MS)
+        open_ms = SOAP_BREAKER_MAX_OPEN_MS;
+
+    log("soap_breaker: %s failed %d times in a row, rejecting calls for %lu ms", breaker->name,
+            breaker->failures, (unsigned long)open_ms);
+
+    breaker->state = SBS_OPEN;
+    breaker->open_ms = open_ms;
+
+    timer_wheel_schedule(&breaker->timer, open_ms);
+}
+
+/* name must outlive the breaker */
+void soap_breaker_construct(struct soap_breaker *breaker, const char *name,
+        void (*probe)(void *data), void *data)
+{
+    breaker->state = SBS_CLOSED;
+    breaker->failures = 0;
+    breaker->open_ms = SOAP_BREAKER_MIN_OPEN_MS;
+    breaker->rejected = 0;
+    breaker->probe = probe;
+    breaker->data = data;
+    breaker->name = name;
+
+    wheel_timer_init(&breaker->timer, half_open, breaker);
+}
+
+/* returns 1 if a call may go to the camera. while half-open only the probe may */
+int soap_breaker_admit(struct soap_breaker *breaker, int probe)
+{
+    if (breaker->state == SBS_CLOSED || (breaker->state == SBS_HALF_OPEN && probe))
+        return 1;
+
+    ++breaker->rejected;
+
+    return 0;
+}
+
+/* once the breaker opened only the probe decides, calls that were in flight then are late */
+void soap_breaker_record(struct soap_breaker *breaker, int error, int probe)
+{
+    if (breaker->state != SBS_CLOSED && !probe)
+        return;
+
+    if (!error) {
+        if (breaker->state != SBS_CLOSED)
+            log("soap_breaker: %s is back, %lu calls were rejected", breaker->name,
+                    breaker->rejected);
+
+        breaker->state = SBS_CLOSED;
+        breaker->failures = 0;
+        breaker->open_ms = SOAP_BREAKER_MIN_OPEN_MS;
+        breaker->rejected = 0;
+        return;
+    }
+
+    ++breaker->failures;
+
+    if (breaker->state == SBS_HALF_OPEN)
+        trip(breaker, breaker->open_ms * 2);
+    else if (breaker->state == SBS_CLOSED && breaker->failures >= SOAP_BREAKER_FAILURES)
+        trip(breaker, SOAP_BREAKER_MIN_OPEN_MS);
+}
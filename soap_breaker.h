@@ -0,0 +1,36 @@
+#pragma once
+
+#include "timer_wheel.h"
+
+/* consecutive calls without an answer that take a camera out of service */
+#define SOAP_BREAKER_FAILURES 3
+#define SOAP_BREAKER_MIN_OPEN_MS 1000
+#define SOAP_BREAKER_MAX_OPEN_MS 60000
+
+enum soap_breaker_state
+{
+    SBS_CLOSED = 0,
+    SBS_OPEN,
+    SBS_HALF_OPEN,
+};
+
+/* failure accounting of one camera. a closed breaker lets every call through. an open one
+   rejects them until the timer fires, then probe() sends one call while the breaker is
+   half-open: its result closes the breaker or opens it again for twice as long. only the
+   event loop of the camera's shard touches it */
+struct soap_breaker
+{
+    int state;
+    int failures;
+    uint64_t open_ms;
+    unsigned long rejected;
+    struct wheel_timer timer;
+    void (*probe)(void *data);
+    void *data;
+    const char *name;
+};
+
+void soap_breaker_construct(struct soap_breaker *breaker, const char *name,
+        void (*probe)(void *data), void *data);
+int soap_breaker_admit(struct soap_breaker *breaker, int probe);
+void soap_breaker_record(struct soap_breaker *breaker, int error, int probe);
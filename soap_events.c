@@ -0,0 +1,268 @@
+#include "soap_events.h"
+#include "soap_imaging.h"
+#include "soap_instance.h"
+#include "soap_namespaces.h"
+#include "soap_ptz.h"
+#include "soap_utils.h"
+#include "log.h"
+#include <string.h>
+
+static int subscribe_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tev__CreatePullPointSubscription subscribe = { 0 };
+
+    subscribe.InitialTerminationTime = SOAP_EVENTS_TERMINATION;
+
+    return soap_send___tev__CreatePullPointSubscription(soap, call->xaddr, NULL, &subscribe);
+}
+
+/* the response is gone once the call finished, so the address is kept right away */
+static int subscribe_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tev__CreatePullPointSubscriptionResponse subscribe_resp;
+    struct soap_events *events = &call->instance->events;
+    const char *address;
+
+    if (soap_recv___tev__CreatePullPointSubscription(soap, &subscribe_resp) != SOAP_OK)
+        return soap->error;
+
+    address = subscribe_resp.SubscriptionReference.Address;
+
+    if (address == NULL || strlen(address) >= SOAP_EVENTS_MAX_ADDRESS_LEN) {
+        log("soap_events: unusable subscription address from %s", call->xaddr);
+        return SOAP_NO_DATA;
+    }
+
+    strcpy(events->address, address);
+
+    return SOAP_OK;
+}
+
+static const struct soap_async_op subscribe_op = {
+    "CreatePullPointSubscription", subscribe_send, subscribe_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+static int pull_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tev__PullMessages pull = { 0 };
+
+    pull.Timeout = SOAP_EVENTS_PULL_MS;
+    pull.MessageLimit = SOAP_EVENTS_MESSAGE_LIMIT;
+
+    return soap_send___tev__PullMessages(soap, call->xaddr, NULL, &pull);
+}
+
+static const char* topic_of(const struct wsnt__NotificationMessageHolderType *message)
+{
+    if (message->Topic == NULL)
+        return NULL;
+
+    return message->Topic->__mixed != NULL ? message->Topic->__mixed : message->Topic->__any;
+}
+
+/* topics tell what changed, the state itself is read with the services' GetStatus */
+static int pull_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tev__PullMessagesResponse pull_resp;
+    const char *topic;
+
+    if (soap_recv___tev__PullMessages(soap, &pull_resp) != SOAP_OK)
+        return soap->error;
+
+    call->args.events.ptz = call->args.events.imaging = 0;
+
+    for (int i = 0; i < pull_resp.__sizeNotificationMessage; ++i) {
+        topic = topic_of(&pull_resp.wsnt__NotificationMessage[i]);
+        if (topic == NULL)
+            continue;
+
+        if (strstr(topic, "PTZ") != NULL)
+            call->args.events.ptz = 1;
+        if (strstr(topic, "Imaging") != NULL || strstr(topic, "Focus") != NULL)
+            call->args.events.imaging = 1;
+    }
+
+    return SOAP_OK;
+}
+
+static const struct soap_async_op pull_op = {
+    "PullMessages", pull_send, pull_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+static int renew_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _wsnt__Renew renew = { 0 };
+
+    renew.TerminationTime = SOAP_EVENTS_TERMINATION;
+
+    return soap_send___tev__Renew(soap, call->xaddr, NULL, &renew);
+}
+
+static int renew_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _wsnt__RenewResponse renew_resp;
+
+    return soap_recv___tev__Renew(soap, &renew_resp);
+}
+
+static const struct soap_async_op renew_op = {
+    "Renew", renew_send, renew_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+static void submit(struct soap_instance *instance, const struct soap_async_op *op,
+        const char *xaddr, void (*done)(struct soap_async_call *call))
+{
+    struct soap_async_call *call = soap_async_call_new(instance, &instance->events.queue, op,
+            xaddr);
+
+    call->done = done;
+
+    soap_async_submit(call);
+}
+
+static void pulled(struct soap_async_call *call);
+static void renewed(struct soap_async_call *call);
+
+static void pull(struct soap_instance *instance)
+{
+    struct soap_events *events = &instance->events;
+
+    if (timer_wheel_now_ms() >= events->renew_at)
+        submit(instance, &renew_op, events->address, renewed);
+    else
+        submit(instance, &pull_op, events->address, pulled);
+}
+
+/* a subscription, pull or renew that failed. the camera is subscribed again on the timer, a
+   little later after every failure in a row and only every few minutes once it counts as
+   having no events */
+static void failed(struct soap_async_call *call)
+{
+    struct soap_events *events = &call->instance->events;
+    uint64_t delay_ms;
+
+    /* the poller keeps the shadow fresh until events work again */
+    if (++events->attempts >= SOAP_EVENTS_MAX_ATTEMPTS) {
+        log("soap_events: no events from %s after %d attempts, polling instead, subscribing "
+                "again in %d s", call->xaddr, events->attempts, SOAP_EVENTS_RETRY_SLOW_MS / 1000);
+        events->state = SES_UNSUPPORTED;
+        timer_wheel_schedule(&events->retry_timer, SOAP_EVENTS_RETRY_SLOW_MS);
+        return;
+    }
+
+    delay_ms = (uint64_t)SOAP_EVENTS_RETRY_MS << (events->attempts - 1);
+
+    log("soap_events: %s at %s failed, subscribing again in %d s", call->op->name, call->xaddr,
+            (int)(delay_ms / 1000));
+    events->state = SES_IDLE;
+    timer_wheel_schedule(&events->retry_timer, delay_ms);
+}
+
+static void retry(void *data)
+{
+    struct soap_instance *instance = data;
+
+    instance->events.state = SES_IDLE;
+
+    soap_events_start(instance);
+}
+
+static void subscribed(struct soap_async_call *call)
+{
+    struct soap_instance *instance = call->instance;
+    struct soap_events *events = &instance->events;
+
+    if (call->error) {
+        failed(call);
+        return;
+    }
+
+    log("soap_events: pulling events of %s from %s", instance->service_endpoint, events->address);
+
+    events->state = SES_PULLING;
+    events->renew_at = timer_wheel_now_ms() + SOAP_EVENTS_RENEW_MS;
+
+    /* events only tell about changes, the current state is read once up front */
+    soap_ptz_refresh_status(instance);
+    soap_imaging_refresh_status(instance);
+
+    pull(instance);
+}
+
+static void pulled(struct soap_async_call *call)
+{
+    struct soap_instance *instance = call->instance;
+
+    if (call->error) {
+        failed(call);
+        return;
+    }
+
+    /* the subscription counts as working once it delivered */
+    instance->events.attempts = 0;
+
+    if (call->args.events.ptz) {
+        instance->events.ptz_seen = 1;
+        soap_ptz_refresh_status(instance);
+    }
+    if (call->args.events.imaging)
+        soap_imaging_refresh_status(instance);
+
+    pull(instance);
+}
+
+static void renewed(struct soap_async_call *call)
+{
+    struct soap_instance *instance = call->instance;
+
+    if (call->error) {
+        failed(call);
+        return;
+    }
+
+    instance->events.renew_at = timer_wheel_now_ms() + SOAP_EVENTS_RENEW_MS;
+
+    pull(instance);
+}
+
+void soap_events_construct(struct soap_events *events, struct soap_instance *instance, int shard)
+{
+    events->state = SES_IDLE;
+    events->attempts = 0;
+    events->ptz_seen = 0;
+    events->address[0] = '\0';
+    events->renew_at = 0;
+
+    soap_async_queue_construct(&events->queue, shard, soap_namespaces_events, NULL);
+    /* a PullMessages answers only after its timeout if nothing happened */
+    events->queue.soap->recv_timeout += SOAP_EVENTS_PULL_MS / 1000;
+
+    wheel_timer_init(&events->retry_timer, retry, instance);
+}
+
+void soap_events_destruct(struct soap_events *events)
+{
+    soap_async_queue_destruct(&events->queue);
+}
+
+/* runs on the instance's shard once the instance is ready */
+void soap_events_start(void *data)
+{
+    struct soap_instance *instance = data;
+    struct soap_events *events = &instance->events;
+    const char *xaddr;
+
+    if (events->state != SES_IDLE)
+        return;
+
+    xaddr = instance->events_xaddr;
+    if (xaddr == NULL) {
+        log("soap_events: %s has no event service", instance->service_endpoint);
+        events->state = SES_UNSUPPORTED;
+        return;
+    }
+
+    events->state = SES_SUBSCRIBING;
+
+    submit(instance, &subscribe_op, xaddr, subscribed);
+}
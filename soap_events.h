@@ -0,0 +1,47 @@
+#pragma once
+
+#include "soap_async.h"
+#include "timer_wheel.h"
+
+#define SOAP_EVENTS_MAX_ADDRESS_LEN 256
+/* how long a PullMessages waits on the camera for notifications */
+#define SOAP_EVENTS_PULL_MS 5000
+#define SOAP_EVENTS_MESSAGE_LIMIT 16
+#define SOAP_EVENTS_TERMINATION "PT60S"
+#define SOAP_EVENTS_RENEW_MS 30000
+/* first delay before subscribing again, it doubles with every failure in a row */
+#define SOAP_EVENTS_RETRY_MS 10000
+/* subscriptions, pulls and renews that fail this often in a row mean the camera has no usable
+   events. the poller takes over and the subscription is only tried again now and then */
+#define SOAP_EVENTS_MAX_ATTEMPTS 3
+#define SOAP_EVENTS_RETRY_SLOW_MS 300000
+
+struct soap_instance;
+
+enum soap_events_state
+{
+    SES_IDLE = 0,
+    SES_SUBSCRIBING,
+    SES_PULLING,
+    SES_UNSUPPORTED,
+};
+
+/* pullpoint subscription of one camera. its calls have their own queue, so a PullMessages
+   waiting on the camera never holds up a ptz command. only the event loop of the camera's
+   shard touches it */
+struct soap_events
+{
+    int state;
+    /* calls that failed since the last PullMessages that worked */
+    int attempts;
+    /* a ptz topic came in, only then the poller leaves the idle camera to the events */
+    int ptz_seen;
+    struct soap_async_queue queue;
+    char address[SOAP_EVENTS_MAX_ADDRESS_LEN];
+    uint64_t renew_at;
+    struct wheel_timer retry_timer;
+};
+
+void soap_events_construct(struct soap_events *events, struct soap_instance *instance, int shard);
+void soap_events_destruct(struct soap_events *events);
+void soap_events_start(void *instance);
@@ -2,15 +2,22 @@
 #include "errors.h"
 #include "log.h"
 
-soap_t *g_soap;
+__thread soap_t *g_soap;
 
-void soap_global_construct()
+soap_t* soap_global_new_context()
 {
-    g_soap = soap_new();
-    if (g_soap == NULL)
+    soap_t *soap = soap_new();
+    if (soap == NULL)
         die(ERR_SOAP, "failed to create soap instance");
 
-    g_soap->connect_timeout = g_soap->recv_timeout = g_soap->send_timeout = 3;
+    soap->connect_timeout = soap->recv_timeout = soap->send_timeout = 3;
+
+    return soap;
+}
+
+void soap_global_construct()
+{
+    g_soap = soap_global_new_context();
 }
 
 void soap_global_destruct()
@@ -19,4 +26,3 @@ void soap_global_destruct()
     soap_end(g_soap);
     soap_free(g_soap);
 }
-
@@ -2,8 +2,9 @@
 
 #include "soap_header.h"
 
-extern soap_t *g_soap;
+/* every event loop shard has its own context */
+extern __thread soap_t *g_soap;
 
+soap_t* soap_global_new_context();
 void soap_global_construct();
 void soap_global_destruct();
-
@@ -0,0 +1,629 @@
+#include "soap_imaging.h"
+#include "address_manager.h"
+#include "soap_instance.h"
+#include "soap_utils.h"
+#include "worker.h"
+#include "log.h"
+#include <string.h>
+
+#define FIELD(F) (1u << (F))
+
+#define EXPOSURE_FIELDS (FIELD(SIF_EXPOSURE_MODE) | FIELD(SIF_IRIS) | FIELD(SIF_EXPOSURE_TIME) \
+        | FIELD(SIF_GAIN) | FIELD(SIF_MAX_GAIN))
+#define WHITE_BALANCE_FIELDS (FIELD(SIF_WHITE_BALANCE_MODE) | FIELD(SIF_CR_GAIN) \
+        | FIELD(SIF_CB_GAIN))
+
+static const char *field_names[SIF_COUNT] = {
+    "exposure mode", "iris", "exposure time", "gain", "max gain", "brightness",
+    "backlight compensation", "ir cut filter", "white balance mode", "cr gain", "cb gain",
+    "color saturation", "focus mode",
+};
+
+/* imaging settings belong to the video source of the instance's profile */
+static char* video_source_token(struct soap_instance *instance)
+{
+    profile_t *profile = instance->profile;
+
+    if (profile->VideoSourceConfiguration == NULL)
+        return NULL;
+
+    return profile->VideoSourceConfiguration->SourceToken;
+}
+
+static void submit(struct soap_instance *instance, const struct soap_async_op *op,
+        void (*done)(struct soap_async_call *call))
+{
+    struct soap_async_call *call = soap_async_call_new(instance, &instance->imaging_queue, op,
+            instance->imaging_xaddr);
+
+    call->done = done;
+
+    soap_async_submit(call);
+}
+
+static int get_status_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__GetStatus getstatus;
+
+    getstatus.VideoSourceToken = video_source_token(call->instance);
+
+    return soap_send___timg__GetStatus(soap, call->xaddr, NULL, &getstatus);
+}
+
+static int get_status_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__GetStatusResponse getstatus_resp;
+
+    if (soap_recv___timg__GetStatus(soap, &getstatus_resp) != SOAP_OK)
+        return soap->error;
+
+    if (getstatus_resp.Status == NULL || getstatus_resp.Status->FocusStatus20 == NULL)
+        return SOAP_NO_DATA;
+
+    call->args.focus.position = getstatus_resp.Status->FocusStatus20->Position;
+
+    return SOAP_OK;
+}
+
+/* a status still queued answers for every newer request as well */
+static int get_status_coalesce(struct soap_async_call *pending, const struct soap_async_call *call)
+{
+    return pending->op == call->op;
+}
+
+static const struct soap_async_op get_status_op = {
+    "GetStatus", get_status_send, get_status_recv, get_status_coalesce, SAP_STATUS,
+    STI_NONE, NULL
+};
+
+static void status_received(struct soap_async_call *call)
+{
+    struct soap_ptz_shadow *shadow = &call->instance->shadow;
+
+    if (call->error)
+        return;
+
+    shadow->focus = call->args.focus.position;
+    shadow->focus_valid = 1;
+}
+
+static void read_value(struct soap_imaging_snapshot *snapshot, int field, const float *value)
+{
+    if (value == NULL)
+        return;
+
+    snapshot->value[field] = *value;
+    snapshot->have |= FIELD(field);
+}
+
+static void read_mode(struct soap_imaging_snapshot *snapshot, int field, int mode)
+{
+    snapshot->value[field] = mode;
+    snapshot->have |= FIELD(field);
+}
+
+static void read_range(struct soap_imaging_snapshot *snapshot, int field,
+        const struct tt__FloatRange *range)
+{
+    if (range == NULL || range->Max <= range->Min)
+        return;
+
+    snapshot->range[field].min = range->Min;
+    snapshot->range[field].max = range->Max;
+    snapshot->ranged |= FIELD(field);
+}
+
+static int get_options_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__GetOptions getoptions;
+
+    getoptions.VideoSourceToken = video_source_token(call->instance);
+
+    return soap_send___timg__GetOptions(soap, call->xaddr, NULL, &getoptions);
+}
+
+static int get_options_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__GetOptionsResponse getoptions_resp;
+    struct soap_imaging_snapshot *received = &call->instance->imaging.received;
+    const struct tt__ImagingOptions20 *options;
+
+    if (soap_recv___timg__GetOptions(soap, &getoptions_resp) != SOAP_OK)
+        return soap->error;
+
+    if ((options = getoptions_resp.ImagingOptions) == NULL)
+        return SOAP_NO_DATA;
+
+    memset(received, 0, sizeof(*received));
+
+    read_range(received, SIF_BRIGHTNESS, options->Brightness);
+    read_range(received, SIF_SATURATION, options->ColorSaturation);
+
+    if (options->Exposure != NULL) {
+        read_range(received, SIF_IRIS, options->Exposure->Iris);
+        read_range(received, SIF_EXPOSURE_TIME, options->Exposure->ExposureTime);
+        read_range(received, SIF_GAIN, options->Exposure->Gain);
+        read_range(received, SIF_MAX_GAIN, options->Exposure->MaxGain);
+    }
+
+    if (options->WhiteBalance != NULL) {
+        read_range(received, SIF_CR_GAIN, options->WhiteBalance->YrGain);
+        read_range(received, SIF_CB_GAIN, options->WhiteBalance->YbGain);
+    }
+
+    return SOAP_OK;
+}
+
+static const struct soap_async_op get_options_op = {
+    "GetOptions", get_options_send, get_options_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+/* without ranges the settings can still be set to absolute values */
+static void options_received(struct soap_async_call *call)
+{
+    struct soap_imaging *imaging = &call->instance->imaging;
+
+    if (call->error)
+        return;
+
+    for (int i = 0; i < SIF_COUNT; ++i)
+        if (imaging->received.ranged & FIELD(i))
+            imaging->range[i] = imaging->received.range[i];
+
+    imaging->ranged |= imaging->received.ranged;
+}
+
+static int get_settings_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__GetImagingSettings getsettings;
+
+    getsettings.VideoSourceToken = video_source_token(call->instance);
+
+    return soap_send___timg__GetImagingSettings(soap, call->xaddr, NULL, &getsettings);
+}
+
+static int get_settings_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__GetImagingSettingsResponse getsettings_resp;
+    struct soap_imaging_snapshot *received = &call->instance->imaging.received;
+    const struct tt__ImagingSettings20 *settings;
+
+    if (soap_recv___timg__GetImagingSettings(soap, &getsettings_resp) != SOAP_OK)
+        return soap->error;
+
+    if ((settings = getsettings_resp.ImagingSettings) == NULL)
+        return SOAP_NO_DATA;
+
+    memset(received, 0, sizeof(*received));
+
+    if (settings->Exposure != NULL) {
+        read_mode(received, SIF_EXPOSURE_MODE, settings->Exposure->Mode);
+        read_value(received, SIF_IRIS, settings->Exposure->Iris);
+        read_value(received, SIF_EXPOSURE_TIME, settings->Exposure->ExposureTime);
+        read_value(received, SIF_GAIN, settings->Exposure->Gain);
+        read_value(received, SIF_MAX_GAIN, settings->Exposure->MaxGain);
+    }
+
+    read_value(received, SIF_BRIGHTNESS, settings->Brightness);
+    read_value(received, SIF_SATURATION, settings->ColorSaturation);
+
+    if (settings->BacklightCompensation != NULL)
+        read_mode(received, SIF_BACKLIGHT, settings->BacklightCompensation->Mode);
+
+    if (settings->IrCutFilter != NULL)
+        read_mode(received, SIF_IR_CUT_FILTER, *settings->IrCutFilter);
+
+    if (settings->WhiteBalance != NULL) {
+        read_mode(received, SIF_WHITE_BALANCE_MODE, settings->WhiteBalance->Mode);
+        read_value(received, SIF_CR_GAIN, settings->WhiteBalance->CrGain);
+        read_value(received, SIF_CB_GAIN, settings->WhiteBalance->CbGain);
+    }
+
+    if (settings->Focus != NULL)
+        read_mode(received, SIF_FOCUS_MODE, settings->Focus->AutoFocusMode);
+
+    return SOAP_OK;
+}
+
+static const struct soap_async_op get_settings_op = {
+    "GetImagingSettings", get_settings_send, get_settings_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+/* fields changed since the call was sent keep the newer value of the shadow */
+static void settings_received(struct soap_async_call *call)
+{
+    struct soap_imaging *imaging = &call->instance->imaging;
+    unsigned keep = imaging->dirty | imaging->sending;
+
+    if (call->error)
+        return;
+
+    for (int i = 0; i < SIF_COUNT; ++i) {
+        if (!(imaging->received.have & FIELD(i)))
+            continue;
+
+        if (!(imaging->have & FIELD(i)))
+            imaging->initial[i] = imaging->received.value[i];
+
+        if (!(keep & FIELD(i)))
+            imaging->value[i] = imaging->received.value[i];
+    }
+
+    imaging->have |= imaging->received.have;
+    imaging->valid = 1;
+}
+
+static float* sent_field(struct soap_imaging *imaging, int field)
+{
+    return imaging->sending & FIELD(field) ? &imaging->sent[field] : NULL;
+}
+
+/* modes a block of settings requires go along with the block, at the shadow's value */
+static int set_settings_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct soap_imaging *imaging = &call->instance->imaging;
+    struct _timg__SetImagingSettings setsettings;
+    struct tt__ImagingSettings20 settings = { 0 };
+    struct tt__Exposure20 exposure = { 0 };
+    struct tt__BacklightCompensation20 backlight = { 0 };
+    struct tt__WhiteBalance20 white_balance = { 0 };
+    struct tt__FocusConfiguration20 focus = { 0 };
+    enum tt__IrCutFilterMode ir_cut_filter;
+    /* a knob turned on the controller is not worth a write to the camera's flash */
+    enum xsd__boolean persist = xsd__boolean__false_;
+
+    if (imaging->sending & EXPOSURE_FIELDS) {
+        exposure.Mode = (enum tt__ExposureMode)imaging->sent[SIF_EXPOSURE_MODE];
+        exposure.Iris = sent_field(imaging, SIF_IRIS);
+        exposure.ExposureTime = sent_field(imaging, SIF_EXPOSURE_TIME);
+        exposure.Gain = sent_field(imaging, SIF_GAIN);
+        exposure.MaxGain = sent_field(imaging, SIF_MAX_GAIN);
+        settings.Exposure = &exposure;
+    }
+
+    if (imaging->sending & FIELD(SIF_BACKLIGHT)) {
+        backlight.Mode = (enum tt__BacklightCompensationMode)imaging->sent[SIF_BACKLIGHT];
+        settings.BacklightCompensation = &backlight;
+    }
+
+    if (imaging->sending & FIELD(SIF_IR_CUT_FILTER)) {
+        ir_cut_filter = (enum tt__IrCutFilterMode)imaging->sent[SIF_IR_CUT_FILTER];
+        settings.IrCutFilter = &ir_cut_filter;
+    }
+
+    if (imaging->sending & WHITE_BALANCE_FIELDS) {
+        white_balance.Mode = (enum tt__WhiteBalanceMode)imaging->sent[SIF_WHITE_BALANCE_MODE];
+        white_balance.CrGain = sent_field(imaging, SIF_CR_GAIN);
+        white_balance.CbGain = sent_field(imaging, SIF_CB_GAIN);
+        settings.WhiteBalance = &white_balance;
+    }
+
+    if (imaging->sending & FIELD(SIF_FOCUS_MODE)) {
+        focus.AutoFocusMode = (enum tt__AutoFocusMode)imaging->sent[SIF_FOCUS_MODE];
+        settings.Focus = &focus;
+    }
+
+    settings.Brightness = sent_field(imaging, SIF_BRIGHTNESS);
+    settings.ColorSaturation = sent_field(imaging, SIF_SATURATION);
+
+    setsettings.VideoSourceToken = video_source_token(call->instance);
+    setsettings.ImagingSettings = &settings;
+    setsettings.ForcePersistence = &persist;
+
+    return soap_send___timg__SetImagingSettings(soap, call->xaddr, NULL, &setsettings);
+}
+
+static int set_settings_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__SetImagingSettingsResponse setsettings_resp;
+
+    return soap_recv___timg__SetImagingSettings(soap, &setsettings_resp);
+}
+
+static const struct soap_async_op set_settings_op = {
+    "SetImagingSettings", set_settings_send, set_settings_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+/* a camera that refused the settings tells what it has instead */
+static void settings_set(struct soap_async_call *call)
+{
+    struct soap_instance *instance = call->instance;
+    struct soap_imaging *imaging = &instance->imaging;
+
+    imaging->flushing = 0;
+    imaging->sending = 0;
+
+    if (call->error)
+        submit(instance, &get_settings_op, settings_received);
+
+    if (imaging->dirty)
+        timer_wheel_schedule(&imaging->flush_timer, SOAP_IMAGING_FLUSH_MS);
+}
+
+static void flush(void *data)
+{
+    struct soap_instance *instance = data;
+    struct soap_imaging *imaging = &instance->imaging;
+
+    if (imaging->flushing || !imaging->dirty)
+        return;
+
+    memcpy(imaging->sent, imaging->value, sizeof(imaging->sent));
+    imaging->sending = imaging->dirty;
+    imaging->dirty = 0;
+    imaging->flushing = 1;
+
+    submit(instance, &set_settings_op, settings_set);
+}
+
+static int focus_move_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__Move move;
+    struct tt__FocusMove focus = { 0 };
+    struct tt__ContinuousFocus continuous;
+
+    continuous.Speed = call->args.focus.speed;
+    focus.Continuous = &continuous;
+
+    move.VideoSourceToken = video_source_token(call->instance);
+    move.Focus = &focus;
+
+    return soap_send___timg__Move(soap, call->xaddr, NULL, &move);
+}
+
+static int focus_absolute_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__Move move;
+    struct tt__FocusMove focus = { 0 };
+    struct tt__AbsoluteFocus absolute;
+
+    absolute.Position = call->args.focus.position;
+    absolute.Speed = NULL;
+    focus.Absolute = &absolute;
+
+    move.VideoSourceToken = video_source_token(call->instance);
+    move.Focus = &focus;
+
+    return soap_send___timg__Move(soap, call->xaddr, NULL, &move);
+}
+
+static int focus_move_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__MoveResponse move_resp;
+
+    return soap_recv___timg__Move(soap, &move_resp);
+}
+
+static int focus_stop_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__Stop stop;
+
+    stop.VideoSourceToken = video_source_token(call->instance);
+
+    return soap_send___timg__Stop(soap, call->xaddr, NULL, &stop);
+}
+
+static int focus_stop_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _timg__StopResponse stop_resp;
+
+    return soap_recv___timg__Stop(soap, &stop_resp);
+}
+
+/* a newer focus command supersedes the one still queued, a stop the move before it too */
+static int focus_coalesce(struct soap_async_call *pending, const struct soap_async_call *call)
+{
+    pending->op = call->op;
+    pending->args.focus = call->args.focus;
+
+    return 1;
+}
+
+static const struct soap_async_op focus_move_op = {
+    "Move", focus_move_send, focus_move_recv, focus_coalesce, SAP_VELOCITY, STI_NONE, NULL
+};
+
+static const struct soap_async_op focus_absolute_op = {
+    "Move", focus_absolute_send, focus_move_recv, focus_coalesce, SAP_VELOCITY, STI_NONE, NULL
+};
+
+static const struct soap_async_op focus_stop_op = {
+    "Stop", focus_stop_send, focus_stop_recv, focus_coalesce, SAP_VELOCITY, STI_NONE, NULL
+};
+
+/* for the camera the current visca message is addressed to. returns NULL while the camera
+   is still bootstrapping or has no imaging service */
+static struct soap_instance* imaging_instance(const char *what)
+{
+    struct soap_instance *instance = address_mngr_get_soap_instance_from_fd(g_current_event_fd);
+
+    if (!atomic_load(&instance->ready)) {
+        log("%s is not ready yet, dropping %s", instance->service_endpoint, what);
+        return NULL;
+    }
+
+    if (instance->imaging_xaddr == NULL || video_source_token(instance) == NULL) {
+        log("%s has no imaging, dropping %s", instance->service_endpoint, what);
+        return NULL;
+    }
+
+    return instance;
+}
+
+/* returns NULL unless the camera reported the field */
+static struct soap_imaging* settings_of(int field)
+{
+    struct soap_instance *instance = imaging_instance(field_names[field]);
+
+    if (instance == NULL)
+        return NULL;
+
+    if (!(instance->imaging.have & FIELD(field))) {
+        log("%s has no %s setting, dropping it", instance->service_endpoint, field_names[field]);
+        return NULL;
+    }
+
+    return &instance->imaging;
+}
+
+static struct soap_imaging* ranged_settings_of(int field)
+{
+    struct soap_imaging *imaging = settings_of(field);
+
+    if (imaging != NULL && !(imaging->ranged & FIELD(field))) {
+        log("no range is known for %s, dropping it", field_names[field]);
+        return NULL;
+    }
+
+    return imaging;
+}
+
+/* the first change opens the flush window, later ones ride along with it */
+static void change(struct soap_imaging *imaging, int field, float value)
+{
+    if (imaging->ranged & FIELD(field)) {
+        if (value < imaging->range[field].min)
+            value = imaging->range[field].min;
+        if (value > imaging->range[field].max)
+            value = imaging->range[field].max;
+    }
+
+    if (imaging->value[field] == value)
+        return;
+
+    imaging->value[field] = value;
+    imaging->dirty |= FIELD(field);
+
+    if (!imaging->flushing && !timer_wheel_pending(&imaging->flush_timer))
+        timer_wheel_schedule(&imaging->flush_timer, SOAP_IMAGING_FLUSH_MS);
+}
+
+void soap_imaging_construct(struct soap_imaging *imaging, struct soap_instance *instance)
+{
+    memset(imaging, 0, sizeof(*imaging));
+
+    /* modes range over their onvif enum */
+    imaging->range[SIF_EXPOSURE_MODE].max = tt__ExposureMode__MANUAL;
+    imaging->range[SIF_BACKLIGHT].max = tt__BacklightCompensationMode__ON;
+    imaging->range[SIF_IR_CUT_FILTER].max = tt__IrCutFilterMode__AUTO;
+    imaging->range[SIF_WHITE_BALANCE_MODE].max = tt__WhiteBalanceMode__MANUAL;
+    imaging->range[SIF_FOCUS_MODE].max = tt__AutoFocusMode__MANUAL;
+    imaging->ranged = FIELD(SIF_EXPOSURE_MODE) | FIELD(SIF_BACKLIGHT) | FIELD(SIF_IR_CUT_FILTER)
+        | FIELD(SIF_WHITE_BALANCE_MODE) | FIELD(SIF_FOCUS_MODE);
+
+    wheel_timer_init(&imaging->flush_timer, flush, instance);
+}
+
+/* seeds the shadow, runs on the instance's shard once the instance is ready */
+void soap_imaging_start(struct soap_instance *instance)
+{
+    if (instance->imaging.valid || instance->imaging_xaddr == NULL
+            || video_source_token(instance) == NULL)
+        return;
+
+    submit(instance, &get_options_op, options_received);
+    submit(instance, &get_settings_op, settings_received);
+}
+
+/* updates the focus position of the instance's shadow, runs on the instance's shard */
+void soap_imaging_refresh_status(struct soap_instance *instance)
+{
+    if (instance->imaging_xaddr == NULL || video_source_token(instance) == NULL)
+        return;
+
+    submit(instance, &get_status_op, status_received);
+}
+
+/* value in the unit of the onvif setting, a mode as its enum */
+void soap_imaging_set(int field, float value)
+{
+    struct soap_imaging *imaging = settings_of(field);
+
+    if (imaging != NULL)
+        change(imaging, field, value);
+}
+
+/* fraction from 0 to 1 of the range the camera allows */
+void soap_imaging_set_fraction(int field, float fraction)
+{
+    struct soap_imaging *imaging = ranged_settings_of(field);
+    struct soap_imaging_range *range;
+
+    if (imaging == NULL)
+        return;
+
+    range = &imaging->range[field];
+
+    change(imaging, field, range->min + fraction * (range->max - range->min));
+}
+
+/* moves the setting by steps out of step_count that span the range */
+void soap_imaging_step(int field, int steps, int step_count)
+{
+    struct soap_imaging *imaging = ranged_settings_of(field);
+    struct soap_imaging_range *range;
+
+    if (imaging == NULL)
+        return;
+
+    range = &imaging->range[field];
+
+    change(imaging, field, imaging->value[field] + steps * (range->max - range->min) / step_count);
+}
+
+void soap_imaging_reset(int field)
+{
+    struct soap_imaging *imaging = settings_of(field);
+
+    if (imaging != NULL)
+        change(imaging, field, imaging->initial[field]);
+}
+
+/* for modes with two values */
+void soap_imaging_toggle(int field)
+{
+    struct soap_imaging *imaging = settings_of(field);
+
+    if (imaging != NULL)
+        change(imaging, field, imaging->range[field].max - imaging->value[field]);
+}
+
+/* speed from -1 (near) to 1 (far) */
+void soap_imaging_focus_continuous(float speed)
+{
+    struct soap_instance *instance = imaging_instance(focus_move_op.name);
+    struct soap_async_call *call;
+
+    if (instance == NULL)
+        return;
+
+    call = soap_async_call_new(instance, &instance->imaging_queue, &focus_move_op,
+            instance->imaging_xaddr);
+    call->args.focus.speed = speed;
+
+    soap_async_submit(call);
+}
+
+/* position from 0 (infinity) to 1 (near), the same scale the focus inquiry reports */
+void soap_imaging_focus_absolute(float position)
+{
+    struct soap_instance *instance = imaging_instance(focus_absolute_op.name);
+    struct soap_async_call *call;
+
+    if (instance == NULL)
+        return;
+
+    call = soap_async_call_new(instance, &instance->imaging_queue, &focus_absolute_op,
+            instance->imaging_xaddr);
+    call->args.focus.position = position;
+
+    soap_async_submit(call);
+}
+
+void soap_imaging_focus_stop()
+{
+    struct soap_instance *instance = imaging_instance(focus_stop_op.name);
+
+    if (instance != NULL)
+        submit(instance, &focus_stop_op, NULL);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "timer_wheel.h"
+
+/* commands that arrive within this window go out in one SetImagingSettings */
+#define SOAP_IMAGING_FLUSH_MS 100
+
+struct soap_instance;
+
+/* the imaging settings visca commands change. modes hold the value of their onvif enum */
+enum soap_imaging_field
+{
+    SIF_EXPOSURE_MODE = 0,
+    SIF_IRIS,
+    SIF_EXPOSURE_TIME,
+    SIF_GAIN,
+    SIF_MAX_GAIN,
+    SIF_BRIGHTNESS,
+    SIF_BACKLIGHT,
+    SIF_IR_CUT_FILTER,
+    SIF_WHITE_BALANCE_MODE,
+    SIF_CR_GAIN,
+    SIF_CB_GAIN,
+    SIF_SATURATION,
+    SIF_FOCUS_MODE,
+    SIF_COUNT,
+};
+
+struct soap_imaging_range
+{
+    float min, max;
+};
+
+/* what one GetOptions or GetImagingSettings call read. the imaging queue runs one call at a
+   time, so its recv() fills it and its done() takes it over on the shard */
+struct soap_imaging_snapshot
+{
+    /* fields the camera reported, as bits of soap_imaging_field */
+    unsigned have, ranged;
+    float value[SIF_COUNT];
+    struct soap_imaging_range range[SIF_COUNT];
+};
+
+/* shadow copy of the camera's imaging settings. commands change it and mark their fields
+   dirty, the flush timer sends all dirty fields in one SetImagingSettings. only the event
+   loop of the camera's shard touches it, except for received and sent which belong to the
+   call in flight */
+struct soap_imaging
+{
+    /* set once the camera reported its settings, until then commands are dropped */
+    int valid;
+    unsigned have, ranged, dirty;
+    float value[SIF_COUNT];
+    /* what the camera had when it was first read, visca resets go back to it */
+    float initial[SIF_COUNT];
+    struct soap_imaging_range range[SIF_COUNT];
+    struct wheel_timer flush_timer;
+    /* a SetImagingSettings is queued or in flight, fields dirtied meanwhile wait for it */
+    int flushing;
+    unsigned sending;
+    float sent[SIF_COUNT];
+    struct soap_imaging_snapshot received;
+};
+
+void soap_imaging_construct(struct soap_imaging *imaging, struct soap_instance *instance);
+void soap_imaging_start(struct soap_instance *instance);
+void soap_imaging_refresh_status(struct soap_instance *instance);
+void soap_imaging_set(int field, float value);
+void soap_imaging_set_fraction(int field, float fraction);
+void soap_imaging_step(int field, int steps, int step_count);
+void soap_imaging_reset(int field);
+void soap_imaging_toggle(int field);
+void soap_imaging_focus_continuous(float speed);
+void soap_imaging_focus_absolute(float position);
+void soap_imaging_focus_stop();
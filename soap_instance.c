@@ -1,6 +1,10 @@
 #include "soap_instance.h"
+#include "soap_namespaces.h"
+#include "soap_ptz.h"
 #include "soap_utils.h"
+#include "worker.h"
 #include "log.h"
+#include <string.h>
 
 #define MAX_URL_STRING_LEN 256
 
@@ -11,19 +15,17 @@ static void set_endpoint(struct soap_instance* instance, const char *address)
         die(ERR_WRITE, "serivce endpoint string overflow");
 }
 
-struct soap_instance* soap_instance_allocate(const char *address)
+struct soap_instance* soap_instance_allocate(const char *address, int shard)
 {
     struct soap_instance *instance = malloc(sizeof(struct soap_instance));
     if (!instance)
         die(ERR_NOMEM, "failed to allocate soap_instance");
 
-    instance->services = malloc(sizeof(services_t));
-    if (instance->services == NULL)
-        die(ERR_ALLOC, "failed to allocate services");
-
-    instance->profiles = malloc(sizeof(profiles_t));
-    if (instance->profiles == NULL)
-        die(ERR_ALLOC, "failed to allocate profiles");
+    instance->services = NULL;
+    instance->profiles = NULL;
+    instance->caps = instance->retired_caps = NULL;
+    instance->profile = NULL;
+    instance->ptz_xaddr = instance->imaging_xaddr = instance->events_xaddr = NULL;
 
     instance->service_endpoint = malloc(MAX_URL_STRING_LEN);
     if (instance->service_endpoint == NULL)
@@ -31,35 +33,198 @@ struct soap_instance* soap_instance_allocate(const char *address)
 
     set_endpoint(instance, address);
 
-    log("getting services for %s", instance->service_endpoint);
+    atomic_init(&instance->ready, 0);
 
-    if (soap_utils_get_services(g_soap, instance->service_endpoint, instance->services) != 0)
-        return NULL;
+    instance->profile_idx = 0;
 
-    soap_utils_get_profiles(g_soap, soap_utils_get_media_xaddr(instance->services), instance->profiles);
+    instance->shard = shard;
 
-    instance->profile_idx = 0;
+    soap_async_queue_construct(&instance->ptz_queue, shard, soap_namespaces_ptz,
+            &instance->breaker);
+    soap_async_queue_construct(&instance->imaging_queue, shard, soap_namespaces_imaging, NULL);
+    soap_events_construct(&instance->events, instance, shard);
+    soap_poller_construct(&instance->poller, instance);
+    soap_imaging_construct(&instance->imaging, instance);
+    soap_pool_construct(&instance->pool);
+    soap_breaker_construct(&instance->breaker, instance->service_endpoint, soap_ptz_probe, instance);
 
-    instance->current_preset = 0;
-    instance->preset_range_min = 1;
-    instance->preset_range_max = 3;
+    memset(instance->templates, 0, sizeof(instance->templates));
+    memset(&instance->shadow, 0, sizeof(instance->shadow));
 
     return instance;
 }
 
+static void use_caps(struct soap_instance *instance, struct camera_caps *caps)
+{
+    camera_caps_free(instance->retired_caps);
+    instance->retired_caps = instance->caps;
+
+    instance->caps = caps;
+    instance->services = caps->services;
+    instance->profiles = caps->profiles;
+
+    if (instance->profile_idx >= instance->profiles->__sizeProfiles) {
+        log("%s has no profile %d, using profile 0", instance->service_endpoint,
+                instance->profile_idx);
+        instance->profile_idx = 0;
+    }
+
+    instance->profile = &instance->profiles->Profiles[instance->profile_idx];
+    instance->ptz_xaddr = soap_utils_get_ptz_xaddr(instance->services);
+    instance->imaging_xaddr = soap_utils_get_imaging_xaddr(instance->services);
+    instance->events_xaddr = soap_utils_get_events_xaddr(instance->services);
+
+    soap_ptz_build_templates(instance);
+}
+
+/* runs on the instance's shard once the instance is ready, from then on its shadow follows
+   the camera's events or, without them, a poller */
+static void start_watching(void *data)
+{
+    struct soap_instance *instance = data;
+
+    soap_imaging_start(instance);
+    soap_events_start(instance);
+    soap_poller_start(instance);
+}
+
+/* makes the camera usable with what the last run learned about it, the bootstrap then
+   revalidates it in the background. returns 1 if the camera is not in the cache */
+int soap_instance_warm_start(struct soap_instance *instance)
+{
+    struct camera_caps *caps = camera_cache_find(instance->service_endpoint);
+
+    if (caps == NULL)
+        return 1;
+
+    use_caps(instance, caps);
+
+    atomic_store(&instance->ready, 1);
+    worker_run_on_shard(instance->shard, start_watching, instance);
+
+    log("%s is ready from the cache", instance->service_endpoint);
+
+    return 0;
+}
+
+struct caps_swap
+{
+    struct soap_instance *instance;
+    struct camera_caps *caps;
+};
+
+/* runs on the instance's shard, which is the only one using its templates */
+static void swap_caps(void *data)
+{
+    struct caps_swap *swap = data;
+
+    use_caps(swap->instance, swap->caps);
+
+    free(swap);
+}
+
+/* runs on a bootstrap thread with its own g_soap. the answers are copied into caps, so the
+   context is emptied again afterwards */
+int soap_instance_bootstrap(struct soap_instance *instance)
+{
+    services_t services;
+    profiles_t profiles;
+    device_info_t device_info = { 0 };
+    struct camera_caps *caps;
+    struct caps_swap *swap;
+    int err = 1;
+
+    log("getting services for %s", instance->service_endpoint);
+
+    if (soap_utils_get_services(g_soap, instance->service_endpoint, &services) != 0
+            || soap_utils_get_profiles(g_soap, soap_utils_get_media_xaddr(&services), &profiles) != 0)
+        goto out;
+
+    soap_utils_get_device_information(g_soap, instance->service_endpoint, &device_info);
+    soap_utils_resolve_xaddrs(g_soap, &services);
+
+    log("instance addr = %s", instance->service_endpoint);
+    soap_utils_list_profiles(&profiles);
+
+    caps = camera_caps_from_soap(instance->service_endpoint, device_info.SerialNumber, &services,
+            &profiles);
+    if (caps == NULL) {
+        log("%s returned no usable services or profiles", instance->service_endpoint);
+        goto out;
+    }
+
+    err = 0;
+
+    if (!atomic_load(&instance->ready)) {
+        use_caps(instance, caps);
+        atomic_store(&instance->ready, 1);
+        worker_run_on_shard(instance->shard, start_watching, instance);
+        log("%s is ready", instance->service_endpoint);
+    } else if (camera_caps_equal(instance->caps, caps)) {
+        log("%s matches the cache", instance->service_endpoint);
+        camera_caps_free(caps);
+        goto out;
+    } else {
+        log("%s changed since it was cached, updating", instance->service_endpoint);
+
+        swap = malloc(sizeof(struct caps_swap));
+        if (swap == NULL)
+            die(ERR_NOMEM, "failed to malloc(%zd)", sizeof(struct caps_swap));
+
+        swap->instance = instance;
+        swap->caps = caps;
+
+        worker_run_on_shard(instance->shard, swap_caps, swap);
+    }
+
+    camera_cache_store(caps);
+
+out:
+    soap_destroy(g_soap);
+    soap_end(g_soap);
+
+    return err;
+}
+
+/* calls from the event loop of the instance's shard can go to the camera */
+int soap_instance_in_service(struct soap_instance *instance)
+{
+    return atomic_load(&instance->ready) && instance->breaker.state == SBS_CLOSED;
+}
+
+/* from the config, before the instance makes any call */
+void soap_instance_set_auth_mode(struct soap_instance *instance, int mode)
+{
+    instance->ptz_queue.auth.mode = mode;
+    instance->imaging_queue.auth.mode = mode;
+    instance->events.queue.auth.mode = mode;
+}
+
+/* the device information is only logged, the context is emptied right after */
 void soap_instance_print_info(struct soap_instance *instance)
 {
     log("instance addr = %s", instance->service_endpoint);
 
     soap_utils_print_device_info(g_soap, instance->service_endpoint);
 
+    soap_destroy(g_soap);
+    soap_end(g_soap);
+
     soap_utils_list_profiles(instance->profiles);
 }
 
 void soap_instance_deallocate(struct soap_instance *instance)
 {
-    free(instance->services);
-    free(instance->profiles);
+    soap_async_queue_destruct(&instance->ptz_queue);
+    soap_async_queue_destruct(&instance->imaging_queue);
+    soap_events_destruct(&instance->events);
+    soap_pool_destruct(&instance->pool);
+
+    for (int i = 0; i < STI_COUNT; ++i)
+        soap_template_destruct(&instance->templates[i]);
+
+    camera_caps_free(instance->caps);
+    camera_caps_free(instance->retired_caps);
     free(instance->service_endpoint);
     free(instance);
 }
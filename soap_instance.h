@@ -1,19 +1,56 @@
 #pragma once
 
+#include "camera_cache.h"
+#include "soap_async.h"
+#include "soap_breaker.h"
+#include "soap_events.h"
+#include "soap_imaging.h"
+#include "soap_poller.h"
 #include "soap_header.h"
+#include <stdatomic.h>
+
+/* what the camera last reported about its position, so inquiries are answered without a
+   round trip. only the event loop of the instance's shard touches it */
+struct soap_ptz_shadow
+{
+    float pan, tilt, zoom, focus;
+    int moving;
+    int valid, focus_valid;
+};
 
 struct soap_instance
 {
     char *service_endpoint;
+    /* point into caps. a revalidation that finds new capabilities retires the old ones
+       instead of freeing them, a soap thread may still be reading them */
     services_t *services;
     profiles_t *profiles;
+    struct camera_caps *caps, *retired_caps;
     int profile_idx;
-    int current_preset;
-    int preset_range_min;
-    int preset_range_max;
+    /* resolved from caps by use_caps(), so calls don't search services and profiles. the
+       xaddrs are NULL for services the camera lacks */
+    profile_t *profile;
+    const char *ptz_xaddr, *imaging_xaddr, *events_xaddr;
+    int shard;
+    /* set once the onvif bootstrap finished, until then calls to the camera are dropped */
+    atomic_int ready;
+    struct soap_async_queue ptz_queue;
+    struct soap_async_queue imaging_queue;
+    struct soap_events events;
+    struct soap_ptz_shadow shadow;
+    struct soap_imaging imaging;
+    struct soap_poller poller;
+    struct soap_pool pool;
+    struct soap_breaker breaker;
+    /* pre-serialized requests of the hot ptz operations, see soap_ptz_build_templates() */
+    struct soap_template templates[STI_COUNT];
 };
 
-struct soap_instance* soap_instance_allocate(const char *address);
+struct soap_instance* soap_instance_allocate(const char *address, int shard);
+int soap_instance_warm_start(struct soap_instance *instance);
+int soap_instance_bootstrap(struct soap_instance *instance);
+int soap_instance_in_service(struct soap_instance *instance);
+void soap_instance_set_auth_mode(struct soap_instance *instance, int mode);
 void soap_instance_print_info(struct soap_instance *instance);
 void soap_instance_deallocate(struct soap_instance *instance);
 
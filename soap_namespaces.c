@@ -0,0 +1,59 @@
+#include "soap_namespaces.h"
+
+/* gsoap expects the envelope, encoding and schema namespaces first, in this order. wsse and
+   wsu carry the credentials, ter the subcodes of onvif faults */
+#define SOAP_NAMESPACES_COMMON \
+    { "SOAP-ENV", "http://www.w3.org/2003/05/soap-envelope", \
+        "http://schemas.xmlsoap.org/soap/envelope/", NULL }, \
+    { "SOAP-ENC", "http://www.w3.org/2003/05/soap-encoding", \
+        "http://schemas.xmlsoap.org/soap/encoding/", NULL }, \
+    { "xsi", "http://www.w3.org/2001/XMLSchema-instance", \
+        "http://www.w3.org/*/XMLSchema-instance", NULL }, \
+    { "xsd", "http://www.w3.org/2001/XMLSchema", "http://www.w3.org/*/XMLSchema", NULL }, \
+    { "wsse", "http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-secext-1.0.xsd", \
+        "http://docs.oasis-open.org/wss/oasis-wss-wssecurity-secext-1.1.xsd", NULL }, \
+    { "wsu", "http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-utility-1.0.xsd", \
+        NULL, NULL }, \
+    { "tt", SOAP_NAMESPACE_OF_tt, NULL, NULL }, \
+    { "ter", "http://www.onvif.org/ver10/error", NULL, NULL }
+
+const struct Namespace soap_namespaces_device[] = {
+    SOAP_NAMESPACES_COMMON,
+    { "tds", SOAP_NAMESPACE_OF_tds, NULL, NULL },
+    { NULL, NULL, NULL, NULL }
+};
+
+/* profiles carry the event filters of their metadata configuration */
+const struct Namespace soap_namespaces_media[] = {
+    SOAP_NAMESPACES_COMMON,
+    { "wsa5", "http://www.w3.org/2005/08/addressing",
+        "http://schemas.xmlsoap.org/ws/2004/08/addressing", NULL },
+    { "wsnt", "http://docs.oasis-open.org/wsn/b-2", NULL, NULL },
+    { "wstop", "http://docs.oasis-open.org/wsn/t-1", NULL, NULL },
+    { "trt", SOAP_NAMESPACE_OF_trt, NULL, NULL },
+    { NULL, NULL, NULL, NULL }
+};
+
+const struct Namespace soap_namespaces_ptz[] = {
+    SOAP_NAMESPACES_COMMON,
+    { "tptz", SOAP_NAMESPACE_OF_tptz, NULL, NULL },
+    { NULL, NULL, NULL, NULL }
+};
+
+const struct Namespace soap_namespaces_imaging[] = {
+    SOAP_NAMESPACES_COMMON,
+    { "timg", SOAP_NAMESPACE_OF_timg, NULL, NULL },
+    { NULL, NULL, NULL, NULL }
+};
+
+/* notifications carry their topic and payload in the ws-notification namespaces */
+const struct Namespace soap_namespaces_events[] = {
+    SOAP_NAMESPACES_COMMON,
+    { "wsa5", "http://www.w3.org/2005/08/addressing",
+        "http://schemas.xmlsoap.org/ws/2004/08/addressing", NULL },
+    { "wsnt", "http://docs.oasis-open.org/wsn/b-2", NULL, NULL },
+    { "wstop", "http://docs.oasis-open.org/wsn/t-1", NULL, NULL },
+    { "tns1", "http://www.onvif.org/ver10/topics", NULL, NULL },
+    { "tev", SOAP_NAMESPACE_OF_tev, NULL, NULL },
+    { NULL, NULL, NULL, NULL }
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "soap_header.h"
+
+/* gsoap declares every namespace of its table on each envelope. with the 48 entries generated
+   from all the onvif wsdls a signed GetStatus is about 3.7 kB, with the ptz table 1.7 kB, so
+   every service gets its own table with just the namespaces its messages use. make ns-size
+   measures the requests with either table */
+extern const struct Namespace soap_namespaces_device[];
+extern const struct Namespace soap_namespaces_media[];
+extern const struct Namespace soap_namespaces_ptz[];
+extern const struct Namespace soap_namespaces_imaging[];
+extern const struct Namespace soap_namespaces_events[];
@@ -0,0 +1,66 @@
+#include "soap_poller.h"
+#include "soap_instance.h"
+#include "soap_ptz.h"
+
+static int is_moving(struct soap_instance *instance)
+{
+    struct soap_poller *poller = &instance->poller;
+
+    return poller->moving || instance->shadow.moving
+        || timer_wheel_now_ms() < poller->moving_until;
+}
+
+static void schedule(struct soap_poller *poller, uint64_t delay_ms)
+{
+    poller->next_poll = timer_wheel_now_ms() + delay_ms;
+
+    timer_wheel_schedule(&poller->timer, delay_ms);
+}
+
+/* events carry no positions, so a moving camera is polled all the same. at rest one whose
+   events have told about ptz before is only watched, in case its subscription goes away. one
+   that has not answered the last GetStatus yet is not asked again */
+static void poll(void *data)
+{
+    struct soap_instance *instance = data;
+    struct soap_events *events = &instance->events;
+    int moving = is_moving(instance);
+    int evented = events->state == SES_PULLING && events->ptz_seen;
+
+    if ((moving || !evented) && !soap_async_busy(&instance->ptz_queue, SAP_STATUS))
+        soap_ptz_refresh_status(instance);
+
+    schedule(&instance->poller, moving ? SOAP_POLLER_MOVING_MS : SOAP_POLLER_IDLE_MS);
+}
+
+void soap_poller_construct(struct soap_poller *poller, struct soap_instance *instance)
+{
+    poller->next_poll = 0;
+    poller->moving = 0;
+    poller->moving_until = 0;
+
+    wheel_timer_init(&poller->timer, poll, instance);
+}
+
+/* runs on the instance's shard once the instance is ready */
+void soap_poller_start(struct soap_instance *instance)
+{
+    if (!timer_wheel_pending(&instance->poller.timer))
+        poll(instance);
+}
+
+/* called for every ptz command: moving tells if the camera moves until it is told to stop,
+   settle_ms how long it may keep moving after that */
+void soap_poller_moving(struct soap_instance *instance, int moving, uint64_t settle_ms)
+{
+    struct soap_poller *poller = &instance->poller;
+    uint64_t now = timer_wheel_now_ms();
+
+    poller->moving = moving;
+
+    if (now + settle_ms > poller->moving_until)
+        poller->moving_until = now + settle_ms;
+
+    if (poller->next_poll > now + SOAP_POLLER_MOVING_MS)
+        schedule(poller, SOAP_POLLER_MOVING_MS);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "timer_wheel.h"
+
+/* status polling rates while the camera moves and while it is at rest */
+#define SOAP_POLLER_MOVING_MS 200
+#define SOAP_POLLER_IDLE_MS 5000
+/* how long the camera counts as moving after a stop or a goto, its status may lag behind */
+#define SOAP_POLLER_SETTLE_MS 1000
+#define SOAP_POLLER_GOTO_MS 5000
+
+struct soap_instance;
+
+/* keeps the ptz shadow of a moving camera, and of one without ptz events, fresh with GetStatus
+   calls. only the event loop of the camera's shard touches it */
+struct soap_poller
+{
+    struct wheel_timer timer;
+    uint64_t next_poll;
+    /* a continuous move with a velocity is going on */
+    int moving;
+    uint64_t moving_until;
+};
+
+void soap_poller_construct(struct soap_poller *poller, struct soap_instance *instance);
+void soap_poller_start(struct soap_instance *instance);
+void soap_poller_moving(struct soap_instance *instance, int moving, uint64_t settle_ms);
@@ -0,0 +1,101 @@
+#define _GNU_SOURCE
+
+#include "soap_pool.h"
+#include "log.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static void drop(struct soap_pool_conn *conn)
+{
+    close(conn->fd);
+    conn->fd = -1;
+}
+
+/* the camera would close it on its own sooner or later, don't hold it forever */
+static void reap(void *data)
+{
+    struct soap_pool_conn *conn = data;
+
+    log("soap_pool: closing idle connection fd = %d to %s:%s", conn->fd, conn->host, conn->port);
+
+    drop(conn);
+}
+
+/* an idle connection must have nothing to read, eof or stray data means it is unusable */
+static int is_alive(int fd)
+{
+    char c;
+    ssize_t len = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+    return len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+void soap_pool_construct(struct soap_pool *pool)
+{
+    for (int i = 0; i < SOAP_POOL_SIZE; ++i) {
+        pool->conns[i].fd = -1;
+        wheel_timer_init(&pool->conns[i].idle_timer, reap, &pool->conns[i]);
+    }
+}
+
+/* the event loops are gone by now and their wheels never run again, only close the sockets */
+void soap_pool_destruct(struct soap_pool *pool)
+{
+    for (int i = 0; i < SOAP_POOL_SIZE; ++i)
+        if (pool->conns[i].fd != -1)
+            drop(&pool->conns[i]);
+}
+
+/* returns a connected socket to host:port or -1 if there is none to reuse */
+int soap_pool_acquire(struct soap_pool *pool, const char *host, const char *port)
+{
+    struct soap_pool_conn *conn;
+    int fd;
+
+    for (int i = 0; i < SOAP_POOL_SIZE; ++i) {
+        conn = &pool->conns[i];
+
+        if (conn->fd == -1 || strcmp(conn->host, host) != 0 || strcmp(conn->port, port) != 0)
+            continue;
+
+        timer_wheel_cancel(&conn->idle_timer);
+
+        if (!is_alive(conn->fd)) {
+            log("soap_pool: connection fd = %d to %s:%s went away", conn->fd, host, port);
+            drop(conn);
+            continue;
+        }
+
+        fd = conn->fd;
+        conn->fd = -1;
+
+        return fd;
+    }
+
+    return -1;
+}
+
+/* takes over fd, it is closed if the pool is full */
+void soap_pool_release(struct soap_pool *pool, int fd, const char *host, const char *port)
+{
+    struct soap_pool_conn *conn;
+
+    for (int i = 0; i < SOAP_POOL_SIZE; ++i) {
+        conn = &pool->conns[i];
+
+        if (conn->fd != -1)
+            continue;
+
+        conn->fd = fd;
+        snprintf(conn->host, SOAP_POOL_MAX_HOST_LEN, "%s", host);
+        snprintf(conn->port, SOAP_POOL_MAX_PORT_LEN, "%s", port);
+
+        timer_wheel_schedule(&conn->idle_timer, SOAP_POOL_IDLE_MS);
+
+        return;
+    }
+
+    close(fd);
+}
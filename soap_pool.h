@@ -0,0 +1,28 @@
+#pragma once
+
+#include "timer_wheel.h"
+
+#define SOAP_POOL_MAX_HOST_LEN 256
+#define SOAP_POOL_MAX_PORT_LEN 8
+#define SOAP_POOL_SIZE 4
+#define SOAP_POOL_IDLE_MS 20000
+
+/* an idle http/1.1 connection the camera agreed to keep alive, fd is -1 while unused */
+struct soap_pool_conn
+{
+    int fd;
+    char host[SOAP_POOL_MAX_HOST_LEN];
+    char port[SOAP_POOL_MAX_PORT_LEN];
+    struct wheel_timer idle_timer;
+};
+
+/* kept-alive connections of one camera. only the event loop of the camera's shard touches it */
+struct soap_pool
+{
+    struct soap_pool_conn conns[SOAP_POOL_SIZE];
+};
+
+void soap_pool_construct(struct soap_pool *pool);
+void soap_pool_destruct(struct soap_pool *pool);
+int soap_pool_acquire(struct soap_pool *pool, const char *host, const char *port);
+void soap_pool_release(struct soap_pool *pool, int fd, const char *host, const char *port);
@@ -1,29 +1,68 @@
 #include "soap_ptz.h"
+#include "soap_poller.h"
 #include "soap_utils.h"
+#include <string.h>
 
-#define soap_ptz_prelude() \
-    soap_t *soap = g_soap; \
-    struct soap_instance *instance = address_mngr_get_soap_instance_from_fd(g_current_event_fd); \
-    const char *ptz_xaddr = soap_utils_get_ptz_xaddr(instance->services); \
-    profile_t *profile = &instance->profiles->Profiles[instance->profile_idx]; \
-    char *profile_token = profile->token; \
-    soap_utils_auth();
+#define soap_ptz_prelude(C) \
+    struct soap_instance *instance = (C)->instance; \
+    profile_t *profile = instance->profile; \
+    char *profile_token = profile->token;
 
-void soap_ptz_continuous_move(float pan_x, float pan_y, float zoom)
+/* returns NULL while the camera is still bootstrapping, is out of service or can't pan */
+static struct soap_async_call* instance_call_new(struct soap_instance *instance,
+        const struct soap_async_op *op)
+{
+    if (!atomic_load(&instance->ready)) {
+        log("%s is not ready yet, dropping %s", instance->service_endpoint, op->name);
+        return NULL;
+    }
+
+    if (!soap_breaker_admit(&instance->breaker, 0)) {
+        log("%s is out of service, dropping %s", instance->service_endpoint, op->name);
+        return NULL;
+    }
+
+    if (instance->ptz_xaddr == NULL || instance->profile->PTZConfiguration == NULL) {
+        log("%s has no ptz, dropping %s", instance->service_endpoint, op->name);
+        return NULL;
+    }
+
+    return soap_async_call_new(instance, &instance->ptz_queue, op, instance->ptz_xaddr);
+}
+
+/* for the camera the current visca message is addressed to */
+static struct soap_async_call* ptz_call_new(const struct soap_async_op *op)
+{
+    return instance_call_new(address_mngr_get_soap_instance_from_fd(g_current_event_fd), op);
+}
+
+/* appends space="..." unless the profile leaves the space to the camera's default */
+static void template_space(struct soap_template *t, const char *space)
+{
+    if (space == NULL) {
+        soap_template_append(t, "\"");
+        return;
+    }
+
+    soap_template_append(t, "\" space=\"");
+    soap_template_append_escaped(t, space);
+    soap_template_append(t, "\"");
+}
+
+static int continuous_move_send(soap_t *soap, struct soap_async_call *call)
 {
     struct _tptz__ContinuousMove move;
-    struct _tptz__ContinuousMoveResponse move_resp;
     struct tt__PTZSpeed velocity;
     struct tt__Vector2D pantilt;
     struct tt__Vector1D zoom_s;
 
-    soap_ptz_prelude();
+    soap_ptz_prelude(call);
 
-    pantilt.x = pan_x;
-    pantilt.y = pan_y;
+    pantilt.x = call->args.move.pan_x;
+    pantilt.y = call->args.move.pan_y;
     pantilt.space = profile->PTZConfiguration->DefaultContinuousPanTiltVelocitySpace;
 
-    zoom_s.x = zoom;
+    zoom_s.x = call->args.move.zoom;
     zoom_s.space = profile->PTZConfiguration->DefaultContinuousZoomVelocitySpace;
 
     velocity.PanTilt = &pantilt;
@@ -31,45 +70,209 @@ void soap_ptz_continuous_move(float pan_x, float pan_y, float zoom)
 
     move.Velocity = &velocity;
     move.ProfileToken = profile_token;
+    move.Timeout = NULL;
 
-    if (soap_call___tptz__ContinuousMove(soap, ptz_xaddr, NULL, &move, &move_resp) != SOAP_OK)
-        soap_die(soap, "failed to do continous move");
+    return soap_send___tptz__ContinuousMove(soap, call->xaddr, NULL, &move);
 }
 
-void soap_ptz_goto_home()
+static int continuous_move_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__ContinuousMoveResponse move_resp;
+
+    return soap_recv___tptz__ContinuousMove(soap, &move_resp);
+}
+
+static const struct soap_async_op continuous_move_op, stop_op;
+
+/* pending status requests are left alone by moves and stops */
+static int is_velocity(const struct soap_async_call *call)
+{
+    return call->op == &continuous_move_op || call->op == &stop_op;
+}
+
+/* a move sets every axis, so it supersedes any pending velocity command */
+static int continuous_move_coalesce(struct soap_async_call *pending,
+        const struct soap_async_call *call)
+{
+    if (!is_velocity(pending))
+        return 0;
+
+    pending->op = call->op;
+    pending->args.move = call->args.move;
+
+    return 1;
+}
+
+/* arguments: pan x, pan y, zoom */
+static void continuous_move_template(struct soap_template *t, profile_t *profile)
+{
+    struct tt__PTZConfiguration *ptz = profile->PTZConfiguration;
+
+    soap_template_append(t, "<tptz:ContinuousMove><tptz:ProfileToken>");
+    soap_template_append_escaped(t, profile->token);
+    soap_template_append(t, "</tptz:ProfileToken><tptz:Velocity><tt:PanTilt x=\"");
+    soap_template_arg(t, SOAP_TEMPLATE_FLOAT_WIDTH);
+    soap_template_append(t, "\" y=\"");
+    soap_template_arg(t, SOAP_TEMPLATE_FLOAT_WIDTH);
+    template_space(t, ptz->DefaultContinuousPanTiltVelocitySpace);
+    soap_template_append(t, "/><tt:Zoom x=\"");
+    soap_template_arg(t, SOAP_TEMPLATE_FLOAT_WIDTH);
+    template_space(t, ptz->DefaultContinuousZoomVelocitySpace);
+    soap_template_append(t, "/></tptz:Velocity></tptz:ContinuousMove>");
+}
+
+static void continuous_move_patch(struct soap_template *t, const struct soap_async_call *call)
+{
+    soap_template_set_float(t, 0, call->args.move.pan_x);
+    soap_template_set_float(t, 1, call->args.move.pan_y);
+    soap_template_set_float(t, 2, call->args.move.zoom);
+}
+
+static const struct soap_async_op continuous_move_op = {
+    "ContinuousMove", continuous_move_send, continuous_move_recv, continuous_move_coalesce,
+    SAP_VELOCITY, STI_CONTINUOUS_MOVE, continuous_move_patch
+};
+
+void soap_ptz_continuous_move(float pan_x, float pan_y, float zoom)
+{
+    struct soap_async_call *call = ptz_call_new(&continuous_move_op);
+
+    if (call == NULL)
+        return;
+
+    call->args.move.pan_x = pan_x;
+    call->args.move.pan_y = pan_y;
+    call->args.move.zoom = zoom;
+
+    soap_poller_moving(call->instance, pan_x != 0 || pan_y != 0 || zoom != 0,
+            SOAP_POLLER_SETTLE_MS);
+
+    soap_async_submit(call);
+}
+
+static int goto_home_send(soap_t *soap, struct soap_async_call *call)
 {
     struct _tptz__GotoHomePosition gohome;
-    struct _tptz__GotoHomePositionResponse gohome_resp;
 
-    soap_ptz_prelude();
+    soap_ptz_prelude(call);
 
     gohome.ProfileToken = profile_token;
     gohome.Speed = profile->PTZConfiguration->DefaultPTZSpeed;
 
     log("call gotohomeposition");
 
-    if (soap_call___tptz__GotoHomePosition(soap, ptz_xaddr, NULL, &gohome, &gohome_resp) != SOAP_OK)
-        soap_die(soap, "failed to goto home position");
+    return soap_send___tptz__GotoHomePosition(soap, call->xaddr, NULL, &gohome);
 }
 
-static void stop(int pantilt, int zoom)
+static int goto_home_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__GotoHomePositionResponse gohome_resp;
+
+    return soap_recv___tptz__GotoHomePosition(soap, &gohome_resp);
+}
+
+static const struct soap_async_op goto_home_op = {
+    "GotoHomePosition", goto_home_send, goto_home_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+void soap_ptz_goto_home()
+{
+    struct soap_async_call *call = ptz_call_new(&goto_home_op);
+
+    if (call == NULL)
+        return;
+
+    soap_poller_moving(call->instance, 0, SOAP_POLLER_GOTO_MS);
+
+    soap_async_submit(call);
+}
+
+static int stop_send(soap_t *soap, struct soap_async_call *call)
 {
     struct _tptz__Stop stop;
-    struct _tptz__StopResponse stop_resp;
 
-    enum xsd__boolean pantilt_s = soap_utils_int_to_bool(pantilt);
-    enum xsd__boolean zoom_s = soap_utils_int_to_bool(zoom);
+    enum xsd__boolean pantilt_s = soap_utils_int_to_bool(call->args.stop.pantilt);
+    enum xsd__boolean zoom_s = soap_utils_int_to_bool(call->args.stop.zoom);
 
-    soap_ptz_prelude();
+    soap_ptz_prelude(call);
 
     stop.ProfileToken = profile_token;
     stop.PanTilt = &pantilt_s;
     stop.Zoom = &zoom_s;
 
-    log("call ptz stop pantilt %d zoom %d", pantilt, zoom);
+    log("call ptz stop pantilt %d zoom %d", call->args.stop.pantilt, call->args.stop.zoom);
+
+    return soap_send___tptz__Stop(soap, call->xaddr, NULL, &stop);
+}
+
+static int stop_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__StopResponse stop_resp;
+
+    return soap_recv___tptz__Stop(soap, &stop_resp);
+}
+
+/* a stop of one axis must not cancel a pending stop of the other one, so stops are merged
+   and a pending move only loses the velocity of the stopped axes */
+static int stop_coalesce(struct soap_async_call *pending, const struct soap_async_call *call)
+{
+    int pantilt = call->args.stop.pantilt, zoom = call->args.stop.zoom;
+
+    if (!is_velocity(pending))
+        return 0;
+
+    if (pending->op == &stop_op) {
+        pending->args.stop.pantilt |= pantilt;
+        pending->args.stop.zoom |= zoom;
+        return 1;
+    }
+
+    if (pantilt)
+        pending->args.move.pan_x = pending->args.move.pan_y = 0;
 
-    if (soap_call___tptz__Stop(soap, ptz_xaddr, NULL, &stop, &stop_resp) != SOAP_OK)
-        soap_die(soap, "failed to stop ptz");
+    if (zoom)
+        pending->args.move.zoom = 0;
+
+    return 1;
+}
+
+/* arguments: pantilt, zoom */
+static void stop_template(struct soap_template *t, profile_t *profile)
+{
+    soap_template_append(t, "<tptz:Stop><tptz:ProfileToken>");
+    soap_template_append_escaped(t, profile->token);
+    soap_template_append(t, "</tptz:ProfileToken><tptz:PanTilt>");
+    soap_template_arg(t, 1);
+    soap_template_append(t, "</tptz:PanTilt><tptz:Zoom>");
+    soap_template_arg(t, 1);
+    soap_template_append(t, "</tptz:Zoom></tptz:Stop>");
+}
+
+static void stop_patch(struct soap_template *t, const struct soap_async_call *call)
+{
+    log("call ptz stop pantilt %d zoom %d", call->args.stop.pantilt, call->args.stop.zoom);
+
+    soap_template_set_bool(t, 0, call->args.stop.pantilt);
+    soap_template_set_bool(t, 1, call->args.stop.zoom);
+}
+
+static const struct soap_async_op stop_op = {
+    "Stop", stop_send, stop_recv, stop_coalesce, SAP_VELOCITY, STI_STOP, stop_patch
+};
+
+static void stop(int pantilt, int zoom)
+{
+    struct soap_async_call *call = ptz_call_new(&stop_op);
+
+    if (call == NULL)
+        return;
+
+    call->args.stop.pantilt = pantilt;
+    call->args.stop.zoom = zoom;
+
+    soap_poller_moving(call->instance, 0, SOAP_POLLER_SETTLE_MS);
+
+    soap_async_submit(call);
 }
 
 void soap_ptz_stop_pantilt()
@@ -82,17 +285,24 @@ void soap_ptz_stop_zoom()
     stop(0, 1);
 }
 
-static void get_capabilities()
+static int get_capabilities_send(soap_t *soap, struct soap_async_call *call)
 {
     struct _tptz__GetServiceCapabilities x;
-    struct _tptz__GetServiceCapabilitiesResponse x_resp;
-
-    soap_ptz_prelude();
 
     log("call getcapabilities");
 
-    if (soap_call___tptz__GetServiceCapabilities(soap, ptz_xaddr, NULL, &x, &x_resp) != SOAP_OK)
-        soap_die(soap, "failed to get capabilities");
+    return soap_send___tptz__GetServiceCapabilities(soap, call->xaddr, NULL, &x);
+}
+
+static int get_capabilities_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__GetServiceCapabilitiesResponse x_resp;
+
+    if (soap_recv___tptz__GetServiceCapabilities(soap, &x_resp) != SOAP_OK)
+        return soap->error;
+
+    if (x_resp.Capabilities == NULL)
+        return SOAP_NO_DATA;
 
     enum xsd__boolean *status_position = x_resp.Capabilities->StatusPosition;
 
@@ -107,41 +317,150 @@ static void get_capabilities()
 
         /* log("MoveStatus: %d", soap_utils_bool_to_int(x_resp.Capabilities->MoveStatus)); */
     }
+
+    return SOAP_OK;
 }
 
-void soap_ptz_get_position(float *pan, float *tilt, float *zoom)
+static const struct soap_async_op get_capabilities_op = {
+    "GetServiceCapabilities", get_capabilities_send, get_capabilities_recv, NULL,
+    SAP_NONE, STI_NONE, NULL
+};
+
+static void get_capabilities()
 {
-    struct _tptz__GetStatus getstatus;
-    struct _tptz__GetStatusResponse getstatus_resp;
+    struct soap_async_call *call = ptz_call_new(&get_capabilities_op);
 
-    /* get_capabilities(); */
+    if (call != NULL)
+        soap_async_submit(call);
+}
+
+/* any answer at all means the camera is back */
+static int probe_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__GetServiceCapabilitiesResponse x_resp;
+
+    return soap_recv___tptz__GetServiceCapabilities(soap, &x_resp);
+}
 
-    soap_ptz_prelude();
+static const struct soap_async_op probe_op = {
+    "GetServiceCapabilities", get_capabilities_send, probe_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+/* the instance breaker's probe, runs on the instance's shard */
+void soap_ptz_probe(void *data)
+{
+    struct soap_instance *instance = data;
+    const char *xaddr = instance->ptz_xaddr;
+    struct soap_async_call *call;
+
+    if (xaddr == NULL) {
+        soap_breaker_record(&instance->breaker, 1, 1);
+        return;
+    }
+
+    call = soap_async_call_new(instance, &instance->ptz_queue, &probe_op, xaddr);
+    call->probe = 1;
+
+    soap_async_submit(call);
+}
+
+static int get_status_send(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__GetStatus getstatus;
+
+    soap_ptz_prelude(call);
 
     getstatus.ProfileToken = profile_token;
 
     log("call getstatus");
 
-    if (soap_call___tptz__GetStatus(soap, ptz_xaddr, NULL, &getstatus, &getstatus_resp) != SOAP_OK)
-        soap_die(soap, "failed to get status");
+    return soap_send___tptz__GetStatus(soap, call->xaddr, NULL, &getstatus);
+}
 
-    if (pan)
-        *pan = getstatus_resp.PTZStatus->Position->PanTilt->x;
-    if (tilt)
-        *tilt = getstatus_resp.PTZStatus->Position->PanTilt->y;
-    if (zoom)
-        *zoom = getstatus_resp.PTZStatus->Position->Zoom->x;
+static int get_status_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__GetStatusResponse getstatus_resp;
+
+    if (soap_recv___tptz__GetStatus(soap, &getstatus_resp) != SOAP_OK)
+        return soap->error;
+
+    if (getstatus_resp.PTZStatus == NULL || getstatus_resp.PTZStatus->Position == NULL
+            || getstatus_resp.PTZStatus->Position->PanTilt == NULL
+            || getstatus_resp.PTZStatus->Position->Zoom == NULL)
+        return SOAP_NO_DATA;
+
+    call->args.position.pan = getstatus_resp.PTZStatus->Position->PanTilt->x;
+    call->args.position.tilt = getstatus_resp.PTZStatus->Position->PanTilt->y;
+    call->args.position.zoom = getstatus_resp.PTZStatus->Position->Zoom->x;
+    call->args.position.moving = getstatus_resp.PTZStatus->MoveStatus != NULL
+            && ((getstatus_resp.PTZStatus->MoveStatus->PanTilt != NULL
+                    && *getstatus_resp.PTZStatus->MoveStatus->PanTilt == tt__MoveStatus__MOVING)
+                || (getstatus_resp.PTZStatus->MoveStatus->Zoom != NULL
+                    && *getstatus_resp.PTZStatus->MoveStatus->Zoom == tt__MoveStatus__MOVING));
+
+    return SOAP_OK;
 }
 
-void soap_ptz_set_preset(int preset)
+/* a status still queued answers for a newer request of the same caller as well */
+static int get_status_coalesce(struct soap_async_call *pending, const struct soap_async_call *call)
+{
+    return pending->op == call->op && pending->done == call->done;
+}
+
+static const struct soap_async_op get_status_op = {
+    "GetStatus", get_status_send, get_status_recv, get_status_coalesce, SAP_STATUS,
+    STI_NONE, NULL
+};
+
+static void status_received(struct soap_async_call *call)
+{
+    struct soap_ptz_shadow *shadow = &call->instance->shadow;
+
+    if (call->error)
+        return;
+
+    shadow->pan = call->args.position.pan;
+    shadow->tilt = call->args.position.tilt;
+    shadow->zoom = call->args.position.zoom;
+    shadow->moving = call->args.position.moving;
+    shadow->valid = 1;
+}
+
+/* updates the position of the instance's shadow, runs on the instance's shard */
+void soap_ptz_refresh_status(struct soap_instance *instance)
+{
+    struct soap_async_call *call = instance_call_new(instance, &get_status_op);
+
+    if (call == NULL)
+        return;
+
+    call->done = status_received;
+
+    soap_async_submit(call);
+}
+
+void soap_ptz_get_position(void (*done)(struct soap_async_call *call))
+{
+    struct soap_async_call *call = ptz_call_new(&get_status_op);
+
+    if (call == NULL)
+        return;
+
+    /* get_capabilities(); */
+
+    call->done = done;
+
+    soap_async_submit(call);
+}
+
+static int set_preset_send(soap_t *soap, struct soap_async_call *call)
 {
     struct _tptz__SetPreset x;
-    struct _tptz__SetPresetResponse x_resp;
     char preset_token[64];
 
-    soap_ptz_prelude();
+    soap_ptz_prelude(call);
 
-    snprintf(preset_token, 64, "%d", preset);
+    snprintf(preset_token, 64, "%d", call->args.preset.preset);
 
     x.ProfileToken = profile_token;
     x.PresetName = NULL;
@@ -149,30 +468,53 @@ void soap_ptz_set_preset(int preset)
 
     log("call setpreset");
 
-    if (soap_call___tptz__SetPreset(soap, ptz_xaddr, NULL, &x, &x_resp) != SOAP_OK)
-        soap_die(soap, "failed to set preset");
+    return soap_send___tptz__SetPreset(soap, call->xaddr, NULL, &x);
 }
 
-void soap_ptz_goto_preset(float pan_speed, float tilt_speed, int preset)
+static int set_preset_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__SetPresetResponse x_resp;
+
+    return soap_recv___tptz__SetPreset(soap, &x_resp);
+}
+
+static const struct soap_async_op set_preset_op = {
+    "SetPreset", set_preset_send, set_preset_recv, NULL, SAP_NONE, STI_NONE, NULL
+};
+
+void soap_ptz_set_preset(int preset)
+{
+    struct soap_async_call *call = ptz_call_new(&set_preset_op);
+
+    if (call == NULL)
+        return;
+
+    call->args.preset.preset = preset;
+
+    soap_async_submit(call);
+}
+
+static int goto_preset_send(soap_t *soap, struct soap_async_call *call)
 {
     struct tt__Vector1D zoom_speed;
     struct tt__Vector2D pantilt_speed;
     struct tt__PTZSpeed speed_container;
     struct _tptz__GotoPreset x;
-    struct _tptz__GotoPresetResponse x_resp;
     char preset_token[64];
 
-    soap_ptz_prelude();
+    soap_ptz_prelude(call);
 
-    snprintf(preset_token, 64, "%d", preset);
+    snprintf(preset_token, 64, "%d", call->args.preset.preset);
 
     x.ProfileToken = profile_token;
     x.PresetToken = preset_token;
 
     zoom_speed.x = 1.f;
+    zoom_speed.space = NULL;
 
-    pantilt_speed.x = pan_speed;
-    pantilt_speed.y = tilt_speed;
+    pantilt_speed.x = call->args.preset.pan_speed;
+    pantilt_speed.y = call->args.preset.tilt_speed;
+    pantilt_speed.space = NULL;
 
     speed_container.Zoom = &zoom_speed;
     speed_container.PanTilt = &pantilt_speed;
@@ -181,7 +523,86 @@ void soap_ptz_goto_preset(float pan_speed, float tilt_speed, int preset)
 
     log("call gotopreset");
 
-    if (soap_call___tptz__GotoPreset(soap, ptz_xaddr, NULL, &x, &x_resp) != SOAP_OK)
-        soap_die(soap, "failed to goto preset");
+    return soap_send___tptz__GotoPreset(soap, call->xaddr, NULL, &x);
+}
+
+static int goto_preset_recv(soap_t *soap, struct soap_async_call *call)
+{
+    struct _tptz__GotoPresetResponse x_resp;
+
+    return soap_recv___tptz__GotoPreset(soap, &x_resp);
+}
+
+#define PRESET_TOKEN_CLOSE "</tptz:PresetToken>"
+
+/* arguments: preset token with its closing tag, pan speed, tilt speed */
+static void goto_preset_template(struct soap_template *t, profile_t *profile)
+{
+    soap_template_append(t, "<tptz:GotoPreset><tptz:ProfileToken>");
+    soap_template_append_escaped(t, profile->token);
+    soap_template_append(t, "</tptz:ProfileToken><tptz:PresetToken>");
+    soap_template_arg(t, SOAP_TEMPLATE_INT_WIDTH + strlen(PRESET_TOKEN_CLOSE));
+    soap_template_append(t, "<tptz:Speed><tt:PanTilt x=\"");
+    soap_template_arg(t, SOAP_TEMPLATE_FLOAT_WIDTH);
+    soap_template_append(t, "\" y=\"");
+    soap_template_arg(t, SOAP_TEMPLATE_FLOAT_WIDTH);
+    soap_template_append(t, "\"/><tt:Zoom x=\"+1.000000\"/></tptz:Speed></tptz:GotoPreset>");
+}
+
+static void goto_preset_patch(struct soap_template *t, const struct soap_async_call *call)
+{
+    log("call gotopreset");
+
+    soap_template_set_int_element(t, 0, call->args.preset.preset, PRESET_TOKEN_CLOSE);
+    soap_template_set_float(t, 1, call->args.preset.pan_speed);
+    soap_template_set_float(t, 2, call->args.preset.tilt_speed);
+}
+
+static const struct soap_async_op goto_preset_op = {
+    "GotoPreset", goto_preset_send, goto_preset_recv, NULL,
+    SAP_NONE, STI_GOTO_PRESET, goto_preset_patch
+};
+
+void soap_ptz_goto_preset(float pan_speed, float tilt_speed, int preset)
+{
+    struct soap_async_call *call = ptz_call_new(&goto_preset_op);
+
+    if (call == NULL)
+        return;
+
+    call->args.preset.pan_speed = pan_speed;
+    call->args.preset.tilt_speed = tilt_speed;
+    call->args.preset.preset = preset;
+
+    soap_poller_moving(call->instance, 0, SOAP_POLLER_GOTO_MS);
+
+    soap_async_submit(call);
 }
 
+static void build_template(struct soap_instance *instance, int id, const char *action,
+        void (*body)(struct soap_template *t, profile_t *profile))
+{
+    struct soap_template *t = &instance->templates[id];
+
+    soap_template_begin(t, &instance->ptz_queue.auth);
+    body(t, instance->profile);
+    soap_template_end(t, instance->ptz_xaddr, action);
+}
+
+/* without a ptz configuration the calls take gsoap's serializer, which copes with it */
+void soap_ptz_build_templates(struct soap_instance *instance)
+{
+    profile_t *profile = instance->profile;
+
+    for (int i = 0; i < STI_COUNT; ++i)
+        soap_template_destruct(&instance->templates[i]);
+
+    if (profile->PTZConfiguration == NULL || instance->ptz_xaddr == NULL)
+        return;
+
+    build_template(instance, STI_CONTINUOUS_MOVE, SOAP_NAMESPACE_OF_tptz "/ContinuousMove",
+            continuous_move_template);
+    build_template(instance, STI_STOP, SOAP_NAMESPACE_OF_tptz "/Stop", stop_template);
+    build_template(instance, STI_GOTO_PRESET, SOAP_NAMESPACE_OF_tptz "/GotoPreset",
+            goto_preset_template);
+}
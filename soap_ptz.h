@@ -1,15 +1,21 @@
 #pragma once
 
 #include "address_manager.h"
+#include "soap_async.h"
 #include "soap_global.h"
 #include "soap_utils.h"
 #include "worker.h"
 
+struct soap_instance;
+
+void soap_ptz_build_templates(struct soap_instance *instance);
+void soap_ptz_probe(void *data);
+void soap_ptz_refresh_status(struct soap_instance *instance);
 void soap_ptz_continuous_move(float pan_x, float pan_y, float zoom);
 void soap_ptz_goto_home();
 void soap_ptz_stop_pantilt();
 void soap_ptz_stop_zoom();
-void soap_ptz_get_position(float *pan, float *tilt, float *zoom);
+void soap_ptz_get_position(void (*done)(struct soap_async_call *call));
 void soap_ptz_set_preset(int preset);
 void soap_ptz_goto_preset(float pan_speed, float tilt_speed, int preset);
 
@@ -0,0 +1,242 @@
+#define _GNU_SOURCE
+
+#include "soap_template.h"
+#include "config.h"
+#include "errors.h"
+#include "log.h"
+#include <string.h>
+
+#define WSSE_NS "http://docs.oasis-open.org/wss/2004/01/"
+
+static void reserve(struct soap_template *t, size_t len)
+{
+    size_t new_cap = t->cap ? t->cap : 1024;
+    char *buf;
+
+    if (t->len + len + 1 <= t->cap)
+        return;
+
+    while (new_cap < t->len + len + 1)
+        new_cap *= 2;
+
+    buf = realloc(t->buf, new_cap);
+    if (buf == NULL)
+        die(ERR_NOMEM, "failed to realloc(%zd)", new_cap);
+
+    t->buf = buf;
+    t->cap = new_cap;
+}
+
+static void append_len(struct soap_template *t, const char *str, size_t len)
+{
+    reserve(t, len);
+
+    memcpy(t->buf + t->len, str, len);
+    t->len += len;
+    t->buf[t->len] = '\0';
+}
+
+void soap_template_append(struct soap_template *t, const char *str)
+{
+    append_len(t, str, strlen(str));
+}
+
+void soap_template_append_escaped(struct soap_template *t, const char *str)
+{
+    for (; *str; ++str) {
+        switch (*str) {
+        case '&':
+            soap_template_append(t, "&amp;");
+            break;
+        case '<':
+            soap_template_append(t, "&lt;");
+            break;
+        case '>':
+            soap_template_append(t, "&gt;");
+            break;
+        case '"':
+            soap_template_append(t, "&quot;");
+            break;
+        default:
+            append_len(t, str, 1);
+        }
+    }
+}
+
+/* reserves width bytes and returns their offset, the field stays blank until patched */
+static size_t field(struct soap_template *t, size_t width)
+{
+    size_t offset = t->len;
+
+    reserve(t, width);
+
+    memset(t->buf + t->len, ' ', width);
+    t->len += width;
+    t->buf[t->len] = '\0';
+
+    return offset;
+}
+
+int soap_template_arg(struct soap_template *t, size_t width)
+{
+    if (t->args_count == SOAP_TEMPLATE_MAX_ARGS)
+        die(ERR_UNSPECIFIED, "soap_template: too many arguments");
+
+    t->args[t->args_count] = field(t, width);
+    t->args_width[t->args_count] = width;
+
+    return t->args_count++;
+}
+
+/* starts the envelope and, unless the camera takes no credentials, its ws-security header.
+   the body follows */
+void soap_template_begin(struct soap_template *t, const struct soap_auth *auth)
+{
+    const char *username = g_config.username;
+
+    memset(t, 0, sizeof(struct soap_template));
+
+    soap_template_append(t,
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+            "<SOAP-ENV:Envelope"
+            " xmlns:SOAP-ENV=\"http://www.w3.org/2003/05/soap-envelope\""
+            " xmlns:wsse=\"" WSSE_NS "oasis-200401-wss-wssecurity-secext-1.0.xsd\""
+            " xmlns:wsu=\"" WSSE_NS "oasis-200401-wss-wssecurity-utility-1.0.xsd\""
+            " xmlns:tt=\"http://www.onvif.org/ver10/schema\""
+            " xmlns:tptz=\"http://www.onvif.org/ver20/ptz/wsdl\">");
+
+    if (auth->mode == SAM_NONE) {
+        soap_template_append(t, "<SOAP-ENV:Body>");
+        return;
+    }
+
+    t->secured = 1;
+
+    soap_template_append(t,
+            "<SOAP-ENV:Header><wsse:Security SOAP-ENV:mustUnderstand=\"true\">"
+            "<wsu:Timestamp wsu:Id=\"Time\"><wsu:Created>");
+    t->created = field(t, SOAP_AUTH_TIME_WIDTH);
+    soap_template_append(t, "</wsu:Created><wsu:Expires>");
+    t->expires = field(t, SOAP_AUTH_TIME_WIDTH);
+    soap_template_append(t, "</wsu:Expires></wsu:Timestamp>"
+            "<wsse:UsernameToken wsu:Id=\"Auth\"><wsse:Username>");
+    soap_template_append_escaped(t, username ? username : "");
+    soap_template_append(t, "</wsse:Username><wsse:Password Type=\""
+            WSSE_NS "oasis-200401-wss-username-token-profile-1.0#PasswordDigest\">");
+    t->digest = field(t, SOAP_AUTH_DIGEST_WIDTH);
+    soap_template_append(t, "</wsse:Password><wsse:Nonce EncodingType=\""
+            WSSE_NS "oasis-200401-wss-soap-message-security-1.0#Base64Binary\">");
+    t->nonce = field(t, SOAP_AUTH_NONCE_WIDTH);
+    soap_template_append(t, "</wsse:Nonce><wsu:Created>");
+    t->token_created = field(t, SOAP_AUTH_TIME_WIDTH);
+    soap_template_append(t, "</wsu:Created></wsse:UsernameToken></wsse:Security></SOAP-ENV:Header>"
+            "<SOAP-ENV:Body>");
+}
+
+/* closes the envelope and puts the http header in front of it */
+void soap_template_end(struct soap_template *t, const char *xaddr, const char *action)
+{
+    const char *authority = xaddr, *path;
+    char header[1024];
+    int header_len;
+    size_t body_len;
+
+    soap_template_append(t, "</SOAP-ENV:Body></SOAP-ENV:Envelope>");
+
+    if (strncmp(authority, "http://", 7) == 0)
+        authority += 7;
+
+    path = strchr(authority, '/');
+
+    header_len = snprintf(header, sizeof(header),
+            "POST %s HTTP/1.1\r\n"
+            "Host: %.*s\r\n"
+            "User-Agent: voproxyd\r\n"
+            "Content-Type: application/soap+xml; charset=utf-8; action=\"%s\"\r\n"
+            "Content-Length: %zu\r\n"
+            "Connection: keep-alive\r\n"
+            "\r\n",
+            path ? path : "/", path ? (int)(path - authority) : (int)strlen(authority), authority,
+            action, t->len);
+    if (header_len < 0 || (size_t)header_len >= sizeof(header))
+        die(ERR_WRITE, "soap_template: http header overflow for %s", xaddr);
+
+    body_len = t->len;
+
+    reserve(t, header_len);
+    memmove(t->buf + header_len, t->buf, body_len + 1);
+    memcpy(t->buf, header, header_len);
+    t->len += header_len;
+
+    t->created += header_len;
+    t->expires += header_len;
+    t->nonce += header_len;
+    t->digest += header_len;
+    t->token_created += header_len;
+
+    for (int i = 0; i < t->args_count; ++i)
+        t->args[i] += header_len;
+}
+
+void soap_template_destruct(struct soap_template *t)
+{
+    free(t->buf);
+    t->buf = NULL;
+}
+
+static void patch(struct soap_template *t, size_t offset, const char *value, size_t width)
+{
+    memcpy(t->buf + offset, value, width);
+}
+
+void soap_template_set_float(struct soap_template *t, int arg, float value)
+{
+    char str[SOAP_TEMPLATE_FLOAT_WIDTH + 1];
+
+    if (value > 9.999999f)
+        value = 9.999999f;
+    else if (value < -9.999999f)
+        value = -9.999999f;
+
+    snprintf(str, sizeof(str), "%+.6f", value);
+
+    patch(t, t->args[arg], str, SOAP_TEMPLATE_FLOAT_WIDTH);
+}
+
+/* "1" and "0" are as valid as "true" and "false" but keep the width */
+void soap_template_set_bool(struct soap_template *t, int arg, int value)
+{
+    patch(t, t->args[arg], value ? "1" : "0", 1);
+}
+
+/* the field covers the value, the element's closing tag and whitespace after it, which is
+   insignificant between elements. reserve SOAP_TEMPLATE_INT_WIDTH + strlen(close_tag) */
+void soap_template_set_int_element(struct soap_template *t, int arg, int value, const char *close_tag)
+{
+    char str[SOAP_TEMPLATE_INT_WIDTH + 64];
+    int len = snprintf(str, sizeof(str), "%d%s", value, close_tag);
+
+    if (len < 0 || (size_t)len > t->args_width[arg])
+        die(ERR_WRITE, "soap_template: element overflow");
+
+    memset(t->buf + t->args[arg], ' ', t->args_width[arg]);
+    patch(t, t->args[arg], str, len);
+}
+
+/* signs the request with a fresh nonce and digest of the camera */
+int soap_template_sign(struct soap_template *t, struct soap_auth *auth)
+{
+    if (!t->secured)
+        return 0;
+
+    if (soap_auth_refresh(auth) != 0)
+        return 1;
+
+    patch(t, t->created, auth->created, SOAP_AUTH_TIME_WIDTH);
+    patch(t, t->expires, auth->expires, SOAP_AUTH_TIME_WIDTH);
+    patch(t, t->token_created, auth->created, SOAP_AUTH_TIME_WIDTH);
+    patch(t, t->nonce, auth->nonce, SOAP_AUTH_NONCE_WIDTH);
+    patch(t, t->digest, auth->digest, SOAP_AUTH_DIGEST_WIDTH);
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "soap_auth.h"
+#include <stddef.h>
+
+#define SOAP_TEMPLATE_MAX_ARGS 4
+/* "%+.6f" of a value clamped to +-9.999999 */
+#define SOAP_TEMPLATE_FLOAT_WIDTH 9
+/* the widest "%d" */
+#define SOAP_TEMPLATE_INT_WIDTH 11
+
+enum soap_template_id
+{
+    STI_NONE = 0,
+    STI_CONTINUOUS_MOVE,
+    STI_STOP,
+    STI_GOTO_PRESET,
+    STI_COUNT,
+};
+
+/* a complete http request with its soap envelope, serialized once per camera. every value
+   that changes between calls sits in a fixed width field, so a call only overwrites those
+   bytes and the content length never changes */
+struct soap_template
+{
+    char *buf;
+    size_t len, cap;
+    /* set if it carries a ws-security header */
+    int secured;
+    size_t created, expires, nonce, digest, token_created;
+    size_t args[SOAP_TEMPLATE_MAX_ARGS];
+    size_t args_width[SOAP_TEMPLATE_MAX_ARGS];
+    int args_count;
+};
+
+void soap_template_begin(struct soap_template *t, const struct soap_auth *auth);
+void soap_template_append(struct soap_template *t, const char *str);
+void soap_template_append_escaped(struct soap_template *t, const char *str);
+int soap_template_arg(struct soap_template *t, size_t width);
+void soap_template_end(struct soap_template *t, const char *xaddr, const char *action);
+void soap_template_destruct(struct soap_template *t);
+void soap_template_set_float(struct soap_template *t, int arg, float value);
+void soap_template_set_bool(struct soap_template *t, int arg, int value);
+void soap_template_set_int_element(struct soap_template *t, int arg, int value, const char *close_tag);
+int soap_template_sign(struct soap_template *t, struct soap_auth *auth);
@@ -0,0 +1,156 @@
+#include "soap_thread.h"
+#include "soap_async.h"
+#include "soap_instance.h"
+#include "soap_utils.h"
+#include "errors.h"
+#include "log.h"
+#include "worker.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static void signal_fd(int fd)
+{
+    uint64_t one = 1;
+
+    while (write(fd, &one, sizeof(one)) == -1 && errno == EINTR)
+        ;
+}
+
+static int send_recv(soap_t *soap, struct soap_async_call *call)
+{
+    int err = call->op->send(soap, call);
+
+    return err != SOAP_OK ? err : call->op->recv(soap, call);
+}
+
+static void run_call(struct soap_thread *thread, struct soap_async_call *call)
+{
+    soap_t *soap = thread->soap;
+    /* gsoap reuses the kept-alive socket of the previous call on its own */
+    int reused = soap_valid_socket(soap->socket);
+
+    soap_auth_apply(&call->queue->auth, soap);
+
+    call->error = soap_async_error_of(send_recv(soap, call));
+
+    /* the camera may have closed it in the meantime, try once more on a fresh connection */
+    if (call->error == SAE_UNREACHABLE && reused) {
+        soap_force_closesock(soap);
+        soap_destroy(soap);
+        soap_end(soap);
+        soap_auth_apply(&call->queue->auth, soap);
+        call->error = soap_async_error_of(send_recv(soap, call));
+    }
+
+    if (call->error)
+        soap_utils_log_error(soap);
+
+    soap_closesock(soap);
+    soap_destroy(soap);
+    soap_end(soap);
+
+    while (spsc_ring_push(&thread->completions, call) != 0)
+        sched_yield();
+
+    signal_fd(thread->done_fd);
+}
+
+static void* thread_main(void *arg)
+{
+    struct soap_thread *thread = arg;
+    struct soap_async_call *call;
+    uint64_t value;
+
+    while (!atomic_load(&thread->stop)) {
+        if (read(thread->wake_fd, &value, sizeof(value)) == -1 && errno != EINTR)
+            die(ERR_READ, "soap_thread: failed to read wake fd: %s", strerror(errno));
+
+        while ((call = spsc_ring_pop(&thread->requests)) != NULL)
+            run_call(thread, call);
+    }
+
+    return NULL;
+}
+
+struct soap_thread* soap_thread_create(soap_t *soap, int shard)
+{
+    struct soap_thread *thread = malloc(sizeof(struct soap_thread));
+    int err;
+
+    if (thread == NULL)
+        die(ERR_NOMEM, "failed to malloc(%zd)", sizeof(struct soap_thread));
+
+    thread->soap = soap;
+
+    spsc_ring_construct(&thread->requests, SOAP_THREAD_RING_CAPACITY);
+    spsc_ring_construct(&thread->completions, SOAP_THREAD_RING_CAPACITY);
+
+    atomic_init(&thread->stop, 0);
+
+    thread->wake_fd = eventfd(0, EFD_CLOEXEC);
+    thread->done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (thread->wake_fd == -1 || thread->done_fd == -1)
+        die(ERR_THREAD, "eventfd() failed: %s", strerror(errno));
+
+    worker_adopt_fd(shard, thread->done_fd, FDT_EVENTFD, thread);
+
+    err = pthread_create(&thread->tid, NULL, thread_main, thread);
+    if (err != 0)
+        die(ERR_THREAD, "pthread_create() failed: %s", strerror(err));
+
+    return thread;
+}
+
+/* called once the event loop is gone, calls that never completed are dropped */
+void soap_thread_destroy(struct soap_thread *thread)
+{
+    struct soap_async_call *call;
+
+    atomic_store(&thread->stop, 1);
+    signal_fd(thread->wake_fd);
+
+    pthread_join(thread->tid, NULL);
+
+    while ((call = spsc_ring_pop(&thread->requests)) != NULL)
+        free(call);
+
+    while ((call = spsc_ring_pop(&thread->completions)) != NULL)
+        free(call);
+
+    spsc_ring_destruct(&thread->requests);
+    spsc_ring_destruct(&thread->completions);
+
+    close(thread->wake_fd);
+    close(thread->done_fd);
+
+    free(thread);
+}
+
+/* returns 1 if the thread has too many calls queued */
+int soap_thread_push(struct soap_thread *thread, struct soap_async_call *call)
+{
+    if (spsc_ring_push(&thread->requests, call) != 0)
+        return 1;
+
+    signal_fd(thread->wake_fd);
+
+    return 0;
+}
+
+void soap_thread_handle_completions(struct event_t *event)
+{
+    struct soap_thread *thread = event->data;
+    struct soap_async_call *call;
+    uint64_t value;
+
+    if (read(thread->done_fd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+        die(ERR_READ, "soap_thread: failed to read done fd: %s", strerror(errno));
+
+    while ((call = spsc_ring_pop(&thread->completions)) != NULL)
+        soap_async_complete(call);
+}
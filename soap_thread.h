@@ -0,0 +1,31 @@
+#pragma once
+
+#include "epoll.h"
+#include "soap_header.h"
+#include "spsc_ring.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define SOAP_THREAD_RING_CAPACITY 64
+
+struct soap_async_call;
+
+extern int g_soap_threads;
+
+/* blocking onvif client running on its own thread for one camera. calls arrive through
+   requests, finished calls go back through completions and done_fd wakes the event loop */
+struct soap_thread
+{
+    pthread_t tid;
+    soap_t *soap;
+    struct spsc_ring requests;
+    struct spsc_ring completions;
+    int wake_fd;
+    int done_fd;
+    atomic_int stop;
+};
+
+struct soap_thread* soap_thread_create(soap_t *soap, int shard);
+void soap_thread_destroy(struct soap_thread *thread);
+int soap_thread_push(struct soap_thread *thread, struct soap_async_call *call);
+void soap_thread_handle_completions(struct event_t *event);
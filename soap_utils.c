@@ -1,25 +1,39 @@
 #include "soap_utils.h"
+#include "soap_namespaces.h"
 #include <wsseapi.h>
 #include <nsmaps/wsdd.nsmap>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <string.h>
 
+/* a call without credentials is turned down by the camera, that is left to the caller */
 void soap_utils_set_credentials(soap_t *soap, const char *username, const char *pwd)
 {
     soap_wsse_delete_Security(soap);
 
-    if (soap_wsse_add_Timestamp(soap, "Time", 10))
-        soap_die(soap, "soap_utils_set_credentials: failed to add timestamp");
+    if (soap_wsse_add_Timestamp(soap, "Time", 10)) {
+        log("soap_utils_set_credentials: failed to add timestamp");
+        soap_utils_log_error(soap);
+        return;
+    }
 
-    if (soap_wsse_add_UsernameTokenDigest(soap, "Auth", username, pwd))
-        soap_die(soap, "soap_utils_set_credentials: failed to add username token digest");
+    if (soap_wsse_add_UsernameTokenDigest(soap, "Auth", username, pwd)) {
+        log("soap_utils_set_credentials: failed to add username token digest");
+        soap_utils_log_error(soap);
+    }
 }
 
+/* returns NULL if the camera doesn't offer the service */
 static char* find_xaddr(services_t *services, const char *namespace)
 {
     for (int i = 0; i < services->__sizeService; i++)
-        if (strcmp(services->Service[i].Namespace, namespace) == 0)
+        if (services->Service[i].Namespace != NULL
+                && strcmp(services->Service[i].Namespace, namespace) == 0)
             return services->Service[i].XAddr;
 
-    die(ERR_SOAP, "failed to find namespace '%s'", namespace);
+    log("failed to find namespace '%s'", namespace);
+
+    return NULL;
 }
 
 char* soap_utils_get_media_xaddr(services_t *services)
@@ -32,11 +46,22 @@ char* soap_utils_get_ptz_xaddr(services_t *services)
     return find_xaddr(services, SOAP_NAMESPACE_OF_tptz);
 }
 
+char* soap_utils_get_imaging_xaddr(services_t *services)
+{
+    return find_xaddr(services, SOAP_NAMESPACE_OF_timg);
+}
+
+char* soap_utils_get_events_xaddr(services_t *services)
+{
+    return find_xaddr(services, SOAP_NAMESPACE_OF_tev);
+}
+
 int soap_utils_get_services(soap_t *soap, const char *endpoint, services_t *services)
 {
     struct _tds__GetServices get_services_trt;
 
-    soap_utils_auth();
+    soap_set_namespaces(soap, soap_namespaces_device);
+    soap_utils_auth(soap);
 
     get_services_trt.IncludeCapability = xsd__boolean__false_;
 
@@ -50,34 +75,102 @@ int soap_utils_get_services(soap_t *soap, const char *endpoint, services_t *serv
     return 0;
 }
 
-void soap_utils_get_profiles(soap_t *soap, const char *media_xaddr, profiles_t *profiles)
+/* the event loop connects to numeric hosts only, so a camera reporting host names has them
+   looked up here, on the bootstrap thread. an xaddr that doesn't resolve is kept as is, calls
+   to it fail on the event loop */
+void soap_utils_resolve_xaddrs(soap_t *soap, services_t *services)
+{
+    struct addrinfo ai_hint = { 0 }, *ai_result;
+    char host[256], numeric[INET_ADDRSTRLEN], *xaddr;
+    const char *it, *host_end;
+    struct in_addr addr;
+    size_t host_len, len;
+    int err;
+
+    ai_hint.ai_family = AF_INET;
+    ai_hint.ai_socktype = SOCK_STREAM;
+
+    for (int i = 0; i < services->__sizeService; i++) {
+        xaddr = services->Service[i].XAddr;
+
+        if (xaddr == NULL || strncmp(xaddr, "http://", 7) != 0)
+            continue;
+
+        it = xaddr + 7;
+        host_end = it + strcspn(it, ":/");
+        host_len = host_end - it;
+
+        if (host_len == 0 || host_len >= sizeof(host))
+            continue;
+
+        memcpy(host, it, host_len);
+        host[host_len] = '\0';
+
+        if (inet_pton(AF_INET, host, &addr) == 1)
+            continue;
+
+        err = getaddrinfo(host, NULL, &ai_hint, &ai_result);
+        if (err != 0) {
+            log("failed to resolve %s: %s", host, gai_strerror(err));
+            continue;
+        }
+
+        inet_ntop(AF_INET, &((struct sockaddr_in*)ai_result->ai_addr)->sin_addr, numeric,
+                sizeof(numeric));
+        freeaddrinfo(ai_result);
+
+        len = 7 + strlen(numeric) + strlen(host_end) + 1;
+        services->Service[i].XAddr = soap_malloc(soap, len);
+        snprintf(services->Service[i].XAddr, len, "http://%s%s", numeric, host_end);
+
+        log("%s resolved to %s", xaddr, services->Service[i].XAddr);
+    }
+}
+
+int soap_utils_get_profiles(soap_t *soap, const char *media_xaddr, profiles_t *profiles)
 {
     struct _trt__GetProfiles get_profiles_trt;
 
-    soap_utils_auth();
+    if (media_xaddr == NULL)
+        return 1;
+
+    soap_set_namespaces(soap, soap_namespaces_media);
+    soap_utils_auth(soap);
 
     if (soap_call___trt__GetProfiles(soap, media_xaddr, NULL, &get_profiles_trt, profiles) != SOAP_OK
-            || profiles->Profiles == NULL)
-        soap_die(soap, "failed to get profiles");
+            || profiles->Profiles == NULL) {
+        log("failed to get profiles:");
+        soap_utils_log_error(soap);
+        return 1;
+    }
+
+    return 0;
 }
 
-void soap_utils_get_device_information(soap_t *soap, const char *service_endpoint,
+int soap_utils_get_device_information(soap_t *soap, const char *service_endpoint,
         device_info_t *device_info)
 {
     struct _tds__GetDeviceInformation get_device_info_tds;
 
-    soap_utils_auth();
+    soap_set_namespaces(soap, soap_namespaces_device);
+    soap_utils_auth(soap);
 
     if (soap_call___tds__GetDeviceInformation(soap, service_endpoint, NULL, &get_device_info_tds,
-                device_info) != SOAP_OK)
-        soap_die(soap, "failed to get device information");
+                device_info) != SOAP_OK) {
+        log("failed to get device information:");
+        soap_utils_log_error(soap);
+        return 1;
+    }
+
+    return 0;
 }
 
 void soap_utils_print_device_info(soap_t *soap, const char *service_endpoint)
 {
     device_info_t device_info;
 
-    soap_utils_get_device_information(soap, service_endpoint, &device_info);
+    if (soap_utils_get_device_information(soap, service_endpoint, &device_info) != 0)
+        return;
 
     log("device info:");
     log("Manufacturer:    %s", device_info.Manufacturer);
@@ -87,54 +180,75 @@ void soap_utils_print_device_info(soap_t *soap, const char *service_endpoint)
     log("HardwareId:      %s", device_info.HardwareId);
 }
 
-void soap_utils_get_snapshot_uri(soap_t *soap, const char *endpoint, char *profile_token,
+/* the uri lives in the context until the caller's soap_end() */
+int soap_utils_get_snapshot_uri(soap_t *soap, const char *endpoint, char *profile_token,
         char **snapshot_uri)
 {
     struct _trt__GetSnapshotUri get_snapshot_uri_trt;
     struct _trt__GetSnapshotUriResponse snapshot_uri_response;
 
-    soap_utils_auth();
+    soap_set_namespaces(soap, soap_namespaces_media);
+    soap_utils_auth(soap);
 
     get_snapshot_uri_trt.ProfileToken = profile_token;
 
     if (soap_call___trt__GetSnapshotUri(soap, endpoint, NULL, &get_snapshot_uri_trt,
-                &snapshot_uri_response) != SOAP_OK || snapshot_uri_response.MediaUri == NULL)
-        soap_die(soap, "failed to get snapshot URI");
+                &snapshot_uri_response) != SOAP_OK || snapshot_uri_response.MediaUri == NULL) {
+        log("failed to get snapshot URI:");
+        soap_utils_log_error(soap);
+        return 1;
+    }
 
     *snapshot_uri = snapshot_uri_response.MediaUri->Uri;
+
+    return 0;
 }
 
-void soap_utils_save_snapshot(const char *filename, const char *snapshot_uri)
+int soap_utils_save_snapshot(const char *filename, const char *snapshot_uri)
 {
     FILE *fd;
     soap_t *soap;
     size_t imagelen;
     char *image;
+    int err = 1;
 
     fd = fopen(filename, "wb");
-    if (!fd)
-        die(ERR_OPEN, "failed to open file '%s' for writing", filename);
+    if (!fd) {
+        log("failed to open file '%s' for writing", filename);
+        return 1;
+    }
 
     /* create a temporary context to retrieve the image with HTTP GET */
     soap = soap_new();
-    if (soap == NULL)
-        soap_die(soap, "failed to create temporary context");
+    if (soap == NULL) {
+        log("failed to create temporary context");
+        fclose(fd);
+        return 1;
+    }
 
     soap->connect_timeout = soap->recv_timeout = soap->send_timeout = 5;
 
-    if (soap_GET(soap, snapshot_uri, NULL) || soap_begin_recv(soap))
-        soap_die(soap, "error retrieving snapshot");
+    if (soap_GET(soap, snapshot_uri, NULL) || soap_begin_recv(soap)) {
+        log("error retrieving snapshot:");
+        soap_utils_log_error(soap);
+        goto out;
+    }
 
     image = soap_http_get_body(soap, &imagelen);
 
     soap_end_recv(soap);
 
-    fwrite(image, 1, imagelen, fd);
+    if (fwrite(image, 1, imagelen, fd) == imagelen)
+        err = 0;
+
+out:
     fclose(fd);
 
     soap_destroy(soap);
     soap_end(soap);
     soap_free(soap);
+
+    return err;
 }
 
 #define str_safe_echo(X) ((X) == NULL ? "(null)" : (X))
@@ -3,6 +3,7 @@
 #include "errors.h"
 #include "log.h"
 #include "socket.h"
+#include "udp_outbox.h"
 #include <errno.h>
 #include <netdb.h>
 #include <stdio.h>
@@ -126,12 +127,8 @@ int socket_send_message_udp(int fd, const buffer_t *message, struct sockaddr *ad
     ssize_t total = message->length, total_sent = 0, remaining = total, sent;
 
     while (total_sent < total) {
-        sent = sendto(fd, message->data + total_sent, remaining, 0, addr, addr_len);
+        sent = sendto(fd, message->data + total_sent, remaining, MSG_DONTWAIT, addr, addr_len);
         if (sent == -1) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                continue;
-            }
-
             log("failed to send message of length %zd to fd = %d: %s", total, fd, strerror(errno));
             return 0;
         }
@@ -143,9 +140,17 @@ int socket_send_message_udp(int fd, const buffer_t *message, struct sockaddr *ad
     return total_sent == total;
 }
 
+/* replies on sockets with an outbox are queued and go out with the next flush */
 int socket_send_message_udp_event(const struct event_t *event, const buffer_t *message)
 {
-    return (message == NULL) ? 0 : socket_send_message_udp(event->fd, message, event->addr, event->addr_len);
+    if (message == NULL)
+        return 0;
+
+    if (event->outbox != NULL)
+        return udp_outbox_push(event->outbox, event->addr, event->addr_len, message->data,
+                message->length) == 0;
+
+    return socket_send_message_udp(event->fd, message, event->addr, event->addr_len);
 }
 
 void socket_handle_error(int sock_fd)
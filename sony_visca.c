@@ -4,8 +4,7 @@
 #include "socket.h"
 #include "visca.h"
 #include "sony_visca.h"
-#include "sony_visca_commands.h"
-#include "sony_visca_inquiries.h"
+#include "visca_decode.h"
 #include <netdb.h>
 #include <string.h>
 
@@ -29,9 +28,9 @@ static void visca_header_convert_endianness_hton(struct visca_header_t *header)
     header->seq_number = htonl(header->seq_number);
 }
 
-buffer_t* compose_control_reply(uint32_t seq_number)
+/* response holds at least VOIP_CONTROL_REPLY_LENGTH bytes */
+buffer_t* compose_control_reply(buffer_t *response, uint32_t seq_number)
 {
-    buffer_t *response = cons_buffer(VOIP_HEADER_LENGTH + 1);
     struct visca_header_t header = {
         .payload_type = 0x0201,
         .payload_length = 0x01,
@@ -43,18 +42,45 @@ buffer_t* compose_control_reply(uint32_t seq_number)
     memcpy(response->data, &header, VOIP_HEADER_LENGTH);
 
     response->data[VOIP_HEADER_LENGTH] = 0x01; /* ACK: reply for RESET */
+    response->length = VOIP_CONTROL_REPLY_LENGTH;
+
+    return response;
+}
+
+/* wraps a raw visca reply into a VISCA reply message for the controller's seq_number.
+   response holds at least VOIP_MAX_REPLY_LENGTH bytes */
+static buffer_t* compose_visca_reply(buffer_t *response, uint32_t seq_number, const buffer_t *data)
+{
+    struct visca_header_t header = {
+        .payload_type = 0x0111,
+        .payload_length = data->length,
+        .seq_number = seq_number
+    };
+
+    visca_header_convert_endianness_hton(&header);
+
+    memcpy(response->data, &header, VOIP_HEADER_LENGTH);
+    memcpy(response->data + VOIP_HEADER_LENGTH, data->data, data->length);
+    response->length = VOIP_HEADER_LENGTH + data->length;
 
     return response;
 }
 
 static void handle_visca_command(const struct message_t *message, const struct event_t *event)
 {
-    buffer_t *response = compose_ack();
+    uint8_t error_data[4], response_data[VOIP_MAX_REPLY_LENGTH];
+    buffer_t error = BUFFER_OF(error_data), response = BUFFER_OF(response_data);
+    uint32_t seq_number = message->header->seq_number;
 
     log("visca: handle_visca_command");
 
-    visca_send_response_quiet(event, response);
-    free(response);
+    if (!visca_can_take_command(event)) {
+        compose_error(&error, VISCA_ERROR_NOT_EXECUTABLE);
+        visca_send_response(event, compose_visca_reply(&response, seq_number, &error));
+        return;
+    }
+
+    visca_send_response_quiet(event, compose_visca_reply(&response, seq_number, &visca_ack));
 
     if (message->payload_length < 5) {
         log("handle_visca_command: bad length %zu", message->payload_length);
@@ -67,16 +93,18 @@ static void handle_visca_command(const struct message_t *message, const struct e
         return;
     }
 
-    sony_visca_commands_dispatch(message, event);
+    visca_decode_command(message->payload, message->payload_length, VISCA_DIALECT_SONY);
 
-    response = compose_empty_completition();
-    visca_send_response_quiet(event, response);
-    free(response);
+    visca_send_response_quiet(event, compose_visca_reply(&response, seq_number, &visca_empty_completition));
 }
 
 static void handle_visca_inquiry(const struct message_t *message, const struct event_t *event)
 {
-    buffer_t *inquiry_data, *response;
+    uint8_t inquiry_storage[VISCA_MAX_INQUIRY_LENGTH], completition_data[VISCA_MAX_REPLY_LENGTH],
+            response_data[VOIP_MAX_REPLY_LENGTH];
+    buffer_t inquiry = BUFFER_OF(inquiry_storage), completition = BUFFER_OF(completition_data),
+             response = BUFFER_OF(response_data);
+    const buffer_t *inquiry_data;
 
     log("visca: handle_visca_inquiry");
 
@@ -90,16 +118,14 @@ static void handle_visca_inquiry(const struct message_t *message, const struct e
         return;
     }
 
-    inquiry_data = sony_visca_inquiries_dispatch(message);
+    inquiry_data = visca_decode_inquiry(message->payload, message->payload_length, VISCA_DIALECT_SONY,
+            &inquiry);
 
-    if (inquiry_data != NULL) {
-        response = compose_completition(inquiry_data);
-
-        visca_send_response(event, response);
+    if (inquiry_data == NULL)
+        return;
 
-        free(response);
-        free(inquiry_data);
-    }
+    compose_completition(&completition, inquiry_data);
+    visca_send_response(event, compose_visca_reply(&response, message->header->seq_number, &completition));
 }
 
 static void handle_visca_reply(const struct message_t *message, const struct event_t *event)
@@ -121,7 +147,8 @@ static void handle_visca_device_setting_cmd(const struct message_t *message, con
 static void handle_control_command(const struct message_t *message, const struct event_t *event)
 {
     log("visca: handle_control_command");
-    buffer_t *response;
+    uint8_t response_data[VOIP_CONTROL_REPLY_LENGTH];
+    buffer_t response = BUFFER_OF(response_data);
 
     switch (message->payload[0]) {
         case 0x01:
@@ -152,9 +179,7 @@ static void handle_control_command(const struct message_t *message, const struct
             return;
     }
 
-    response = compose_control_reply(message->header->seq_number);
-    visca_send_response(event, response);
-    free(response);
+    visca_send_response(event, compose_control_reply(&response, message->header->seq_number));
 }
 
 static void handle_control_reply(const struct message_t *message, const struct event_t *event)
@@ -167,15 +192,21 @@ static void handle_control_reply(const struct message_t *message, const struct e
 
 void sony_visca_handle_message(const buffer_t *message_buf, const struct event_t *event)
 {
-    struct message_t message = {
-        .header = (struct visca_header_t*)message_buf->data,
-        .payload = message_buf->data + 8,
-        .payload_length = message_buf->length - 8,
-    };
+    struct message_t message;
 
     log("visca: visca_handle_message: got msg:");
     print_buffer(message_buf, 16);
 
+    /* every payload type has at least one payload byte */
+    if (message_buf->length <= VOIP_HEADER_LENGTH) {
+        log("sony_visca_handle_message: message of %zu bytes is too short", message_buf->length);
+        return;
+    }
+
+    message.header = (struct visca_header_t*)message_buf->data;
+    message.payload = message_buf->data + VOIP_HEADER_LENGTH;
+    message.payload_length = message_buf->length - VOIP_HEADER_LENGTH;
+
     visca_header_convert_endianness_ntoh(message.header);
 
     log("ptype=0x%04x plen=%d seq_number=%d", message.header->payload_type,
@@ -2,6 +2,7 @@
 
 #include "buffer.h"
 #include "epoll.h"
+#include "visca.h"
 
 struct visca_header_t
 {
@@ -20,6 +21,8 @@ struct message_t
 #define VOIP_MAX_PAYLOAD_LENGTH 16
 #define VOIP_HEADER_LENGTH 8
 #define VOIP_MAX_MESSAGE_LENGTH (VOIP_HEADER_LENGTH + VOIP_MAX_PAYLOAD_LENGTH)
+#define VOIP_CONTROL_REPLY_LENGTH (VOIP_HEADER_LENGTH + 1)
+#define VOIP_MAX_REPLY_LENGTH (VOIP_HEADER_LENGTH + VISCA_MAX_REPLY_LENGTH)
 
 #define bad_byte_detail(X, R) \
     do { \
@@ -37,6 +40,6 @@ struct message_t
 #define check_length_null(X) check_length_detail(X, NULL)
 #define check_length(X) check_length_detail(X, )
 
-buffer_t* compose_control_reply(uint32_t seq_number);
+buffer_t* compose_control_reply(buffer_t *response, uint32_t seq_number);
 void sony_visca_handle_message(const buffer_t *message_buf, const struct event_t *event);
 
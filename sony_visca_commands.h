@@ -1,8 +0,0 @@
-#pragma once
-
-#include "buffer.h"
-
-#include <stdint.h>
-
-void sony_visca_commands_dispatch(const struct message_t *message, const struct event_t *event);
-
@@ -1,7 +0,0 @@
-#pragma once
-
-#include "buffer.h"
-#include <stdint.h>
-
-buffer_t* sony_visca_inquiries_dispatch(const struct message_t *message);
-
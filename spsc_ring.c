@@ -0,0 +1,58 @@
+#include "spsc_ring.h"
+#include "errors.h"
+#include "log.h"
+
+/* capacity must be a power of two */
+void spsc_ring_construct(struct spsc_ring *ring, size_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        die(ERR_ALLOC, "spsc_ring: capacity %zu is not a power of two", capacity);
+
+    ring->slots = calloc(capacity, sizeof(void*));
+    if (ring->slots == NULL)
+        die(ERR_NOMEM, "failed to calloc(%zu)", capacity * sizeof(void*));
+
+    ring->mask = capacity - 1;
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+void spsc_ring_destruct(struct spsc_ring *ring)
+{
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+/* returns 1 if the ring is full */
+int spsc_ring_push(struct spsc_ring *ring, void *item)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail - head > ring->mask)
+        return 1;
+
+    ring->slots[tail & ring->mask] = item;
+
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+    return 0;
+}
+
+/* returns NULL if the ring is empty */
+void* spsc_ring_pop(struct spsc_ring *ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    void *item;
+
+    if (head == tail)
+        return NULL;
+
+    item = ring->slots[head & ring->mask];
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return item;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define SPSC_RING_CACHE_LINE 64
+
+/* bounded lock-free queue of pointers for exactly one producer and one consumer thread.
+   head is only written by the consumer, tail only by the producer */
+struct spsc_ring
+{
+    _Alignas(SPSC_RING_CACHE_LINE) atomic_size_t head;
+    _Alignas(SPSC_RING_CACHE_LINE) atomic_size_t tail;
+    _Alignas(SPSC_RING_CACHE_LINE) size_t mask;
+    void **slots;
+};
+
+void spsc_ring_construct(struct spsc_ring *ring, size_t capacity);
+void spsc_ring_destruct(struct spsc_ring *ring);
+int spsc_ring_push(struct spsc_ring *ring, void *item);
+void* spsc_ring_pop(struct spsc_ring *ring);
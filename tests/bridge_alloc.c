@@ -0,0 +1,195 @@
+#include "config.h"
+#include "counting_alloc.h"
+#include "log.h"
+#include "soap_instance.h"
+#include "soap_ptz.h"
+#include "soap_thread.h"
+#include "socket.h"
+#include "visca_decode.h"
+#include "visca_framing.h"
+#include "worker.h"
+#include <arpa/inet.h>
+#include <string.h>
+#include <sys/socket.h>
+
+/* drives a camera with the pan-tilt commands of a controller through the real bridge, ptz
+   and soap_async code and counts the heap allocations they take. the camera is the far end
+   of a socketpair in the instance's pool of kept-alive connections: it reads every request
+   and answers it with an empty 200. the ContinuousMove and Stop response parsers are linked
+   with -Wl,--wrap, gsoap's xml parser allocates on its own and is not what is measured */
+
+#define BRIDGE_ALLOC_WARMUP 4
+#define BRIDGE_ALLOC_ROUNDS 1000
+#define BRIDGE_ALLOC_HOST "192.0.2.1"
+#define BRIDGE_ALLOC_MAX_REQUEST 4096
+
+int g_daemonize = 0;
+FILE *g_log_output_file;
+int g_timestamps = 0;
+struct config g_config = { "admin", "admin" };
+__thread int g_current_event_fd;
+int g_soap_threads = 0;
+
+static struct soap_instance *instance;
+static profile_t profile;
+static struct tt__PTZConfiguration ptz_configuration;
+/* the record of the socket the call in flight waits on */
+static struct event_t camera_event;
+static int camera = -1;
+static size_t replies;
+
+int __wrap_soap_recv___tptz__ContinuousMove(soap_t *soap,
+        struct _tptz__ContinuousMoveResponse *move_resp)
+{
+    return SOAP_OK;
+}
+
+int __wrap_soap_recv___tptz__Stop(soap_t *soap, struct _tptz__StopResponse *stop_resp)
+{
+    return SOAP_OK;
+}
+
+/* every controller talks to the one camera, every reply is sent */
+struct soap_instance* address_mngr_get_soap_instance_from_fd(int fd)
+{
+    return instance;
+}
+
+int socket_send_message_udp_event(const struct event_t *event, const buffer_t *message)
+{
+    ++replies;
+    return 0;
+}
+
+/* the test is the event loop of the only shard, it hands the camera's events in itself */
+struct event_t* worker_add_fd(int fd, int type, int in, void *data)
+{
+    camera_event.fd = fd;
+    camera_event.type = type;
+    camera_event.data = data;
+
+    return &camera_event;
+}
+
+void worker_watch_fd(struct event_t *event, int in)
+{
+}
+
+void worker_forget_fd(struct event_t *event)
+{
+}
+
+void worker_adopt_fd(int shard, int fd, int type, void *data)
+{
+}
+
+void worker_run_on_shard(int shard, void (*fn)(void *data), void *data)
+{
+}
+
+/* a camera that is bootstrapped and keeps one connection alive */
+static void camera_construct()
+{
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == -1)
+        die(ERR_SOCKET, "bridge_alloc: socketpair() failed");
+
+    instance = soap_instance_allocate(BRIDGE_ALLOC_HOST, 0);
+
+    profile.token = "Profile_1";
+    profile.PTZConfiguration = &ptz_configuration;
+    instance->profile = &profile;
+    instance->ptz_xaddr = "http://" BRIDGE_ALLOC_HOST "/onvif/ptz_service";
+
+    soap_ptz_build_templates(instance);
+    atomic_store(&instance->ready, 1);
+
+    soap_pool_release(&instance->pool, fds[0], BRIDGE_ALLOC_HOST, "80");
+    camera = fds[1];
+}
+
+/* returns 1 unless the request on the wire is the expected operation */
+static int answer(const char *operation)
+{
+    static const char response[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+    char request[BRIDGE_ALLOC_MAX_REQUEST];
+    ssize_t len = recv(camera, request, sizeof(request) - 1, 0);
+
+    if (len <= 0)
+        return 1;
+
+    request[len] = '\0';
+
+    if (strstr(request, operation) == NULL)
+        return 1;
+
+    if (send(camera, response, sizeof(response) - 1, 0) != sizeof(response) - 1)
+        return 1;
+
+    soap_async_handle_event(&camera_event, EPOLLIN);
+
+    return 0;
+}
+
+static void send_datagram(const uint8_t *data, size_t length)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(52380),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    struct event_t event = {
+        .fd = 3,
+        .addr = (struct sockaddr*)&addr,
+        .addr_len = sizeof(addr),
+    };
+    uint8_t copy[16];
+    buffer_t message = { length, copy };
+
+    memcpy(copy, data, length);
+
+    g_current_event_fd = event.fd;
+    visca_framing_handle_message(&message, &event);
+}
+
+int main()
+{
+    static const uint8_t drive_left[] = { 0x81, 0x01, 0x06, 0x01, 0x0c, 0x0a, 0x01, 0x03, 0xff };
+    static const uint8_t stop[] = { 0x81, 0x01, 0x06, 0x01, 0x0c, 0x0a, 0x03, 0x03, 0xff };
+    size_t answered = 0;
+    int ok;
+
+    g_log_output_file = fopen("/dev/null", "w");
+
+    if (g_log_output_file == NULL)
+        die(ERR_OPEN_DEVNULL, "bridge_alloc: can't open /dev/null");
+
+    timer_wheel_init();
+    visca_decode_init();
+    camera_construct();
+
+    for (int i = 0; i < BRIDGE_ALLOC_WARMUP + BRIDGE_ALLOC_ROUNDS; ++i) {
+        if (i == BRIDGE_ALLOC_WARMUP) {
+            g_allocations = replies = answered = 0;
+            g_alloc_counting = 1;
+        }
+
+        send_datagram(drive_left, sizeof(drive_left));
+        answered += answer("ContinuousMove") == 0;
+
+        send_datagram(stop, sizeof(stop));
+        answered += answer("Stop") == 0;
+    }
+
+    g_alloc_counting = 0;
+
+    /* an ack and a completion for every command, a request to the camera for every one too */
+    ok = g_allocations == 0 && replies == 4 * BRIDGE_ALLOC_ROUNDS
+        && answered == 2 * BRIDGE_ALLOC_ROUNDS;
+
+    printf("%-12s %s: %zu allocations, %zu replies, %zu requests in %d rounds\n", "drive, stop",
+            ok ? "ok" : "FAIL", g_allocations, replies, answered, BRIDGE_ALLOC_ROUNDS);
+
+    return !ok;
+}
@@ -0,0 +1,26 @@
+#include "counting_alloc.h"
+
+int g_alloc_counting;
+size_t g_allocations;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void *ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    g_allocations += g_alloc_counting;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    g_allocations += g_alloc_counting;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void *ptr, size_t size)
+{
+    g_allocations += g_alloc_counting;
+    return __real_realloc(ptr, size);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stddef.h>
+
+/* counts the heap allocations made while counting is set. a test links with
+   -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc so every allocation of the objects under test
+   goes through the counters */
+extern int g_alloc_counting;
+extern size_t g_allocations;
@@ -0,0 +1,215 @@
+#include "config.h"
+#include "log.h"
+#include "soap_auth.h"
+#include "soap_namespaces.h"
+#include "wsdd_callbacks.h"
+#include <nsmaps/wsdd.nsmap>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* serializes the requests the daemon sends all day once with the table generated from all the
+   onvif wsdls and once with the table of their service, and prints the bytes on the wire and the
+   time a signed request takes. the requests go through fsend like the ones of soap_async.c, no
+   camera is involved */
+
+#define NS_SIZE_WARMUP 16
+#define NS_SIZE_ROUNDS 10000
+
+int g_daemonize = 0;
+FILE *g_log_output_file;
+int g_timestamps = 0;
+struct config g_config = { "admin", "admin" };
+
+static int sink = -1;
+static size_t sent;
+
+/* discovery is linked in with the generated sources but never used here */
+soap_wsdd_mode wsdd_event_Probe(struct soap *soap, const char *message_id, const char *reply_to,
+        const char *types, const char *scopes, const char *match_by,
+        struct wsdd__ProbeMatchesType *matches)
+{
+    return SOAP_WSDD_ADHOC;
+}
+
+void wsdd_event_ProbeMatches(struct soap *soap, unsigned int instance_id, const char *sequence_id,
+        unsigned int message_number, const char *message_id, const char *relates_to,
+        struct wsdd__ProbeMatchesType *matches)
+{
+}
+
+soap_wsdd_mode wsdd_event_Resolve(struct soap *soap, const char *message_id, const char *reply_to,
+        const char *endpoint_ref, struct wsdd__ResolveMatchType *match)
+{
+    return SOAP_WSDD_ADHOC;
+}
+
+void wsdd_event_ResolveMatches(struct soap *soap, unsigned int instance_id, const char *sequence_id,
+        unsigned int message_number, const char *message_id, const char *relates_to,
+        struct wsdd__ResolveMatchType *match)
+{
+}
+
+void wsdd_event_Hello(struct soap *soap, unsigned int instance_id, const char *sequence_id,
+        unsigned int message_number, const char *message_id, const char *relates_to,
+        const char *endpoint_ref, const char *types, const char *scopes, const char *match_by,
+        const char *XAddrs, unsigned int metadata_version)
+{
+}
+
+void wsdd_event_Bye(struct soap *soap, unsigned int instance_id, const char *sequence_id,
+        unsigned int message_number, const char *message_id, const char *relates_to,
+        const char *endpoint_ref, const char *types, const char *scopes, const char *match_by,
+        const char *XAddrs, unsigned int *metadata_version)
+{
+}
+
+int SOAP_ENV__Fault(struct soap *soap, char *faultcode, char *faultstring, char *faultactor,
+        struct SOAP_ENV__Detail *detail, struct SOAP_ENV__Code *SOAP_ENV__Code,
+        struct SOAP_ENV__Reason *SOAP_ENV__Reason, char *SOAP_ENV__Node, char *SOAP_ENV__Role,
+        struct SOAP_ENV__Detail *SOAP_ENV__Detail)
+{
+    return SOAP_OK;
+}
+
+static SOAP_SOCKET fopen_sink(soap_t *soap, const char *endpoint, const char *host, int port)
+{
+    return sink;
+}
+
+static int fclose_sink(soap_t *soap)
+{
+    return SOAP_OK;
+}
+
+static int fsend_counted(soap_t *soap, const char *s, size_t n)
+{
+    sent += n;
+
+    return SOAP_OK;
+}
+
+static int get_status_send(soap_t *soap)
+{
+    struct _tptz__GetStatus getstatus;
+
+    getstatus.ProfileToken = "Profile_1";
+
+    return soap_send___tptz__GetStatus(soap, "http://192.0.2.1/onvif/ptz_service", NULL,
+            &getstatus);
+}
+
+static int get_settings_send(soap_t *soap)
+{
+    struct _timg__GetImagingSettings getsettings;
+
+    getsettings.VideoSourceToken = "VideoSource_1";
+
+    return soap_send___timg__GetImagingSettings(soap, "http://192.0.2.1/onvif/imaging_service",
+            NULL, &getsettings);
+}
+
+static int pull_send(soap_t *soap)
+{
+    struct _tev__PullMessages pull = { 0 };
+
+    pull.Timeout = 5000;
+    pull.MessageLimit = 16;
+
+    return soap_send___tev__PullMessages(soap, "http://192.0.2.1/onvif/pull_point", NULL, &pull);
+}
+
+struct request
+{
+    const char *what;
+    int (*send)(soap_t *soap);
+    const struct Namespace *service;
+};
+
+static const struct request requests[] = {
+    { "GetStatus", get_status_send, soap_namespaces_ptz },
+    { "GetImagingSettings", get_settings_send, soap_namespaces_imaging },
+    { "PullMessages", pull_send, soap_namespaces_events },
+};
+
+/* returns the bytes of one request, or 0 if gsoap failed to send it */
+static size_t measure(soap_t *soap, struct soap_auth *auth, const struct request *request,
+        const struct Namespace *table, double *us)
+{
+    struct timespec start, end;
+
+    soap_set_namespaces(soap, table);
+
+    for (int i = 0; i < NS_SIZE_WARMUP + NS_SIZE_ROUNDS; ++i) {
+        if (i == NS_SIZE_WARMUP)
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+        sent = 0;
+        soap_auth_apply(auth, soap);
+        /* like soap_async.c every request opens its connection again */
+        soap->socket = SOAP_INVALID_SOCKET;
+
+        if (request->send(soap) != SOAP_OK)
+            return 0;
+
+        soap_end(soap);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *us = ((end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3) /
+            NS_SIZE_ROUNDS;
+
+    return sent;
+}
+
+int main()
+{
+    struct soap_auth auth;
+    soap_t *soap;
+    int failed = 0;
+
+    g_log_output_file = stderr;
+
+    sink = open("/dev/null", O_WRONLY);
+    if (sink < 0)
+        die(ERR_OPEN_DEVNULL, "ns_size: can't open /dev/null");
+
+    soap = soap_new();
+    if (soap == NULL)
+        die(ERR_ALLOC, "ns_size: soap_new() failed");
+
+    soap->fopen = fopen_sink;
+    soap->fclose = fclose_sink;
+    soap->fsend = fsend_counted;
+
+    soap_auth_construct(&auth);
+
+    printf("%-20s %16s %16s\n", "request", "all namespaces", "service table");
+
+    for (size_t i = 0; i < sizeof(requests) / sizeof(requests[0]); ++i) {
+        const struct request *request = &requests[i];
+        size_t all_bytes, service_bytes;
+        double all_us, service_us;
+
+        all_bytes = measure(soap, &auth, request, namespaces, &all_us);
+        service_bytes = measure(soap, &auth, request, request->service, &service_us);
+
+        if (all_bytes == 0 || service_bytes == 0) {
+            printf("%-20s FAIL\n", request->what);
+            failed = 1;
+            continue;
+        }
+
+        printf("%-20s %7zu B %5.1f us %7zu B %5.1f us\n", request->what, all_bytes, all_us,
+                service_bytes, service_us);
+    }
+
+    soap_destroy(soap);
+    soap_end(soap);
+    soap_free(soap);
+    close(sink);
+
+    return failed;
+}
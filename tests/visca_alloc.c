@@ -0,0 +1,106 @@
+#include "bridge.h"
+#include "counting_alloc.h"
+#include "log.h"
+#include "socket.h"
+#include "visca_decode.h"
+#include "visca_framing.h"
+#include <arpa/inet.h>
+#include <string.h>
+
+/* feeds the datagrams a controller sends all day through the visca path with a stubbed
+   bridge and counts the heap allocations they take */
+
+#define VISCA_ALLOC_WARMUP 4
+#define VISCA_ALLOC_ROUNDS 1000
+
+int g_daemonize = 0;
+FILE *g_log_output_file;
+int g_timestamps = 0;
+
+static size_t replies;
+
+/* the camera side is out of scope, every camera is in service and every reply is sent */
+int bridge_camera_in_service(int fd)
+{
+    return 1;
+}
+
+int socket_send_message_udp_event(const struct event_t *event, const buffer_t *message)
+{
+    ++replies;
+    return 0;
+}
+
+struct datagram
+{
+    const char *what;
+    uint8_t data[32];
+    size_t length;
+    /* replies the datagram is answered with */
+    size_t replies;
+};
+
+static const struct datagram datagrams[] = {
+    { "raw command", { 0x81, 0x01, 0x04, 0x07, 0x02, 0xff }, 6, 2 },
+    { "raw inquiry", { 0x81, 0x09, 0x04, 0x47, 0xff }, 5, 1 },
+    { "sony command", { 0x01, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x01,
+                        0x81, 0x01, 0x04, 0x07, 0x02, 0xff }, 14, 2 },
+    { "sony inquiry", { 0x01, 0x10, 0x00, 0x05, 0x00, 0x00, 0x00, 0x02,
+                        0x81, 0x09, 0x04, 0x47, 0xff }, 13, 1 },
+};
+
+/* raw and sony controllers on their own ports, so each keeps its framing cached */
+static void send_datagram(const struct datagram *datagram)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(datagram->data[0] == 0x81 ? 52380 : 52381),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    struct event_t event = {
+        .fd = 3,
+        .addr = (struct sockaddr*)&addr,
+        .addr_len = sizeof(addr),
+    };
+    uint8_t data[sizeof(datagram->data)];
+    buffer_t message = { datagram->length, data };
+
+    /* sony_visca.c converts the header in place */
+    memcpy(data, datagram->data, datagram->length);
+    visca_framing_handle_message(&message, &event);
+}
+
+int main()
+{
+    int failed = 0, ok;
+
+    g_log_output_file = fopen("/dev/null", "w");
+
+    if (g_log_output_file == NULL)
+        die(ERR_UNSPECIFIED, "visca_alloc: can't open /dev/null");
+
+    visca_decode_init();
+
+    for (size_t i = 0; i < sizeof(datagrams) / sizeof(datagrams[0]); ++i) {
+        const struct datagram *datagram = &datagrams[i];
+
+        for (int j = 0; j < VISCA_ALLOC_WARMUP; ++j)
+            send_datagram(datagram);
+
+        g_allocations = replies = 0;
+        g_alloc_counting = 1;
+
+        for (int j = 0; j < VISCA_ALLOC_ROUNDS; ++j)
+            send_datagram(datagram);
+
+        g_alloc_counting = 0;
+
+        ok = g_allocations == 0 && replies == datagram->replies * VISCA_ALLOC_ROUNDS;
+        failed |= !ok;
+
+        printf("%-12s %s: %zu allocations, %zu replies in %d rounds\n", datagram->what,
+                ok ? "ok" : "FAIL", g_allocations, replies, VISCA_ALLOC_ROUNDS);
+    }
+
+    return failed;
+}
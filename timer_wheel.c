@@ -0,0 +1,170 @@
+#include "timer_wheel.h"
+#include <string.h>
+#include <time.h>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_MAX_DELTA ((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+static __thread struct timer_wheel wheel;
+
+uint64_t timer_wheel_now_ms()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void link_timer(struct wheel_timer **head, struct wheel_timer *timer)
+{
+    timer->next = *head;
+    if (timer->next != NULL)
+        timer->next->pprev = &timer->next;
+
+    timer->pprev = head;
+    *head = timer;
+}
+
+static void unlink_timer(struct wheel_timer *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != NULL)
+        timer->next->pprev = timer->pprev;
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+static void place(struct wheel_timer *timer)
+{
+    uint64_t delta = timer->expires - wheel.current;
+    int level = 0;
+
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1)))
+        ++level;
+
+    link_timer(&wheel.slots[level][(timer->expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK],
+            timer);
+}
+
+/* moves the timers of one slot of a higher level to the levels below */
+static void cascade(int level)
+{
+    uint64_t idx = (wheel.current >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    struct wheel_timer *it = wheel.slots[level][idx], *next;
+
+    wheel.slots[level][idx] = NULL;
+
+    for (; it != NULL; it = next) {
+        next = it->next;
+        it->next = NULL;
+        place(it);
+    }
+}
+
+void timer_wheel_init()
+{
+    memset(&wheel, 0, sizeof(struct timer_wheel));
+
+    wheel.current = timer_wheel_now_ms() / TIMER_WHEEL_TICK_MS;
+}
+
+void wheel_timer_init(struct wheel_timer *timer, void (*cb)(void *data), void *data)
+{
+    timer->cb = cb;
+    timer->data = data;
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+void timer_wheel_schedule(struct wheel_timer *timer, uint64_t delay_ms)
+{
+    uint64_t expires = (timer_wheel_now_ms() + delay_ms + TIMER_WHEEL_TICK_MS - 1)
+        / TIMER_WHEEL_TICK_MS;
+
+    if (timer->pprev != NULL)
+        timer_wheel_cancel(timer);
+
+    /* never the slot that is being run */
+    if (expires <= wheel.current)
+        expires = wheel.current + 1;
+
+    if (expires - wheel.current >= TIMER_WHEEL_MAX_DELTA)
+        expires = wheel.current + TIMER_WHEEL_MAX_DELTA - 1;
+
+    timer->expires = expires;
+
+    place(timer);
+
+    ++wheel.pending;
+}
+
+void timer_wheel_cancel(struct wheel_timer *timer)
+{
+    if (timer->pprev == NULL)
+        return;
+
+    unlink_timer(timer);
+
+    --wheel.pending;
+}
+
+int timer_wheel_pending(const struct wheel_timer *timer)
+{
+    return timer->pprev != NULL;
+}
+
+/* milliseconds until the next tick that has work, for the epoll_wait() timeout. with only
+   far timers pending this is the next wrap of level 0, where they are cascaded */
+int timer_wheel_next_timeout()
+{
+    uint64_t ticks = TIMER_WHEEL_SLOTS - (wheel.current & TIMER_WHEEL_MASK), now, due;
+
+    if (wheel.pending == 0)
+        return -1;
+
+    for (uint64_t i = 1; i < TIMER_WHEEL_SLOTS; ++i)
+        if (wheel.slots[0][(wheel.current + i) & TIMER_WHEEL_MASK] != NULL) {
+            ticks = i;
+            break;
+        }
+
+    now = timer_wheel_now_ms();
+    due = (wheel.current + ticks) * TIMER_WHEEL_TICK_MS;
+
+    return due <= now ? 0 : (int)(due - now);
+}
+
+void timer_wheel_run()
+{
+    uint64_t target = timer_wheel_now_ms() / TIMER_WHEEL_TICK_MS;
+    struct wheel_timer *expired, *timer;
+
+    while (wheel.current < target) {
+        ++wheel.current;
+
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+            if ((wheel.current >> (TIMER_WHEEL_BITS * (level - 1))) & TIMER_WHEEL_MASK)
+                break;
+
+            cascade(level);
+        }
+
+        /* detached first, so callbacks may schedule and cancel freely */
+        expired = wheel.slots[0][wheel.current & TIMER_WHEEL_MASK];
+        wheel.slots[0][wheel.current & TIMER_WHEEL_MASK] = NULL;
+
+        if (expired != NULL)
+            expired->pprev = &expired;
+
+        while (expired != NULL) {
+            timer = expired;
+
+            unlink_timer(timer);
+            --wheel.pending;
+
+            timer->cb(timer->data);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_TICK_MS 10
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+
+/* a timer embedded by its owner. it is pending while pprev is set */
+struct wheel_timer
+{
+    uint64_t expires;
+    void (*cb)(void *data);
+    void *data;
+    struct wheel_timer *next, **pprev;
+};
+
+/* hierarchical timing wheel of one event loop thread: level 0 holds timers due within
+   TIMER_WHEEL_SLOTS ticks, every further level covers TIMER_WHEEL_SLOTS times more and is
+   cascaded down whenever the level below wraps */
+struct timer_wheel
+{
+    uint64_t current;
+    size_t pending;
+    struct wheel_timer *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
+uint64_t timer_wheel_now_ms();
+void timer_wheel_init();
+void wheel_timer_init(struct wheel_timer *timer, void (*cb)(void *data), void *data);
+void timer_wheel_schedule(struct wheel_timer *timer, uint64_t delay_ms);
+void timer_wheel_cancel(struct wheel_timer *timer);
+int timer_wheel_pending(const struct wheel_timer *timer);
+int timer_wheel_next_timeout();
+void timer_wheel_run();
@@ -0,0 +1,249 @@
+#define _GNU_SOURCE
+
+#include "udp_outbox.h"
+#include "errors.h"
+#include "log.h"
+#include "worker.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static __thread struct udp_outbox *dirty_outboxes;
+
+struct udp_outbox* udp_outbox_create(struct ap_state *state, struct event_t *event)
+{
+    struct udp_outbox *outbox = calloc(1, sizeof(struct udp_outbox));
+    if (outbox == NULL)
+        die(ERR_NOMEM, "failed to calloc(%zd)", sizeof(struct udp_outbox));
+
+    outbox->state = state;
+    outbox->event = event;
+
+    return outbox;
+}
+
+void udp_outbox_destroy(struct udp_outbox *outbox)
+{
+    struct udp_outbox **it = &dirty_outboxes;
+
+    if (outbox == NULL)
+        return;
+
+    while (*it != NULL && *it != outbox)
+        it = &(*it)->next_dirty;
+
+    if (*it != NULL)
+        *it = outbox->next_dirty;
+
+#ifdef VOPROXYD_URING
+    /* what was not handed over yet is dropped, the rest goes out before the fd is closed */
+    if (outbox->sending > 0) {
+        uring_submit(outbox->state);
+        outbox->count = outbox->sending;
+        outbox->closing = 1;
+        return;
+    }
+#endif
+
+    free(outbox);
+}
+
+static void mark_dirty(struct udp_outbox *outbox)
+{
+    if (outbox->dirty)
+        return;
+
+    outbox->dirty = 1;
+    outbox->next_dirty = dirty_outboxes;
+    dirty_outboxes = outbox;
+}
+
+static int flush(struct udp_outbox *outbox);
+
+/* sends what the socket takes, the rest waits for EPOLLOUT */
+static void send_queued(struct udp_outbox *outbox)
+{
+    if (flush(outbox) == 0) {
+        if (outbox->blocked) {
+            outbox->blocked = 0;
+            worker_want_write(outbox->event, 0);
+        }
+        return;
+    }
+
+    if (outbox->blocked)
+        return;
+
+    log("udp_outbox: socket buffer of fd = %d is full, waiting for EPOLLOUT", outbox->event->fd);
+    outbox->blocked = 1;
+    worker_want_write(outbox->event, 1);
+}
+
+/* a full queue is sent right away, the datagram is only dropped when the socket buffer is
+   full too. returns 1 if it was dropped */
+int udp_outbox_push(struct udp_outbox *outbox, const struct sockaddr *addr, socklen_t addr_len,
+        const uint8_t *data, size_t length)
+{
+    struct udp_outbox_entry *entry;
+
+    if (outbox->count == UDP_OUTBOX_CAPACITY)
+        send_queued(outbox);
+
+#ifdef VOPROXYD_URING
+    /* the ring may be done with some of the entries already */
+    if (outbox->count == UDP_OUTBOX_CAPACITY)
+        uring_reap_sends(outbox->state);
+#endif
+
+    if (outbox->count == UDP_OUTBOX_CAPACITY) {
+        log("udp_outbox: queue of fd = %d is full, dropping datagram", outbox->event->fd);
+        return 1;
+    }
+
+    if (length > UDP_OUTBOX_MAX_DATAGRAM_LENGTH || addr_len > sizeof(struct sockaddr_storage)) {
+        log("udp_outbox: datagram of length %zu is too long", length);
+        return 1;
+    }
+
+    entry = &outbox->entries[(outbox->head + outbox->count) % UDP_OUTBOX_CAPACITY];
+
+    memcpy(&entry->addr, addr, addr_len);
+    entry->addr_len = addr_len;
+    memcpy(entry->data, data, length);
+    entry->length = length;
+
+    ++outbox->count;
+
+    if (!outbox->blocked)
+        mark_dirty(outbox);
+
+    return 0;
+}
+
+#ifdef VOPROXYD_URING
+/* the ring waits for socket space itself, so the queue is always handed over in full.
+   consecutive datagrams to the same controller are linked to keep ACK before completion */
+static int flush(struct udp_outbox *outbox)
+{
+    struct udp_outbox_entry *entry, *next;
+
+    for (; outbox->sending < outbox->count; ++outbox->sending) {
+        entry = &outbox->entries[(outbox->head + outbox->sending) % UDP_OUTBOX_CAPACITY];
+        next = &outbox->entries[(outbox->head + outbox->sending + 1) % UDP_OUTBOX_CAPACITY];
+
+        entry->iov.iov_base = entry->data;
+        entry->iov.iov_len = entry->length;
+
+        memset(&entry->msg, 0, sizeof(struct msghdr));
+        entry->msg.msg_name = &entry->addr;
+        entry->msg.msg_namelen = entry->addr_len;
+        entry->msg.msg_iov = &entry->iov;
+        entry->msg.msg_iovlen = 1;
+
+        entry->outbox = outbox;
+        entry->in_flight = 1;
+
+        uring_send(outbox->state, outbox->event, &entry->msg, entry,
+                outbox->sending + 1 < outbox->count && entry->addr_len == next->addr_len
+                && memcmp(&entry->addr, &next->addr, entry->addr_len) == 0);
+    }
+
+    return 0;
+}
+
+/* completions may come out of order, an entry is freed once the ones before it are */
+void udp_outbox_handle_sent(struct udp_outbox_entry *entry)
+{
+    struct udp_outbox *outbox = entry->outbox;
+
+    entry->in_flight = 0;
+
+    while (outbox->sending > 0 && !outbox->entries[outbox->head].in_flight) {
+        outbox->head = (outbox->head + 1) % UDP_OUTBOX_CAPACITY;
+        --outbox->count;
+        --outbox->sending;
+    }
+
+    if (outbox->closing && outbox->sending == 0)
+        free(outbox);
+}
+#else
+/* sends as much of the queue as the socket takes, returns 1 if the socket buffer is full */
+static int flush(struct udp_outbox *outbox)
+{
+    struct mmsghdr msgs[UDP_OUTBOX_CAPACITY];
+    struct iovec iovecs[UDP_OUTBOX_CAPACITY];
+    struct udp_outbox_entry *entry;
+    int sent;
+
+    while (outbox->count > 0) {
+        /* the queue is a ring, one sendmmsg() covers the part up to its end */
+        size_t batch = outbox->count;
+
+        if (outbox->head + batch > UDP_OUTBOX_CAPACITY)
+            batch = UDP_OUTBOX_CAPACITY - outbox->head;
+
+        for (size_t i = 0; i < batch; ++i) {
+            entry = &outbox->entries[outbox->head + i];
+
+            iovecs[i].iov_base = entry->data;
+            iovecs[i].iov_len = entry->length;
+
+            memset(&msgs[i], 0, sizeof(struct mmsghdr));
+            msgs[i].msg_hdr.msg_name = &entry->addr;
+            msgs[i].msg_hdr.msg_namelen = entry->addr_len;
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        sent = sendmmsg(outbox->event->fd, msgs, batch, MSG_DONTWAIT);
+
+        if (sent == -1) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return 1;
+
+            if (errno == EINTR)
+                continue;
+
+            /* the datagram at the head is the one that failed, it is dropped */
+            log("failed to send datagram to fd = %d: %s", outbox->event->fd, strerror(errno));
+            sent = 1;
+        }
+
+        outbox->head = (outbox->head + (size_t)sent) % UDP_OUTBOX_CAPACITY;
+        outbox->count -= (size_t)sent;
+    }
+
+    outbox->head = 0;
+
+    return 0;
+}
+#endif
+
+void udp_outbox_handle_writable(struct udp_outbox *outbox)
+{
+    if (outbox->blocked)
+        send_queued(outbox);
+}
+
+/* at the end of a read turn of the socket, so the replies don't wait for the other sockets */
+void udp_outbox_flush(struct udp_outbox *outbox)
+{
+    if (outbox->count > 0 && !outbox->blocked)
+        send_queued(outbox);
+}
+
+void udp_outbox_flush_all()
+{
+    struct udp_outbox *outbox;
+
+    while (dirty_outboxes != NULL) {
+        outbox = dirty_outboxes;
+        dirty_outboxes = outbox->next_dirty;
+
+        outbox->dirty = 0;
+        outbox->next_dirty = NULL;
+
+        udp_outbox_flush(outbox);
+    }
+}
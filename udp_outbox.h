@@ -0,0 +1,56 @@
+#pragma once
+
+#include "epoll.h"
+#include <netinet/in.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+/* holds the replies of a full read turn of the socket, an ACK and a completion for each
+   datagram, see VOPROXYD_RX_BUDGET in worker.c */
+#define UDP_OUTBOX_CAPACITY 128
+#define UDP_OUTBOX_MAX_DATAGRAM_LENGTH 64
+
+struct udp_outbox_entry
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    size_t length;
+    uint8_t data[UDP_OUTBOX_MAX_DATAGRAM_LENGTH];
+#ifdef VOPROXYD_URING
+    /* the ring sends straight from the entry, it stays taken until its completion */
+    struct msghdr msg;
+    struct iovec iov;
+    struct udp_outbox *outbox;
+    int in_flight;
+#endif
+};
+
+/* replies queued on one udp socket, sent with one sendmmsg() after each read turn of the
+   socket. blocked is set while the socket buffer is full and EPOLLOUT is armed */
+struct udp_outbox
+{
+    struct ap_state *state;
+    struct event_t *event;
+    struct udp_outbox_entry entries[UDP_OUTBOX_CAPACITY];
+    size_t head, count;
+#ifdef VOPROXYD_URING
+    /* the entries from head on that were handed to the ring */
+    size_t sending;
+    /* the socket is gone, the last completion frees the outbox */
+    int closing;
+#endif
+    int dirty;
+    int blocked;
+    struct udp_outbox *next_dirty;
+};
+
+struct udp_outbox* udp_outbox_create(struct ap_state *state, struct event_t *event);
+void udp_outbox_destroy(struct udp_outbox *outbox);
+int udp_outbox_push(struct udp_outbox *outbox, const struct sockaddr *addr, socklen_t addr_len,
+        const uint8_t *data, size_t length);
+void udp_outbox_handle_writable(struct udp_outbox *outbox);
+void udp_outbox_flush(struct udp_outbox *outbox);
+void udp_outbox_flush_all();
+#ifdef VOPROXYD_URING
+void udp_outbox_handle_sent(struct udp_outbox_entry *entry);
+#endif
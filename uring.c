@@ -0,0 +1,245 @@
+#ifdef VOPROXYD_URING
+
+#define _GNU_SOURCE
+
+#include "uring.h"
+#include "epoll.h"
+#include "errors.h"
+#include "log.h"
+#include "udp_outbox.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the user_data of a completion on the receive ring holds its operation in the low bits,
+   then the fd and the generation of the socket's record in the high half. the record of a
+   closed fd may already serve a new socket with the same number */
+enum uring_op
+{
+    URING_OP_RECV = 0,
+    URING_OP_CANCEL,
+};
+
+#define URING_OP_BITS 2
+#define URING_OP_MASK ((1ull << URING_OP_BITS) - 1)
+#define URING_FD_MASK ((1ull << (32 - URING_OP_BITS)) - 1)
+
+static void set_data(struct io_uring_sqe *sqe, const struct event_t *event, enum uring_op op)
+{
+    uint64_t data = op;
+
+    if (event != NULL)
+        data |= (uint64_t)event->generation << 32u
+            | ((uint64_t)event->fd & URING_FD_MASK) << URING_OP_BITS;
+
+    io_uring_sqe_set_data64(sqe, data);
+}
+
+static struct io_uring_sqe* get_sqe(struct io_uring *ring)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    int err;
+
+    if (sqe != NULL)
+        return sqe;
+
+    /* the submission queue is full, hand it to the kernel and try again */
+    err = io_uring_submit(ring);
+    if (err < 0)
+        die(ERR_URING, "io_uring_submit() failed: %s", strerror(-err));
+
+    sqe = io_uring_get_sqe(ring);
+    if (sqe == NULL)
+        die(ERR_URING, "io_uring submission queue is full");
+
+    return sqe;
+}
+
+static void give_buffer(struct uring_t *uring, int bid)
+{
+    io_uring_buf_ring_add(uring->buf_ring, uring->buffers + (size_t)bid * URING_RX_BUFFER_LENGTH,
+            URING_RX_BUFFER_LENGTH, bid, io_uring_buf_ring_mask(URING_RX_BUFFERS), 0);
+    io_uring_buf_ring_advance(uring->buf_ring, 1);
+}
+
+void uring_construct(struct ap_state *state)
+{
+    struct uring_t *uring = &state->uring;
+    int err;
+
+    err = io_uring_queue_init(URING_ENTRIES, &uring->ring, 0);
+    if (err < 0)
+        die(ERR_URING, "io_uring_queue_init() failed: %s", strerror(-err));
+
+    err = io_uring_queue_init(URING_ENTRIES, &uring->send_ring, 0);
+    if (err < 0)
+        die(ERR_URING, "io_uring_queue_init() failed: %s", strerror(-err));
+
+    uring->buf_ring = io_uring_setup_buf_ring(&uring->ring, URING_RX_BUFFERS,
+            URING_RX_BUFFER_GROUP, 0, &err);
+    if (uring->buf_ring == NULL)
+        die(ERR_URING, "io_uring_setup_buf_ring() failed: %s", strerror(-err));
+
+    uring->buffers = malloc((size_t)URING_RX_BUFFERS * URING_RX_BUFFER_LENGTH);
+    if (uring->buffers == NULL)
+        die(ERR_NOMEM, "failed to malloc(%d)", URING_RX_BUFFERS * URING_RX_BUFFER_LENGTH);
+
+    for (int bid = 0; bid < URING_RX_BUFFERS; ++bid)
+        give_buffer(uring, bid);
+
+    /* multishot recvmsg only takes the name and control lengths from this header */
+    memset(&uring->recv_msg, 0, sizeof(struct msghdr));
+    uring->recv_msg.msg_namelen = sizeof(struct sockaddr_in);
+
+    epoll_add_fd(state, uring->ring.ring_fd, FDT_URING, 1);
+    epoll_add_fd(state, uring->send_ring.ring_fd, FDT_URING, 1);
+}
+
+void uring_destruct(struct ap_state *state)
+{
+    struct uring_t *uring = &state->uring;
+
+    io_uring_free_buf_ring(&uring->ring, uring->buf_ring, URING_RX_BUFFERS,
+            URING_RX_BUFFER_GROUP);
+    io_uring_queue_exit(&uring->ring);
+    io_uring_queue_exit(&uring->send_ring);
+
+    free(uring->buffers);
+}
+
+void uring_arm_recv(struct ap_state *state, struct event_t *event)
+{
+    struct io_uring_sqe *sqe = get_sqe(&state->uring.ring);
+
+    io_uring_prep_recvmsg_multishot(sqe, event->fd, &state->uring.recv_msg, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_RX_BUFFER_GROUP;
+
+    set_data(sqe, event, URING_OP_RECV);
+}
+
+void uring_cancel_fd(struct ap_state *state, int fd)
+{
+    struct io_uring_sqe *sqe = get_sqe(&state->uring.ring);
+
+    io_uring_prep_cancel_fd(sqe, fd, IORING_ASYNC_CANCEL_ALL);
+
+    set_data(sqe, NULL, URING_OP_CANCEL);
+
+    uring_submit(state);
+}
+
+/* msg and what it points to belong to the caller until the completion hands data, an
+   outbox entry, back to udp_outbox_handle_sent(). link chains this send to the next one, so
+   an ACK always leaves before its completion */
+void uring_send(struct ap_state *state, struct event_t *event, struct msghdr *msg, void *data,
+        int link)
+{
+    struct io_uring_sqe *sqe = get_sqe(&state->uring.send_ring);
+
+    io_uring_prep_sendmsg(sqe, event->fd, msg, 0);
+    if (link)
+        sqe->flags |= IOSQE_IO_LINK;
+
+    /* everything on the send ring is a send, its user_data is the bare pointer */
+    io_uring_sqe_set_data(sqe, data);
+}
+
+static void submit(struct io_uring *ring)
+{
+    int err = io_uring_submit(ring);
+
+    if (err < 0 && err != -EBUSY && err != -EINTR)
+        die(ERR_URING, "io_uring_submit() failed: %s", strerror(-err));
+}
+
+void uring_submit(struct ap_state *state)
+{
+    submit(&state->uring.send_ring);
+    submit(&state->uring.ring);
+}
+
+/* hands the queued sends to the kernel and frees the outbox entries of those it finished */
+void uring_reap_sends(struct ap_state *state)
+{
+    struct io_uring *ring = &state->uring.send_ring;
+    struct io_uring_cqe *cqe;
+
+    submit(ring);
+
+    while (io_uring_peek_cqe(ring, &cqe) == 0) {
+        if (cqe->res < 0)
+            log("uring: sendmsg failed: %s", strerror(-cqe->res));
+
+        udp_outbox_handle_sent(io_uring_cqe_get_data(cqe));
+
+        io_uring_cqe_seen(ring, cqe);
+    }
+}
+
+static void handle_recv(struct ap_state *state, uint64_t data, const struct io_uring_cqe *cqe,
+        uring_datagram_cb on_datagram)
+{
+    struct uring_t *uring = &state->uring;
+    struct event_t *event = epoll_find_event(state, (int)((data >> URING_OP_BITS) & URING_FD_MASK));
+    struct io_uring_recvmsg_out *out;
+    uint8_t *buffer;
+    int bid;
+
+    /* the socket was closed and its record released or reused in the meantime */
+    if (event == NULL || event->generation != (uint16_t)(data >> 32u) || event->type != FDT_UDP) {
+        if (cqe->flags & IORING_CQE_F_BUFFER)
+            give_buffer(uring, (int)(cqe->flags >> IORING_CQE_BUFFER_SHIFT));
+        return;
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_MORE) && cqe->res != -ECANCELED && cqe->res != -EBADF)
+        uring_arm_recv(state, event);
+
+    if (cqe->res < 0) {
+        if (cqe->res != -ENOBUFS && cqe->res != -ECANCELED)
+            log("uring: recvmsg on fd = %d failed: %s", event->fd, strerror(-cqe->res));
+        return;
+    }
+
+    if (!(cqe->flags & IORING_CQE_F_BUFFER))
+        return;
+
+    bid = (int)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    buffer = uring->buffers + (size_t)bid * URING_RX_BUFFER_LENGTH;
+
+    out = io_uring_recvmsg_validate(buffer, cqe->res, &uring->recv_msg);
+
+    if (out != NULL && !(out->flags & MSG_TRUNC))
+        on_datagram(state, event, io_uring_recvmsg_name(out), out->namelen,
+                io_uring_recvmsg_payload(out, &uring->recv_msg),
+                io_uring_recvmsg_payload_length(out, cqe->res, &uring->recv_msg));
+    else
+        log("uring: dropping malformed datagram on fd = %d", event->fd);
+
+    give_buffer(uring, bid);
+}
+
+void uring_handle_completions(struct ap_state *state, uring_datagram_cb on_datagram)
+{
+    struct io_uring_cqe *cqe;
+    uint64_t data;
+
+    while (io_uring_peek_cqe(&state->uring.ring, &cqe) == 0) {
+        data = io_uring_cqe_get_data64(cqe);
+
+        switch (data & URING_OP_MASK) {
+        case URING_OP_RECV:
+            handle_recv(state, data, cqe, on_datagram);
+            break;
+        default:
+            break;
+        }
+
+        io_uring_cqe_seen(&state->uring.ring, cqe);
+    }
+
+    uring_reap_sends(state);
+}
+
+#endif
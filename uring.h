@@ -0,0 +1,44 @@
+#pragma once
+
+#ifdef VOPROXYD_URING
+
+#include <liburing.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#define URING_ENTRIES 256
+#define URING_RX_BUFFERS 64
+#define URING_RX_BUFFER_LENGTH 4096
+#define URING_RX_BUFFER_GROUP 0
+
+struct ap_state;
+struct event_t;
+
+/* io_uring of one event loop. its fd sits in the epoll set as FDT_URING, camera udp
+   sockets are served by multishot recvmsg on it instead of epoll readiness */
+struct uring_t
+{
+    struct io_uring ring;
+    /* sends complete on a ring of their own, so a full outbox can reap them while the
+       completions of the other ring are being handled */
+    struct io_uring send_ring;
+    struct io_uring_buf_ring *buf_ring;
+    uint8_t *buffers;
+    struct msghdr recv_msg;
+};
+
+typedef void (*uring_datagram_cb)(struct ap_state *state, struct event_t *event,
+        struct sockaddr *addr, socklen_t addr_len, uint8_t *data, size_t length);
+
+void uring_construct(struct ap_state *state);
+void uring_destruct(struct ap_state *state);
+void uring_arm_recv(struct ap_state *state, struct event_t *event);
+void uring_cancel_fd(struct ap_state *state, int fd);
+void uring_send(struct ap_state *state, struct event_t *event, struct msghdr *msg, void *data,
+        int link);
+void uring_submit(struct ap_state *state);
+void uring_reap_sends(struct ap_state *state);
+void uring_handle_completions(struct ap_state *state, uring_datagram_cb on_datagram);
+
+#endif
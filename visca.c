@@ -1,7 +1,7 @@
 #include "visca.h"
+#include "bridge.h"
 #include "log.h"
-#include "bridge_commands.h"
-#include "bridge_inquiries.h"
+#include "visca_decode.h"
 
 #undef die
 #define die(...) die_detail(ERR_VISCA_PROTOCOL, __VA_ARGS__)
@@ -14,448 +14,74 @@
 #define bad_byte_null(X) bad_byte_detail(X, NULL)
 #define bad_byte(X) bad_byte_detail(X, )
 
-#define check_length_detail(X, R) \
-    if (message->length != (X)) { \
-        log("%s: bad length %zu, expected %d", __func__, message->length, X); \
-        return R; \
-    }
-#define check_length_null(X) check_length_detail(X, NULL)
-#define check_length(X) check_length_detail(X, )
+/* replies that never change are sent from these, the others are composed on the caller's
+   stack. a command then takes no allocation on its way through */
+static uint8_t ack_data[] = { 0x90, 0x40, 0xff };
+static uint8_t empty_completition_data[] = { 0x90, 0x50, 0xff };
 
-static uint64_t parse_retarded_integer_encoding(const buffer_t *message, size_t start, size_t n)
-{
-    uint64_t output = 0;
+const buffer_t visca_ack = BUFFER_OF(ack_data);
+const buffer_t visca_empty_completition = BUFFER_OF(empty_completition_data);
 
-    for (size_t i = 0; i < n; ++i)
-        output = (output << 4u) | (message->data[start + i] & 0x0fu);
-
-    return output;
-}
-
-static uint64_t parse_sane_integer_encoding(const buffer_t *message, size_t start, size_t n)
+/* response holds at least VISCA_MAX_REPLY_LENGTH bytes */
+buffer_t* compose_completition(buffer_t *response, const buffer_t *data)
 {
-    uint64_t output = 0;
-
-    for (size_t i = 0; i < n; ++i)
-        output = (output << 8u) | (message->data[start + i] & 0xffu);
-
-    return output;
-}
-
-buffer_t* compose_ack()
-{
-    buffer_t *response = cons_buffer(3);
-
-    response->data[0] = 0x90;
-    response->data[1] = 0x40;
-    response->data[2] = 0xff;
-
-    return response;
-}
-
-buffer_t* compose_completition(buffer_t *data)
-{
-    size_t data_len = (data == NULL) ? 0 : data->length;
-    buffer_t *response = cons_buffer(3 + data_len);
-
     response->data[0] = 0x90;
     response->data[1] = 0x50;
 
-    for (size_t i = 0; i < data_len; ++i) {
+    for (size_t i = 0; i < data->length; ++i) {
         response->data[2 + i] = data->data[i];
     }
 
-    response->data[2 + data_len] = 0xff;
+    response->data[2 + data->length] = 0xff;
+    response->length = 3 + data->length;
 
     return response;
 }
 
-buffer_t* compose_empty_completition()
-{
-    return compose_completition(NULL);
-}
-
-static void dispatch_commands_04(const buffer_t *message, const struct event_t *event)
+buffer_t* compose_error(buffer_t *response, uint8_t code)
 {
-    uint8_t b4 = message->data[4], b5 = message->data[5];
+    response->data[0] = 0x90;
+    response->data[1] = 0x60;
+    response->data[2] = code;
+    response->data[3] = 0xff;
+    response->length = 4;
 
-    switch (message->data[3]) {
-    case 0x03:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_color_rgain_reset();
-            break;
-        case 0x02:
-            bridge_cmd_color_rgain_up();
-            break;
-        case 0x03:
-            bridge_cmd_color_rgain_down();
-            break;
-        }
-        break;
-    case 0x04:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_color_bgain_reset();
-            break;
-        case 0x02:
-            bridge_cmd_color_bgain_up();
-            break;
-        case 0x03:
-            bridge_cmd_color_bgain_down();
-            break;
-        }
-        break;
-    case 0x07:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_zoom_stop();
-            break;
-        case 0x02:
-            bridge_cmd_zoom_tele();
-            break;
-        case 0x03:
-            bridge_cmd_zoom_wide();
-            break;
-        default:
-            if ((b4 & 0xf0) == 0x20) {
-                b4 = b4 & 0x0f;
-                bridge_cmd_zoom_tele_var(b4);
-            } else if ((b4 & 0xf0) == 0x30) {
-                b4 = b4 & 0x0f;
-                bridge_cmd_zoom_wide_var(b4);
-            } else {
-                bad_byte(4);
-            }
-        }
-        break;
-    case 0x08:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_focus_stop();
-            break;
-        case 0x02:
-            bridge_cmd_focus_far();
-            break;
-        case 0x03:
-            bridge_cmd_focus_near();
-            break;
-        default:
-            if ((b4 & 0xf0) == 2) {
-                b4 = b4 & 0x0f;
-                bridge_cmd_focus_far_var(b4);
-            } else if ((b4 & 0xf0) == 3) {
-                b4 = b4 & 0x0f;
-                bridge_cmd_focus_near_var(b4);
-            } else {
-                bad_byte(4);
-            }
-        }
-        break;
-    case 0x0A:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_exposure_shutter_reset();
-            break;
-        case 0x02:
-            bridge_cmd_exposure_shutter_fast();
-            break;
-        case 0x03:
-            bridge_cmd_exposure_shutter_slow();
-            break;
-        }
-        break;
-    case 0x0B:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_exposure_iris_reset();
-            break;
-        case 0x02:
-            bridge_cmd_exposure_iris_up();
-            break;
-        case 0x03:
-            bridge_cmd_exposure_iris_down();
-            break;
-        }
-        break;
-    case 0x23:
-        bridge_cmd_flicker_reduction_mode_set(b4);
-        break;
-    case 0x33:
-        switch (message->data[4]) {
-        case 0x02:
-            bridge_cmd_exposure_back_light_set(1);
-            break;
-        case 0x03:
-            bridge_cmd_exposure_back_light_set(0);
-            break;
-        }
-        break;
-    case 0x38:
-        switch (message->data[4]) {
-        case 0x02:
-            bridge_cmd_focus_mode_auto();
-            break;
-        case 0x03:
-            bridge_cmd_focus_mode_auto();
-            break;
-        case 0x10:
-            bridge_cmd_focus_mode_toggle();
-            break;
-        }
-        break;
-    case 0x39:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_exposure_mode_full_auto();
-            break;
-        case 0x03:
-            bridge_cmd_exposure_mode_manual();
-            break;
-        case 0x0A:
-            bridge_cmd_exposure_mode_shutter_pri();
-            break;
-        case 0x0B:
-            bridge_cmd_exposure_mode_iris_pri();
-            break;
-        case 0x0D:
-            bridge_cmd_exposure_mode_gain_pri();
-            break;
-        }
-        break;
-    case 0x3F:
-        switch (message->data[4]) {
-        case 0x00:
-            bridge_cmd_memory_reset(b5);
-            break;
-        case 0x01:
-            bridge_cmd_memory_set(b5);
-            break;
-        case 0x02:
-            bridge_cmd_memory_recall(b5);
-            break;
-        }
-        break;
-    case 0x47:
-        bridge_cmd_zoom_direct(parse_retarded_integer_encoding(message, 4, 4));
-        break;
-    case 0x48:
-        bridge_cmd_focus_direct(parse_retarded_integer_encoding(message, 4, 4));
-        break;
-    case 0x4A:
-        bridge_cmd_exposure_shutter_direct(parse_retarded_integer_encoding(message, 6, 2));
-        break;
-    case 0x4B:
-        bridge_cmd_exposure_iris_direct(parse_retarded_integer_encoding(message, 6, 2));
-        break;
-    case 0x66:
-        switch (message->data[4]) {
-        case 0x02:
-            bridge_cmd_system_img_flip(1);
-            break;
-        case 0x03:
-            bridge_cmd_system_img_flip(0);
-            break;
-        }
-        break;
-    }
+    return response;
 }
 
-static void ptd_abs_rel(const buffer_t *message, int rel)
+/* a command for a camera that is bootstrapping or out of service is answered with an error
+   right away instead of an ack for something that never happens */
+int visca_can_take_command(const struct event_t *event)
 {
-    uint8_t pan_speed, tilt_speed;
-    uint64_t preset;
-
-    pan_speed = message->data[4];
-    tilt_speed = message->data[5];
-
-    preset = parse_sane_integer_encoding(message, 6, 8);
-
-    bridge_cmd_pan_tilt_absolute_preset(pan_speed, tilt_speed, preset);
+    return bridge_camera_in_service(event->fd);
 }
 
-static void dispatch_commands_06(const buffer_t *message, const struct event_t *event)
+int visca_refuse_command(const struct event_t *event)
 {
-    switch (message->data[3]) {
-    case 0x01: {
-        uint8_t pan_speed, tilt_speed;
-        int vert, horiz;
-
-        check_length(9);
-
-        pan_speed = message->data[4];
-        tilt_speed = message->data[5];
-
-        switch (message->data[6]) {
-        case 0x01:
-            horiz = -1;
-            break;
-        case 0x02:
-            horiz = 1;
-            break;
-        case 0x03:
-            horiz = 0;
-            break;
-        default:
-            log("ptd_directionals: unexpected horizontal drive 0x%02x", message->data[6]);
-            return;
-        }
-
-        switch (message->data[7]) {
-        case 0x01:
-            vert = 1;
-            break;
-        case 0x02:
-            vert = -1;
-            break;
-        case 0x03:
-            vert = 0;
-            break;
-        default:
-            log("ptd_directionals: unexpected vertical drive 0x%02x", message->data[7]);
-            return;
-        }
-
-        bridge_cmd_pan_tilt_directionals(vert, horiz, pan_speed, tilt_speed);
-        break;
-    }
-    case 0x02:
-        ptd_abs_rel(message, 0);
-        break;
-    case 0x03:
-        ptd_abs_rel(message, 1);
-        break;
-    case 0x04:
-        bridge_cmd_pan_tilt_home();
-        break;
-    case 0x05:
-        bridge_cmd_pan_tilt_reset();
-        break;
-    default:
-        bad_byte(3);
-    }
-}
+    uint8_t response_data[4];
+    buffer_t response = BUFFER_OF(response_data);
 
-static void dispatch_commands(const buffer_t *message, const struct event_t *event)
-{
-    switch (message->data[2]) {
-    case 0x04:
-        dispatch_commands_04(message, event);
-        break;
-    case 0x06:
-        dispatch_commands_06(message, event);
-        break;
-    }
-}
+    if (visca_can_take_command(event))
+        return 0;
 
-static buffer_t* dispatch_queries_04(const buffer_t *message)
-{
-    switch (message->data[3]) {
-    case 0x47:
-        return bridge_inq_zoom_position();
-    case 0x38:
-        bridge_inq_focus_af_mode();
-        return cons_buffer(1);
-    case 0x48:
-        return bridge_inq_focus_position();
-    case 0x35:
-        bridge_inq_wb_mode();
-        return cons_buffer(1);
-    case 0x43:
-        bridge_inq_r_gain();
-        return cons_buffer(4);
-    case 0x39:
-        bridge_inq_ae_mode();
-        return cons_buffer(1);
-    case 0x4A:
-        bridge_inq_shutter_pos();
-        return cons_buffer(4);
-    case 0x4B:
-        bridge_inq_iris_pos();
-        return cons_buffer(4);
-    case 0x4D:
-        bridge_inq_bright_pos();
-        return cons_buffer(4);
-    case 0x3E:
-        bridge_inq_exp_comp_mode();
-        return cons_buffer(1);
-    case 0x4E:
-        bridge_inq_exp_comp_pos();
-        return cons_buffer(4);
-    case 0x33:
-        bridge_inq_backlight_mode();
-        return cons_buffer(1);
-    case 0x50:
-        bridge_inq_noise2_d_mode();
-        return cons_buffer(1);
-    case 0x53:
-        bridge_inq_noise2_d_l();
-        return cons_buffer(1);
-    case 0x54:
-        bridge_inq_noise3_d_l();
-        return cons_buffer(1);
-    case 0x55:
-        bridge_inq_flicker_mode();
-        return cons_buffer(1);
-    case 0x05:
-        bridge_inq_aperture_mode();
-        return cons_buffer(1);
-    case 0x42:
-        bridge_inq_aperture();
-        return cons_buffer(4);
-    case 0x63:
-        bridge_inq_picture_effect_mode();
-        return cons_buffer(1);
-    case 0x61:
-        bridge_inq_lr_reverse();
-        return cons_buffer(1);
-    case 0x66:
-        bridge_inq_picture_flip();
-        return cons_buffer(1);
-    case 0x49:
-        bridge_inq_color_gain();
-        return cons_buffer(4);
-    case 0x2C:
-        bridge_inq_gain_limit();
-        return cons_buffer(1);
-    case 0xA4:
-        bridge_inq_flip();
-        return cons_buffer(1);
-    case 0xAA:
-        bridge_inq_af_zone();
-        return cons_buffer(1);
-    case 0x4F:
-        bridge_inq_color_hue();
-        return cons_buffer(4);
-    case 0xA9:
-        bridge_inq_awb_sensitivity();
-        return cons_buffer(1);
-    default:
-        bad_byte_null(3);
-    }
-}
+    visca_send_response(event, compose_error(&response, VISCA_ERROR_NOT_EXECUTABLE));
 
-static buffer_t* dispatch_queries(const buffer_t *message)
-{
-    switch (message->data[2]) {
-    case 0x06:
-        if (message->data[3] != 0x12)
-            bad_byte_null(3);
-        return bridge_inq_pan_tilt_position();
-        break;
-    case 0x04:
-        return dispatch_queries_04(message);
-    default:
-        bad_byte_null(2);
-    }
+    return 1;
 }
 
 void visca_handle_message(const buffer_t *message, const struct event_t *event)
 {
-    buffer_t *response, *inquiry_data;
+    uint8_t inquiry_storage[VISCA_MAX_INQUIRY_LENGTH], response_data[VISCA_MAX_REPLY_LENGTH];
+    buffer_t inquiry = BUFFER_OF(inquiry_storage), response = BUFFER_OF(response_data);
+    const buffer_t *inquiry_data;
 
     print_buffer_msg("visca_handle_message new message", message, 16);
 
+    if (message->length < VISCA_MIN_MESSAGE_LENGTH) {
+        log("visca_handle_message: message of %zu bytes is too short", message->length);
+        return;
+    }
+
     if (message->data[0] != 0x81)
         bad_byte(0);
 
@@ -463,31 +89,27 @@ void visca_handle_message(const buffer_t *message, const struct event_t *event)
     case 0x01:
         log("visca: handle command");
 
-        response = compose_ack();
-        visca_send_response(event, response);
-        free_buffer(response);
+        if (visca_refuse_command(event))
+            break;
+
+        visca_send_response(event, &visca_ack);
 
-        dispatch_commands(message, event);
+        visca_decode_command(message->data, message->length, VISCA_DIALECT_RAW);
 
-        response = compose_empty_completition();
-        visca_send_response(event, response);
-        free_buffer(response);
+        visca_send_response(event, &visca_empty_completition);
 
         break;
     case 0x09:
         log("visca: handle inquiry");
 
-        inquiry_data = dispatch_queries(message);
+        inquiry_data = visca_decode_inquiry(message->data, message->length, VISCA_DIALECT_RAW, &inquiry);
 
         if (inquiry_data == NULL) {
             log("visca_handle_message: empty inquiry data");
             return;
         }
 
-        response = compose_completition(inquiry_data);
-        visca_send_response(event, response);
-        free_buffer(response);
-        free_buffer(inquiry_data);
+        visca_send_response(event, compose_completition(&response, inquiry_data));
 
         break;
     default:
@@ -4,6 +4,14 @@
 #include "epoll.h"
 #include "socket.h"
 
+#define VISCA_ERROR_NOT_EXECUTABLE 0x41
+/* the address byte, the class byte and ff */
+#define VISCA_MIN_MESSAGE_LENGTH 3
+/* inquiry data is never longer than a visca payload */
+#define VISCA_MAX_INQUIRY_LENGTH 16
+/* 90 50, the inquiry data and ff */
+#define VISCA_MAX_REPLY_LENGTH (VISCA_MAX_INQUIRY_LENGTH + 3)
+
 #define visca_send_response_detail(E, R, echo) \
     do { \
         if (echo) { \
@@ -19,8 +27,12 @@
 #define visca_send_response_quiet(E, R) \
     visca_send_response_detail(E, R, 0)
 
-buffer_t* compose_ack();
-buffer_t* compose_completition(buffer_t *data);
-buffer_t* compose_empty_completition();
+extern const buffer_t visca_ack;
+extern const buffer_t visca_empty_completition;
+
+buffer_t* compose_completition(buffer_t *response, const buffer_t *data);
+buffer_t* compose_error(buffer_t *response, uint8_t code);
+int visca_can_take_command(const struct event_t *event);
+int visca_refuse_command(const struct event_t *event);
 void visca_handle_message(const buffer_t *message, const struct event_t *event);
 
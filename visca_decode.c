@@ -0,0 +1,528 @@
+#include "visca_decode.h"
+#include "bridge_commands.h"
+#include "bridge_inquiries.h"
+#include "errors.h"
+#include "log.h"
+#include "visca_spec.h"
+#include <stdlib.h>
+
+/* payload bytes 1 to 7 can be matched by a rule, 1 to 3 form the lookup key */
+#define VISCA_PATTERN_LENGTH 7
+#define VISCA_KEY_LENGTH 3
+
+#define RULE_COUNT(R) (sizeof(R) / sizeof((R)[0]))
+
+struct visca_rule
+{
+    const char *name;
+    uint8_t dialects;
+    /* exact payload length or 0 */
+    uint8_t length;
+    /* mask << 8 | value for each payload byte from 1 on */
+    uint16_t pattern[VISCA_PATTERN_LENGTH];
+    void (*command)(const uint8_t *payload);
+    /* one past the last payload byte the arguments of a command are read from */
+    size_t (*extent)(void);
+    buffer_t* (*inquiry)(const uint8_t *payload, buffer_t *inquiry);
+};
+
+/* where a rule sits in the lookup order of its table */
+struct visca_slot
+{
+    uint32_t key;
+    uint16_t rule;
+    /* the pattern bytes to compare */
+    uint8_t pattern_length;
+    /* the rule looks at everything before the ff terminator */
+    uint8_t min_length;
+};
+
+/* rules with a fully given key come first, sorted by key and then by the order of the spec,
+   so a lookup is a binary search and a scan of the few rules that share the key. the
+   others follow in the order of the spec and are tried when no keyed rule matches */
+struct visca_table
+{
+    const char *what;
+    /* the class byte visca.c and sony_visca.c route to the table for each dialect, 0 for any */
+    uint16_t raw_class, sony_class;
+    const struct visca_rule *rules;
+    struct visca_slot *slots;
+    size_t count, keyed;
+};
+
+static uint64_t parse_retarded_integer_encoding(const uint8_t *payload, size_t start, size_t n)
+{
+    uint64_t output = 0;
+
+    for (size_t i = 0; i < n; ++i)
+        output = (output << 4u) | (payload[start + i] & 0x0fu);
+
+    return output;
+}
+
+static uint64_t parse_sane_integer_encoding(const uint8_t *payload, size_t start, size_t n)
+{
+    uint64_t output = 0;
+
+    for (size_t i = 0; i < n; ++i)
+        output = (output << 8u) | (payload[start + i] & 0xffu);
+
+    return output;
+}
+
+static int gain_parameter_to_db(uint8_t p)
+{
+    switch (p) {
+        case 0x0c: return 33;
+        case 0x0b: return 30;
+        case 0x0a: return 27;
+        case 0x09: return 24;
+        case 0x08: return 21;
+        case 0x07: return 18;
+        case 0x06: return 15;
+        case 0x05: return 12;
+        case 0x04: return 9;
+        case 0x03: return 6;
+        case 0x02: return 3;
+        case 0x01: return 0;
+        case 0x00: return -3;
+        default:
+            log("gain_parameter_to_db: invalid byte 0x%02x", p);
+            return 0;
+    }
+}
+
+static void hdmi_video_format_change(uint8_t p)
+{
+    int params[][4] = {
+        [0x00] = { 1920, 1080, 59, 'p' },
+        [0x02] = { 1920, 1080, 29, 'p' },
+        [0x03] = { 1920, 1080, 59, 'i' },
+        [0x04] = { 1280,  720, 59, 'p' },
+        [0x08] = { 1920, 1080, 50, 'p' },
+        [0x0a] = { 1920, 1080, 25, 'p' },
+        [0x0b] = { 1920, 1080, 50, 'i' },
+        [0x0c] = { 1280,  720, 50, 'p' },
+        [0x18] = {  640,  480, 59, 'p' },
+        [0x22] = { 3840, 2160, 29, 'p' },
+        [0x26] = { 3840, 2160, 25, 'p' },
+        [0x28] = { 1920, 1080, 23, 'p' },
+        [0x2a] = { 3840, 2160, 23, 'p' }
+    };
+
+    if (p >= sizeof(params) / sizeof(params[0]) || params[p][0] == 0) {
+        bridge_cmd_hdmi_video_format_change(0, 0, 0, 0);
+        return;
+    }
+
+    bridge_cmd_hdmi_video_format_change(params[p][0], params[p][1], params[p][2], params[p][3]);
+}
+
+static void pan_tilt_directionals(const uint8_t *payload)
+{
+    int vert, horiz;
+
+    switch (payload[6]) {
+        case 0x01:
+            horiz = -1;
+            break;
+        case 0x02:
+            horiz = 1;
+            break;
+        case 0x03:
+            horiz = 0;
+            break;
+        default:
+            log("pan_tilt_directionals: unexpected horizontal drive 0x%02x", payload[6]);
+            return;
+    }
+
+    switch (payload[7]) {
+        case 0x01:
+            vert = 1;
+            break;
+        case 0x02:
+            vert = -1;
+            break;
+        case 0x03:
+            vert = 0;
+            break;
+        default:
+            log("pan_tilt_directionals: unexpected vertical drive 0x%02x", payload[7]);
+            return;
+    }
+
+    bridge_cmd_pan_tilt_directionals(vert, horiz, payload[4], payload[5]);
+}
+
+static void pan_tilt_move(const uint8_t *payload, int rel)
+{
+    uint8_t p[5], t[4];
+
+    if (payload[5] != 0) {
+        log("pan_tilt_move: expected payload[5] to be 0, not 0x%02x", payload[5]);
+        return;
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        p[i] = payload[6 + i];
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        t[i] = payload[11 + i];
+    }
+
+    if (rel) {
+        bridge_cmd_pan_tilt_relative_move(payload[4], p, t);
+    } else {
+        bridge_cmd_pan_tilt_absolute_move(payload[4], p, t);
+    }
+}
+
+static void pan_tilt_limit(const uint8_t *payload)
+{
+    uint8_t p[5], t[4];
+
+    switch (payload[4]) {
+        case 0x00:
+            bridge_cmd_pan_tilt_limit_clear(payload[5]);
+            break;
+        case 0x01:
+            for (int i = 0; i < 5; ++i) {
+                p[i] = payload[6 + i];
+            }
+
+            for (int i = 0; i < 4; ++i) {
+                t[i] = payload[11 + i];
+            }
+
+            bridge_cmd_pan_tilt_limit_set(payload[5], p, t);
+            break;
+        default:
+            log("pan_tilt_limit: unexpected set byte 0x%02x", payload[4]);
+    }
+}
+
+static void pan_tilt_ramp_curve(const uint8_t *payload)
+{
+    int p = payload[4];
+
+    if (p != 1 && p != 2 && p != 3) {
+        log("pan_tilt_ramp_curve: unexpected p %d", p);
+        return;
+    }
+
+    bridge_cmd_pan_tilt_ramp_curve(p);
+}
+
+static void pan_tilt_slow_mode(const uint8_t *payload)
+{
+    int p = payload[4];
+
+    if (p != 2 && p != 3) {
+        log("pan_tilt_slow_mode: unexpected p %d", p);
+        return;
+    }
+
+    bridge_cmd_pan_tilt_slow_mode(p);
+}
+
+/* the vocabulary of visca_spec.h */
+#define B(X) (0xff00u | (X))
+#define HI(X) (0xf000u | (X))
+#define BYTE(I) (payload[I])
+#define LOW(I) (payload[I] & 0x0fu)
+#define ONOFF(I) (payload[I] == 0x02 ? 1 : 0)
+#define NIBBLES(I, N) parse_retarded_integer_encoding(payload, I, N)
+#define WORDS(I, N) parse_sane_integer_encoding(payload, I, N)
+
+#define COMMAND_HANDLER(name, dialects, length, call, args, ...) \
+    static void command_##name(const uint8_t *payload) \
+    { \
+        call args; \
+    }
+#define COMMAND_EXTENT(name, dialects, length, call, args, ...) \
+    static size_t extent_##name(void) \
+    { \
+        const uint8_t *payload = NULL; \
+        size_t extent = 0; \
+        (void)payload; \
+        ARGS args; \
+        return extent; \
+    }
+#define COMMAND_RULE(name, dialects, length, call, args, ...) \
+    { #name, VISCA_DIALECT_##dialects, length, { __VA_ARGS__ }, command_##name, extent_##name, \
+        NULL },
+
+#define INQUIRY_HANDLER(name, dialects, reply, bridge, ...) \
+    static buffer_t* inquiry_##name(const uint8_t *payload, buffer_t *inquiry) \
+    { \
+        bridge(); \
+        return buffer_zero(inquiry, reply); \
+    }
+#define INQUIRY_DATA_HANDLER(name, dialects, bridge, ...) \
+    static buffer_t* inquiry_##name(const uint8_t *payload, buffer_t *inquiry) \
+    { \
+        return bridge(inquiry); \
+    }
+#define INQUIRY_RULE(name, dialects, reply, bridge, ...) \
+    { #name, VISCA_DIALECT_##dialects, 0, { __VA_ARGS__ }, NULL, NULL, inquiry_##name },
+#define INQUIRY_DATA_RULE(name, dialects, bridge, ...) \
+    { #name, VISCA_DIALECT_##dialects, 0, { __VA_ARGS__ }, NULL, NULL, inquiry_##name },
+
+VISCA_COMMANDS(COMMAND_HANDLER)
+VISCA_INQUIRIES(INQUIRY_HANDLER, INQUIRY_DATA_HANDLER)
+
+/* the same arguments once more, this time recording how far into the payload they read */
+#undef BYTE
+#undef LOW
+#undef ONOFF
+#undef NIBBLES
+#undef WORDS
+#define EXTENT(I, N) reach(&extent, (I) + (N))
+#define BYTE(I) EXTENT(I, 1)
+#define LOW(I) EXTENT(I, 1)
+#define ONOFF(I) EXTENT(I, 1)
+#define NIBBLES(I, N) EXTENT(I, N)
+#define WORDS(I, N) EXTENT(I, N)
+#define ARGS(...) extent_of(0, ##__VA_ARGS__)
+
+static int reach(size_t *extent, size_t end)
+{
+    if (end > *extent)
+        *extent = end;
+
+    return 0;
+}
+
+static void extent_of(int first, ...)
+{
+    (void)first;
+}
+
+VISCA_COMMANDS(COMMAND_EXTENT)
+
+static const struct visca_rule command_rules[] = {
+    VISCA_COMMANDS(COMMAND_RULE)
+};
+
+static const struct visca_rule inquiry_rules[] = {
+    VISCA_INQUIRIES(INQUIRY_RULE, INQUIRY_DATA_RULE)
+};
+
+static struct visca_slot command_slots[RULE_COUNT(command_rules)];
+static struct visca_slot inquiry_slots[RULE_COUNT(inquiry_rules)];
+
+static struct visca_table commands = {
+    .what = "command",
+    .raw_class = B(0x01),
+    .sony_class = B(0x01),
+    .rules = command_rules,
+    .slots = command_slots,
+    .count = RULE_COUNT(command_rules),
+};
+
+static struct visca_table inquiries = {
+    .what = "inquiry",
+    .raw_class = B(0x09),
+    .rules = inquiry_rules,
+    .slots = inquiry_slots,
+    .count = RULE_COUNT(inquiry_rules),
+};
+
+static int rule_is_keyed(const struct visca_rule *rule)
+{
+    for (int i = 0; i < VISCA_KEY_LENGTH; ++i) {
+        if ((rule->pattern[i] >> 8u) != 0xff)
+            return 0;
+    }
+
+    return 1;
+}
+
+static int compare_slots(const void *a, const void *b)
+{
+    const struct visca_slot *x = a, *y = b;
+
+    if (x->key != y->key)
+        return x->key < y->key ? -1 : 1;
+
+    return (int)x->rule - (int)y->rule;
+}
+
+static int rules_collide(const struct visca_rule *a, const struct visca_rule *b)
+{
+    if ((a->dialects & b->dialects) == 0 || a->length != b->length)
+        return 0;
+
+    for (int i = 0; i < VISCA_PATTERN_LENGTH; ++i) {
+        if (a->pattern[i] != b->pattern[i])
+            return 0;
+    }
+
+    return 1;
+}
+
+/* a row whose class byte is not the one its dialect routes to the table never gets a payload */
+static int rule_is_routed(const struct visca_rule *rule, int dialect, uint16_t class)
+{
+    if ((rule->dialects & dialect) == 0 || class == 0 || (rule->pattern[0] >> 8u) != 0xff)
+        return 1;
+
+    return rule->pattern[0] == class;
+}
+
+static void table_build(struct visca_table *table)
+{
+    size_t loose = 0;
+
+    table->keyed = 0;
+
+    for (size_t i = 0; i < table->count; ++i) {
+        if (rule_is_keyed(&table->rules[i]))
+            ++table->keyed;
+    }
+
+    for (size_t i = 0, keyed = 0; i < table->count; ++i) {
+        const struct visca_rule *rule = &table->rules[i];
+        struct visca_slot *slot;
+        uint32_t key = 0;
+        size_t extent;
+
+        slot = rule_is_keyed(rule) ? &table->slots[keyed++] : &table->slots[table->keyed + loose++];
+
+        for (int j = 0; j < VISCA_KEY_LENGTH; ++j)
+            key = (key << 8u) | (rule->pattern[j] & 0xffu);
+
+        slot->key = key;
+        slot->rule = i;
+        slot->pattern_length = 0;
+
+        for (int j = 0; j < VISCA_PATTERN_LENGTH; ++j) {
+            if (rule->pattern[j] != 0)
+                slot->pattern_length = j + 1;
+        }
+
+        extent = slot->pattern_length + 1;
+
+        if (rule->extent != NULL && rule->extent() > extent)
+            extent = rule->extent();
+
+        slot->min_length = extent + 1;
+
+        if (rule->length != 0 && rule->length < slot->min_length)
+            die(ERR_VISCA_PROTOCOL, "visca_decode_init: %s %s is %d bytes, needs %d",
+                    table->what, rule->name, rule->length, slot->min_length);
+
+        if (!rule_is_routed(rule, VISCA_DIALECT_RAW, table->raw_class) ||
+                !rule_is_routed(rule, VISCA_DIALECT_SONY, table->sony_class))
+            die(ERR_VISCA_PROTOCOL, "visca_decode_init: %s %s can never match",
+                    table->what, rule->name);
+    }
+
+    qsort(table->slots, table->keyed, sizeof(*table->slots), compare_slots);
+
+    /* a row that can never match is a mistake in visca_spec.h */
+    for (size_t i = 0; i < table->count; ++i) {
+        for (size_t j = i + 1; j < table->count && (i >= table->keyed ||
+                    table->slots[j].key == table->slots[i].key); ++j) {
+            const struct visca_rule *a = &table->rules[table->slots[i].rule],
+                                    *b = &table->rules[table->slots[j].rule];
+
+            if (rules_collide(a, b))
+                die(ERR_VISCA_PROTOCOL, "visca_decode_init: %s %s shadows %s", table->what, a->name, b->name);
+        }
+    }
+
+    log("visca_decode_init: %zu %s rules, %zu keyed", table->count, table->what, table->keyed);
+}
+
+void visca_decode_init()
+{
+    table_build(&commands);
+    table_build(&inquiries);
+}
+
+static int slot_matches(const struct visca_table *table, const struct visca_slot *slot,
+        const uint8_t *payload, size_t length, int dialect)
+{
+    const struct visca_rule *rule = &table->rules[slot->rule];
+
+    if ((rule->dialects & dialect) == 0 || length < slot->min_length)
+        return 0;
+
+    if (rule->length != 0 && rule->length != length)
+        return 0;
+
+    for (int i = 0; i < slot->pattern_length; ++i) {
+        if (((payload[i + 1] ^ rule->pattern[i]) & (rule->pattern[i] >> 8u)) != 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+static const struct visca_rule* table_find(const struct visca_table *table, const uint8_t *payload,
+        size_t length, int dialect)
+{
+    size_t lo = 0, hi = table->keyed, mid;
+    uint32_t key;
+
+    if (length > VISCA_KEY_LENGTH) {
+        key = (uint32_t)payload[1] << 16u | (uint32_t)payload[2] << 8u | payload[3];
+
+        while (lo < hi) {
+            mid = lo + (hi - lo) / 2;
+
+            if (table->slots[mid].key < key)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        for (; lo < table->keyed && table->slots[lo].key == key; ++lo) {
+            if (slot_matches(table, &table->slots[lo], payload, length, dialect))
+                return &table->rules[table->slots[lo].rule];
+        }
+    }
+
+    for (size_t i = table->keyed; i < table->count; ++i) {
+        if (slot_matches(table, &table->slots[i], payload, length, dialect))
+            return &table->rules[table->slots[i].rule];
+    }
+
+    return NULL;
+}
+
+static void log_unknown(const char *what, const uint8_t *payload, size_t length)
+{
+    const buffer_t message = { length, (uint8_t*)payload };
+
+    log("visca_decode: unknown %s", what);
+    print_buffer(&message, 16);
+}
+
+void visca_decode_command(const uint8_t *payload, size_t length, int dialect)
+{
+    const struct visca_rule *rule = table_find(&commands, payload, length, dialect);
+
+    if (rule == NULL) {
+        log_unknown(commands.what, payload, length);
+        return;
+    }
+
+    rule->command(payload);
+}
+
+/* inquiry holds at least VISCA_MAX_INQUIRY_LENGTH bytes */
+buffer_t* visca_decode_inquiry(const uint8_t *payload, size_t length, int dialect, buffer_t *inquiry)
+{
+    const struct visca_rule *rule = table_find(&inquiries, payload, length, dialect);
+
+    if (rule == NULL) {
+        log_unknown(inquiries.what, payload, length);
+        return NULL;
+    }
+
+    return rule->inquiry(payload, inquiry);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "buffer.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* the framing a payload came in, see visca_spec.h */
+enum visca_dialect
+{
+    VISCA_DIALECT_RAW = 1 << 0,
+    VISCA_DIALECT_SONY = 1 << 1,
+    VISCA_DIALECT_ALL = VISCA_DIALECT_RAW | VISCA_DIALECT_SONY,
+};
+
+void visca_decode_init();
+void visca_decode_command(const uint8_t *payload, size_t length, int dialect);
+buffer_t* visca_decode_inquiry(const uint8_t *payload, size_t length, int dialect, buffer_t *inquiry);
@@ -0,0 +1,101 @@
+#include "visca_framing.h"
+#include "log.h"
+#include "sony_visca.h"
+#include "visca.h"
+#include <netinet/in.h>
+
+/* the framing a controller talks to one camera socket */
+struct framing_entry
+{
+    int fd;
+    in_addr_t address;
+    in_port_t port;
+    int framing;
+};
+
+static __thread struct framing_entry framing_cache[VISCA_FRAMING_CACHE_SIZE];
+
+/* sony over ip starts with an 8 byte header whose payload type is 0x01xx or 0x02xx and whose
+   length covers the rest of the datagram, raw visca starts with the 0x8X address byte and
+   ends with ff. the first byte alone tells them apart, the rest guards against noise */
+int visca_framing_detect(const buffer_t *message)
+{
+    const uint8_t *data = message->data;
+    size_t payload_length;
+
+    if (message->length > VOIP_HEADER_LENGTH && (data[0] == 0x01 || data[0] == 0x02)) {
+        payload_length = (size_t)data[2] << 8u | data[3];
+
+        if (payload_length == message->length - VOIP_HEADER_LENGTH)
+            return VISCA_FRAMING_SONY;
+    }
+
+    if (message->length >= VISCA_MIN_MESSAGE_LENGTH && (data[0] & 0xf0) == 0x80 && data[message->length - 1] == 0xff)
+        return VISCA_FRAMING_RAW;
+
+    return VISCA_FRAMING_UNKNOWN;
+}
+
+/* the least a handler reads before it looks at the message, a controller that sends less
+   is not trusted to keep its framing */
+static int framing_fits(const buffer_t *message, int framing)
+{
+    if (framing == VISCA_FRAMING_SONY)
+        return message->length > VOIP_HEADER_LENGTH;
+
+    return message->length >= VISCA_MIN_MESSAGE_LENGTH;
+}
+
+static struct framing_entry* framing_cache_slot(int fd, const struct sockaddr_in *addr)
+{
+    uint32_t hash = (uint32_t)fd * 0x9e3779b1u;
+
+    hash ^= addr->sin_addr.s_addr * 0x85ebca6bu;
+    hash ^= (uint32_t)addr->sin_port * 0xc2b2ae35u;
+    hash ^= hash >> 16u;
+
+    return &framing_cache[hash % VISCA_FRAMING_CACHE_SIZE];
+}
+
+/* the first datagram of a controller decides its framing, the ones after it go straight to
+   that protocol. a controller the cache lost or a datagram too short for the cached framing
+   is detected again */
+void visca_framing_handle_message(const buffer_t *message, const struct event_t *event)
+{
+    const struct sockaddr_in *addr = (const struct sockaddr_in*)event->addr;
+    struct framing_entry *entry = NULL;
+    int framing = VISCA_FRAMING_UNKNOWN;
+
+    if (addr != NULL && addr->sin_family == AF_INET) {
+        entry = framing_cache_slot(event->fd, addr);
+
+        if (entry->framing != VISCA_FRAMING_UNKNOWN && entry->fd == event->fd &&
+                entry->address == addr->sin_addr.s_addr && entry->port == addr->sin_port &&
+                framing_fits(message, entry->framing))
+            framing = entry->framing;
+    }
+
+    if (framing == VISCA_FRAMING_UNKNOWN) {
+        framing = visca_framing_detect(message);
+
+        if (framing == VISCA_FRAMING_UNKNOWN) {
+            log("visca_framing: datagram of %zu bytes is neither raw nor sony visca", message->length);
+            print_buffer(message, 16);
+            return;
+        }
+
+        log("visca_framing: controller talks %s visca", framing == VISCA_FRAMING_SONY ? "sony" : "raw");
+
+        if (entry != NULL) {
+            entry->fd = event->fd;
+            entry->address = addr->sin_addr.s_addr;
+            entry->port = addr->sin_port;
+            entry->framing = framing;
+        }
+    }
+
+    if (framing == VISCA_FRAMING_SONY)
+        sony_visca_handle_message(message, event);
+    else
+        visca_handle_message(message, event);
+}
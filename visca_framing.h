@@ -0,0 +1,17 @@
+#pragma once
+
+#include "buffer.h"
+#include "epoll.h"
+
+/* controllers remembered per shard, older ones are overwritten by newer ones */
+#define VISCA_FRAMING_CACHE_SIZE 256
+
+enum visca_framing
+{
+    VISCA_FRAMING_UNKNOWN = 0,
+    VISCA_FRAMING_RAW,
+    VISCA_FRAMING_SONY,
+};
+
+int visca_framing_detect(const buffer_t *message);
+void visca_framing_handle_message(const buffer_t *message, const struct event_t *event);
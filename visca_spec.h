@@ -0,0 +1,498 @@
+#pragma once
+
+/* the visca grammar both transports understand. the raw and the sony over ip framing carry
+   the same payload, 81 <class> <category> <command> ... ff, so one table decodes both.
+
+   a command row is CMD(name, dialects, length, call, args, pattern...):
+     dialects  the framing the row applies to, RAW, SONY or ALL. the controllers we bridge
+               disagree on a few commands, everything else is shared
+     length    exact payload length including 81 and ff, 0 takes any length
+     call      the bridge call
+     args      its arguments in parentheses, read off the payload with BYTE(i), LOW(i),
+               ONOFF(i), NIBBLES(i, n) and WORDS(i, n)
+     pattern   payload bytes from index 1 on, B(x) matches x, HI(x) matches the high
+               nibble of x. bytes not listed match anything
+
+   a payload has to reach past the last byte the pattern and the args look at, so a short
+   one is unknown rather than read beyond its end. rows that start with a class byte the
+   framing never hands to the table, 01 for commands and 09 for raw inquiries, are refused
+   at startup like rows that shadow each other
+
+   an inquiry row is INQ(name, dialects, reply, bridge, pattern...) where reply is the
+   length of the inquiry data, or INQ_DATA(name, dialects, bridge, pattern...) when the
+   bridge composes the data itself.
+
+   rows are tried in the order they are listed, the first one that matches wins */
+
+#define VISCA_COMMANDS(CMD) \
+    /* exposure */ \
+    CMD(exposure_mode_full_auto, ALL, 0, bridge_cmd_exposure_mode_full_auto, (), \
+        B(0x01), B(0x04), B(0x39), B(0x00)) \
+    CMD(exposure_mode_manual, ALL, 0, bridge_cmd_exposure_mode_manual, (), \
+        B(0x01), B(0x04), B(0x39), B(0x03)) \
+    CMD(exposure_mode_shutter_pri, ALL, 0, bridge_cmd_exposure_mode_shutter_pri, (), \
+        B(0x01), B(0x04), B(0x39), B(0x0a)) \
+    CMD(exposure_mode_iris_pri, ALL, 0, bridge_cmd_exposure_mode_iris_pri, (), \
+        B(0x01), B(0x04), B(0x39), B(0x0b)) \
+    CMD(exposure_mode_gain_pri, ALL, 0, bridge_cmd_exposure_mode_gain_pri, (), \
+        B(0x01), B(0x04), B(0x39), B(0x0e)) \
+    CMD(exposure_iris_reset, ALL, 0, bridge_cmd_exposure_iris_reset, (), \
+        B(0x01), B(0x04), B(0x0b), B(0x00)) \
+    CMD(exposure_iris_up, ALL, 0, bridge_cmd_exposure_iris_up, (), \
+        B(0x01), B(0x04), B(0x0b), B(0x02)) \
+    CMD(exposure_iris_down, ALL, 0, bridge_cmd_exposure_iris_down, (), \
+        B(0x01), B(0x04), B(0x0b), B(0x03)) \
+    CMD(exposure_iris_direct, ALL, 0, bridge_cmd_exposure_iris_direct, (NIBBLES(6, 2)), \
+        B(0x01), B(0x04), B(0x4b)) \
+    CMD(exposure_gain_reset, ALL, 0, bridge_cmd_exposure_gain_reset, (), \
+        B(0x01), B(0x04), B(0x0c), B(0x00)) \
+    CMD(exposure_gain_up, ALL, 0, bridge_cmd_exposure_gain_up, (), \
+        B(0x01), B(0x04), B(0x0c), B(0x02)) \
+    CMD(exposure_gain_down, ALL, 0, bridge_cmd_exposure_gain_down, (), \
+        B(0x01), B(0x04), B(0x0c), B(0x03)) \
+    CMD(exposure_gain_direct, ALL, 0, \
+        bridge_cmd_exposure_gain_direct, (gain_parameter_to_db(NIBBLES(6, 2))), \
+        B(0x01), B(0x04), B(0x4c)) \
+    CMD(exposure_gain_limit, ALL, 0, \
+        bridge_cmd_exposure_gain_limit, (gain_parameter_to_db(BYTE(4))), \
+        B(0x01), B(0x04), B(0x2c)) \
+    CMD(exposure_shutter_reset, ALL, 0, bridge_cmd_exposure_shutter_reset, (), \
+        B(0x01), B(0x04), B(0x0a), B(0x00)) \
+    CMD(exposure_shutter_fast, ALL, 0, bridge_cmd_exposure_shutter_fast, (), \
+        B(0x01), B(0x04), B(0x0a), B(0x02)) \
+    CMD(exposure_shutter_slow, ALL, 0, bridge_cmd_exposure_shutter_slow, (), \
+        B(0x01), B(0x04), B(0x0a), B(0x03)) \
+    CMD(exposure_shutter_direct, ALL, 0, bridge_cmd_exposure_shutter_direct, (NIBBLES(6, 2)), \
+        B(0x01), B(0x04), B(0x4a)) \
+    CMD(exposure_ae_speed, ALL, 0, bridge_cmd_exposure_ae_speed, (BYTE(4)), \
+        B(0x01), B(0x04), B(0x5d)) \
+    CMD(exposure_exp_comp_set, ALL, 0, bridge_cmd_exposure_exp_comp_set, (ONOFF(4)), \
+        B(0x01), B(0x04), B(0x3e)) \
+    CMD(exposure_exp_comp_reset, ALL, 0, bridge_cmd_exposure_exp_comp_reset, (), \
+        B(0x01), B(0x04), B(0x0e), B(0x00)) \
+    CMD(exposure_exp_comp_up, ALL, 0, bridge_cmd_exposure_exp_comp_up, (), \
+        B(0x01), B(0x04), B(0x0e), B(0x02)) \
+    CMD(exposure_exp_comp_down, ALL, 0, bridge_cmd_exposure_exp_comp_down, (), \
+        B(0x01), B(0x04), B(0x0e), B(0x03)) \
+    CMD(exposure_exp_comp_direct, ALL, 0, bridge_cmd_exposure_exp_comp_direct, (NIBBLES(6, 2)), \
+        B(0x01), B(0x04), B(0x4e)) \
+    CMD(exposure_back_light_on, ALL, 0, bridge_cmd_exposure_back_light_set, (1), \
+        B(0x01), B(0x04), B(0x33), B(0x02)) \
+    CMD(exposure_back_light_off, ALL, 0, bridge_cmd_exposure_back_light_set, (0), \
+        B(0x01), B(0x04), B(0x33), B(0x03)) \
+    CMD(exposure_spot_light_set, ALL, 0, bridge_cmd_exposure_spot_light_set, (ONOFF(4)), \
+        B(0x01), B(0x04), B(0x3a)) \
+    CMD(exposure_vis_enh_set, ALL, 0, bridge_cmd_exposure_vis_enh_set, (BYTE(4) == 0x06), \
+        B(0x01), B(0x04), B(0x3d)) \
+    CMD(exposure_vis_enh_direct, ALL, 0, \
+        bridge_cmd_exposure_vis_enh_direct, (BYTE(5), BYTE(6), BYTE(7)), \
+        B(0x01), B(0x04), B(0x2d)) \
+    CMD(exposure_ir_cut_filter_set, ALL, 0, bridge_cmd_exposure_ir_cut_filter_set, (ONOFF(4)), \
+        B(0x01), B(0x04), B(0x01)) \
+    CMD(exposure_nd_filter, ALL, 0, bridge_cmd_exposure_nd_filter, (BYTE(5)), \
+        B(0x01), B(0x7e), B(0x01), B(0x53)) \
+    CMD(exposure_gain_point_set, ALL, 0, bridge_cmd_exposure_gain_point_set, (ONOFF(4)), \
+        B(0x01), B(0x05), B(0x0c)) \
+    CMD(exposure_gain_point_position, ALL, 0, \
+        bridge_cmd_exposure_gain_point_position, (gain_parameter_to_db(NIBBLES(4, 2))), \
+        B(0x01), B(0x05), B(0x4c)) \
+    CMD(exposure_minmax_shutter_set, ALL, 0, \
+        bridge_cmd_exposure_minmax_shutter_set, (BYTE(4), NIBBLES(5, 2)), \
+        B(0x01), B(0x05), B(0x2a)) \
+    CMD(exposure_low_light_basis_brightness_set, ALL, 0, \
+        bridge_cmd_exposure_low_light_basis_brightness_set, (ONOFF(4)), \
+        B(0x01), B(0x05), B(0x39)) \
+    CMD(exposure_low_light_basis_brightness_direct, ALL, 0, \
+        bridge_cmd_exposure_low_light_basis_brightness_direct, (BYTE(4)), \
+        B(0x01), B(0x05), B(0x49)) \
+    /* color */ \
+    CMD(color_white_balance_auto1, ALL, 0, bridge_cmd_color_white_balance_auto1, (), \
+        B(0x01), B(0x04), B(0x35), B(0x00)) \
+    CMD(color_white_balance_indoor, ALL, 0, bridge_cmd_color_white_balance_indoor, (), \
+        B(0x01), B(0x04), B(0x35), B(0x01)) \
+    CMD(color_white_balance_outdoor, ALL, 0, bridge_cmd_color_white_balance_outdoor, (), \
+        B(0x01), B(0x04), B(0x35), B(0x02)) \
+    CMD(color_white_balance_one_push_wb, ALL, 0, bridge_cmd_color_white_balance_one_push_wb, (), \
+        B(0x01), B(0x04), B(0x35), B(0x03)) \
+    CMD(color_white_balance_auto2, ALL, 0, bridge_cmd_color_white_balance_auto2, (), \
+        B(0x01), B(0x04), B(0x35), B(0x04)) \
+    CMD(color_white_balance_manual, ALL, 0, bridge_cmd_color_white_balance_manual, (), \
+        B(0x01), B(0x04), B(0x35), B(0x05)) \
+    CMD(color_one_push_trigger, ALL, 0, bridge_cmd_color_one_push_trigger, (), \
+        B(0x01), B(0x04), B(0x10)) \
+    CMD(color_rgain_reset, ALL, 0, bridge_cmd_color_rgain_reset, (), \
+        B(0x01), B(0x04), B(0x03), B(0x00)) \
+    CMD(color_rgain_up, ALL, 0, bridge_cmd_color_rgain_up, (), \
+        B(0x01), B(0x04), B(0x03), B(0x02)) \
+    CMD(color_rgain_down, ALL, 0, bridge_cmd_color_rgain_down, (), \
+        B(0x01), B(0x04), B(0x03), B(0x03)) \
+    CMD(color_rgain_direct, ALL, 0, bridge_cmd_color_rgain_direct, ((int)NIBBLES(6, 2) - 128), \
+        B(0x01), B(0x04), B(0x43)) \
+    CMD(color_bgain_reset, ALL, 0, bridge_cmd_color_bgain_reset, (), \
+        B(0x01), B(0x04), B(0x04), B(0x00)) \
+    CMD(color_bgain_up, ALL, 0, bridge_cmd_color_bgain_up, (), \
+        B(0x01), B(0x04), B(0x04), B(0x02)) \
+    CMD(color_bgain_down, ALL, 0, bridge_cmd_color_bgain_down, (), \
+        B(0x01), B(0x04), B(0x04), B(0x03)) \
+    CMD(color_bgain_direct, ALL, 0, bridge_cmd_color_bgain_direct, ((int)NIBBLES(6, 2) - 128), \
+        B(0x01), B(0x04), B(0x44)) \
+    CMD(color_speed, ALL, 0, bridge_cmd_color_speed, (BYTE(4)), \
+        B(0x01), B(0x04), B(0x56)) \
+    CMD(color_chroma_suppress, ALL, 0, bridge_cmd_color_chroma_suppress, (BYTE(4)), \
+        B(0x01), B(0x04), B(0x5f)) \
+    CMD(color_level_reset, ALL, 0, bridge_cmd_color_level_reset, (), \
+        B(0x01), B(0x04), B(0x09), B(0x00)) \
+    CMD(color_level_up, ALL, 0, bridge_cmd_color_level_up, (), \
+        B(0x01), B(0x04), B(0x09), B(0x02)) \
+    CMD(color_level_down, ALL, 0, bridge_cmd_color_level_down, (), \
+        B(0x01), B(0x04), B(0x09), B(0x03)) \
+    CMD(color_level_direct, ALL, 0, bridge_cmd_color_level_direct, (BYTE(7)), \
+        B(0x01), B(0x04), B(0x49)) \
+    CMD(color_phase_reset, ALL, 0, bridge_cmd_color_phase_reset, (), \
+        B(0x01), B(0x04), B(0x0f), B(0x00)) \
+    CMD(color_phase_up, ALL, 0, bridge_cmd_color_phase_up, (), \
+        B(0x01), B(0x04), B(0x0f), B(0x02)) \
+    CMD(color_phase_down, ALL, 0, bridge_cmd_color_phase_down, (), \
+        B(0x01), B(0x04), B(0x0f), B(0x03)) \
+    CMD(color_phase_direct, ALL, 0, bridge_cmd_color_phase_direct, (BYTE(7)), \
+        B(0x01), B(0x04), B(0x4f)) \
+    CMD(color_offset_reset, ALL, 0, bridge_cmd_color_offset_reset, (), \
+        B(0x01), B(0x7e), B(0x01), B(0x2e), 0, B(0x00), B(0x00)) \
+    CMD(color_offset_up, ALL, 0, bridge_cmd_color_offset_up, (), \
+        B(0x01), B(0x7e), B(0x01), B(0x2e), 0, B(0x00), B(0x02)) \
+    CMD(color_offset_down, ALL, 0, bridge_cmd_color_offset_down, (), \
+        B(0x01), B(0x7e), B(0x01), B(0x2e), 0, B(0x00), B(0x03)) \
+    CMD(color_offset_direct, ALL, 0, bridge_cmd_color_offset_direct, ((int)BYTE(7) - 7), \
+        B(0x01), B(0x7e), B(0x01), B(0x2e), 0, B(0x01)) \
+    CMD(color_matrix_select, ALL, 0, bridge_cmd_color_matrix_select, (BYTE(5)), \
+        B(0x01), B(0x7e), B(0x01), B(0x3d)) \
+    CMD(color_rg, ALL, 0, bridge_cmd_color_rg, ((int)NIBBLES(5, 2) - 99), \
+        B(0x01), B(0x7e), B(0x01), B(0x7a)) \
+    CMD(color_rb, ALL, 0, bridge_cmd_color_rb, ((int)NIBBLES(5, 2) - 99), \
+        B(0x01), B(0x7e), B(0x01), B(0x7b)) \
+    CMD(color_gr, ALL, 0, bridge_cmd_color_gr, ((int)NIBBLES(5, 2) - 99), \
+        B(0x01), B(0x7e), B(0x01), B(0x7c)) \
+    CMD(color_gb, ALL, 0, bridge_cmd_color_gb, ((int)NIBBLES(5, 2) - 99), \
+        B(0x01), B(0x7e), B(0x01), B(0x7d)) \
+    CMD(color_br, ALL, 0, bridge_cmd_color_br, ((int)NIBBLES(5, 2) - 99), \
+        B(0x01), B(0x7e), B(0x01), B(0x7e)) \
+    CMD(color_bg, ALL, 0, bridge_cmd_color_bg, ((int)NIBBLES(5, 2) - 99), \
+        B(0x01), B(0x7e), B(0x01), B(0x7f)) \
+    /* detail, knee, gamma and noise reduction */ \
+    CMD(detail_level_reset, ALL, 0, bridge_cmd_detail_level_reset, (), \
+        B(0x01), B(0x04), B(0x02), B(0x00)) \
+    CMD(detail_level_up, ALL, 0, bridge_cmd_detail_level_up, (), \
+        B(0x01), B(0x04), B(0x02), B(0x02)) \
+    CMD(detail_level_down, ALL, 0, bridge_cmd_detail_level_down, (), \
+        B(0x01), B(0x04), B(0x02), B(0x03)) \
+    CMD(detail_level_direct, ALL, 0, bridge_cmd_detail_level_direct, (NIBBLES(6, 2)), \
+        B(0x01), B(0x04), B(0x42)) \
+    CMD(detail_mode, ALL, 0, bridge_cmd_detail_mode, (), \
+        B(0x01), B(0x05), B(0x42), B(0x01)) \
+    CMD(detail_bandwidth, ALL, 0, bridge_cmd_detail_bandwidth, (), \
+        B(0x01), B(0x05), B(0x42), B(0x02)) \
+    CMD(detail_crispening, ALL, 0, bridge_cmd_detail_crispening, (), \
+        B(0x01), B(0x05), B(0x42), B(0x03)) \
+    CMD(detail_hv_balance, ALL, 0, bridge_cmd_detail_hv_balance, (), \
+        B(0x01), B(0x05), B(0x42), B(0x04)) \
+    CMD(detail_bw_balance, ALL, 0, bridge_cmd_detail_bw_balance, (), \
+        B(0x01), B(0x05), B(0x42), B(0x05)) \
+    CMD(detail_limit, ALL, 0, bridge_cmd_detail_limit, (), \
+        B(0x01), B(0x05), B(0x42), B(0x06)) \
+    CMD(detail_highlight_detail, ALL, 0, bridge_cmd_detail_highlight_detail, (), \
+        B(0x01), B(0x05), B(0x42), B(0x07)) \
+    CMD(detail_superlow, ALL, 0, bridge_cmd_detail_superlow, (), \
+        B(0x01), B(0x05), B(0x42), B(0x08)) \
+    CMD(knee_set, ALL, 0, bridge_cmd_knee_set, (ONOFF(5)), \
+        B(0x01), B(0x7e), B(0x01), B(0x6d)) \
+    CMD(knee_mode, ALL, 0, bridge_cmd_knee_mode, (BYTE(5) == 0x04), \
+        B(0x01), B(0x7e), B(0x01), B(0x54)) \
+    CMD(knee_slope, ALL, 0, bridge_cmd_knee_slope, (NIBBLES(5, 2)), \
+        B(0x01), B(0x7e), B(0x01), B(0x6f)) \
+    CMD(knee_point, ALL, 0, bridge_cmd_knee_point, (NIBBLES(5, 2)), \
+        B(0x01), B(0x7e), B(0x01), B(0x6e)) \
+    CMD(gamma_mode, ALL, 0, bridge_cmd_gamma_mode, (BYTE(4)), \
+        B(0x01), B(0x04), B(0x5b)) \
+    CMD(gamma_offset, ALL, 0, bridge_cmd_gamma_offset, (BYTE(7), NIBBLES(8, 2)), \
+        B(0x01), B(0x04), B(0x1e)) \
+    CMD(gamma_pattern, ALL, 0, bridge_cmd_gamma_pattern, (NIBBLES(4, 3)), \
+        B(0x01), B(0x05), B(0x5b)) \
+    CMD(gamma_black_gamma_range, ALL, 0, bridge_cmd_gamma_black_gamma_range, (BYTE(4)), \
+        B(0x01), B(0x05), B(0x5c)) \
+    CMD(gamma_level, ALL, 0, bridge_cmd_gamma_level, (NIBBLES(5, 2)), \
+        B(0x01), B(0x7e), B(0x01), B(0x71)) \
+    CMD(gamma_black_gamma_level, ALL, 0, bridge_cmd_gamma_black_gamma_level, (NIBBLES(5, 2)), \
+        B(0x01), B(0x7e), B(0x01), B(0x72)) \
+    CMD(gamma_black_level_reset, ALL, 0, bridge_cmd_gamma_black_level_reset, (), \
+        B(0x01), B(0x7e), B(0x04), B(0x15), B(0x00)) \
+    CMD(gamma_black_level_up, ALL, 0, bridge_cmd_gamma_black_level_up, (), \
+        B(0x01), B(0x7e), B(0x04), B(0x15), B(0x02)) \
+    CMD(gamma_black_level_down, ALL, 0, bridge_cmd_gamma_black_level_down, (), \
+        B(0x01), B(0x7e), B(0x04), B(0x15), B(0x03)) \
+    CMD(gamma_black_level_direct, ALL, 0, \
+        bridge_cmd_gamma_black_level_direct, ((int)NIBBLES(5, 2) - 48), \
+        B(0x01), B(0x7e), B(0x04), B(0x45)) \
+    CMD(flicker_reduction_mode_set, ALL, 0, bridge_cmd_flicker_reduction_mode_set, (ONOFF(4)), \
+        B(0x01), B(0x04), B(0x32)) \
+    CMD(flicker_reduction_mode_select, ALL, 0, bridge_cmd_flicker_reduction_mode_set, (BYTE(4)), \
+        B(0x01), B(0x04), B(0x23)) \
+    CMD(noise_reduction_mode_level_set, ALL, 0, \
+        bridge_cmd_noise_reduction_mode_level_set, (BYTE(4)), \
+        B(0x01), B(0x04), B(0x53)) \
+    CMD(noise_reduction_2d_3d_manual_setting, ALL, 0, \
+        bridge_cmd_noise_reduction_2d_3d_manual_setting, (BYTE(4), BYTE(5)), \
+        B(0x01), B(0x05), B(0x53)) \
+    CMD(picture_profile_mode, ALL, 0, bridge_cmd_picture_profile_mode, (BYTE(5) + 1), \
+        B(0x01), B(0x7e), B(0x04), B(0x5f)) \
+    /* zoom */ \
+    CMD(zoom_stop, ALL, 0, bridge_cmd_zoom_stop, (), \
+        B(0x01), B(0x04), B(0x07), B(0x00)) \
+    CMD(zoom_tele, ALL, 0, bridge_cmd_zoom_tele, (), \
+        B(0x01), B(0x04), B(0x07), B(0x02)) \
+    CMD(zoom_wide, ALL, 0, bridge_cmd_zoom_wide, (), \
+        B(0x01), B(0x04), B(0x07), B(0x03)) \
+    CMD(zoom_tele_var, ALL, 0, bridge_cmd_zoom_tele_var, (LOW(4)), \
+        B(0x01), B(0x04), B(0x07), HI(0x20)) \
+    CMD(zoom_wide_var, ALL, 0, bridge_cmd_zoom_wide_var, (LOW(4)), \
+        B(0x01), B(0x04), B(0x07), HI(0x30)) \
+    CMD(zoom_direct, ALL, 0, bridge_cmd_zoom_direct, (NIBBLES(4, 4)), \
+        B(0x01), B(0x04), B(0x47)) \
+    CMD(zoom_clear_image_set, ALL, 0, bridge_cmd_zoom_clear_image_set, (BYTE(4) == 0x04), \
+        B(0x01), B(0x04), B(0x06)) \
+    CMD(zoom_teleconvert_mode, ALL, 0, bridge_cmd_zoom_teleconvert_mode, (ONOFF(5)), \
+        B(0x01), B(0x7e), B(0x04), B(0x36)) \
+    /* focus */ \
+    CMD(focus_mode_auto, ALL, 0, bridge_cmd_focus_mode_auto, (), \
+        B(0x01), B(0x04), B(0x38), B(0x02)) \
+    CMD(focus_mode_manual, ALL, 0, bridge_cmd_focus_mode_manual, (), \
+        B(0x01), B(0x04), B(0x38), B(0x03)) \
+    CMD(focus_mode_toggle, ALL, 0, bridge_cmd_focus_mode_toggle, (), \
+        B(0x01), B(0x04), B(0x38), B(0x10)) \
+    CMD(focus_stop, ALL, 0, bridge_cmd_focus_stop, (), \
+        B(0x01), B(0x04), B(0x08), B(0x00)) \
+    CMD(focus_far, ALL, 0, bridge_cmd_focus_far, (), \
+        B(0x01), B(0x04), B(0x08), B(0x02)) \
+    CMD(focus_near, ALL, 0, bridge_cmd_focus_near, (), \
+        B(0x01), B(0x04), B(0x08), B(0x03)) \
+    CMD(focus_far_var, ALL, 0, bridge_cmd_focus_far_var, (LOW(4)), \
+        B(0x01), B(0x04), B(0x08), HI(0x20)) \
+    CMD(focus_near_var, ALL, 0, bridge_cmd_focus_near_var, (LOW(4)), \
+        B(0x01), B(0x04), B(0x08), HI(0x30)) \
+    CMD(focus_direct, ALL, 0, bridge_cmd_focus_direct, (NIBBLES(4, 4)), \
+        B(0x01), B(0x04), B(0x48)) \
+    CMD(focus_one_push_trigger, ALL, 0, bridge_cmd_focus_one_push_trigger, (), \
+        B(0x01), B(0x04), B(0x18), B(0x01)) \
+    CMD(focus_focus_inf, ALL, 0, bridge_cmd_focus_focus_inf, (), \
+        B(0x01), B(0x04), B(0x18), B(0x02)) \
+    CMD(focus_near_limit, ALL, 0, bridge_cmd_focus_near_limit, (NIBBLES(4, 4)), \
+        B(0x01), B(0x04), B(0x28)) \
+    CMD(focus_af_sensitivity, ALL, 0, bridge_cmd_focus_af_sensitivity, (ONOFF(4)), \
+        B(0x01), B(0x04), B(0x58)) \
+    CMD(focus_ir_correction, ALL, 0, bridge_cmd_focus_ir_correction, (BYTE(4)), \
+        B(0x01), B(0x04), B(0x11)) \
+    /* presets and memories */ \
+    CMD(memory_reset, RAW, 0, bridge_cmd_memory_reset, (BYTE(5)), \
+        B(0x01), B(0x04), B(0x3f), B(0x00)) \
+    CMD(memory_set, RAW, 0, bridge_cmd_memory_set, (BYTE(5)), \
+        B(0x01), B(0x04), B(0x3f), B(0x01)) \
+    CMD(memory_recall, RAW, 0, bridge_cmd_memory_recall, (BYTE(5)), \
+        B(0x01), B(0x04), B(0x3f), B(0x02)) \
+    CMD(preset_reset, SONY, 0, bridge_cmd_preset_reset, (), \
+        B(0x01), B(0x04), B(0x3f), B(0x00)) \
+    CMD(preset_set, SONY, 0, bridge_cmd_preset_set, (), \
+        B(0x01), B(0x04), B(0x3f), B(0x01)) \
+    CMD(preset_recall, SONY, 0, bridge_cmd_preset_recall, (), \
+        B(0x01), B(0x04), B(0x3f), B(0x02)) \
+    CMD(preset_drive_speed, ALL, 0, bridge_cmd_preset_drive_speed, (BYTE(5), BYTE(6)), \
+        B(0x01), B(0x7e), B(0x01), B(0x0b)) \
+    CMD(preset_mode, ALL, 0, bridge_cmd_preset_mode, (BYTE(5)), \
+        B(0x01), B(0x7e), B(0x04), B(0x3d)) \
+    /* pan tilt */ \
+    CMD(pan_tilt_directionals, ALL, 9, pan_tilt_directionals, (payload), \
+        B(0x01), B(0x06), B(0x01)) \
+    CMD(pan_tilt_absolute_preset, RAW, 0, \
+        bridge_cmd_pan_tilt_absolute_preset, (BYTE(4), BYTE(5), WORDS(6, 8)), \
+        B(0x01), B(0x06), B(0x02)) \
+    CMD(pan_tilt_relative_preset, RAW, 0, \
+        bridge_cmd_pan_tilt_absolute_preset, (BYTE(4), BYTE(5), WORDS(6, 8)), \
+        B(0x01), B(0x06), B(0x03)) \
+    CMD(pan_tilt_absolute_move, SONY, 16, pan_tilt_move, (payload, 0), \
+        B(0x01), B(0x06), B(0x02)) \
+    CMD(pan_tilt_relative_move, SONY, 16, pan_tilt_move, (payload, 1), \
+        B(0x01), B(0x06), B(0x03)) \
+    CMD(pan_tilt_home, ALL, 0, bridge_cmd_pan_tilt_home, (), \
+        B(0x01), B(0x06), B(0x04)) \
+    CMD(pan_tilt_reset, ALL, 0, bridge_cmd_pan_tilt_reset, (), \
+        B(0x01), B(0x06), B(0x05)) \
+    CMD(pan_tilt_limit, ALL, 16, pan_tilt_limit, (payload), \
+        B(0x01), B(0x06), B(0x07)) \
+    CMD(pan_tilt_ramp_curve, ALL, 6, pan_tilt_ramp_curve, (payload), \
+        B(0x01), B(0x06), B(0x31)) \
+    CMD(pan_tilt_slow_mode, ALL, 6, pan_tilt_slow_mode, (payload), \
+        B(0x01), B(0x06), B(0x44)) \
+    CMD(ptz_trace_rec, ALL, 0, bridge_cmd_ptz_trace_rec, (ONOFF(7), LOW(6)), \
+        B(0x01), B(0x7e), B(0x04), B(0x20), B(0x00)) \
+    CMD(ptz_trace_play, ALL, 0, bridge_cmd_ptz_trace_play, (BYTE(7) - 1, LOW(6)), \
+        B(0x01), B(0x7e), B(0x04), B(0x20), B(0x01)) \
+    CMD(ptz_trace_delete, ALL, 0, bridge_cmd_ptz_trace_delete, (LOW(6)), \
+        B(0x01), B(0x7e), B(0x04), B(0x20), B(0x02)) \
+    /* system */ \
+    CMD(menu_display_off, ALL, 0, bridge_cmd_menu_display_off, (), \
+        B(0x01), B(0x06), B(0x06)) \
+    CMD(system_img_flip_on, ALL, 0, bridge_cmd_system_img_flip, (1), \
+        B(0x01), B(0x04), B(0x66), B(0x02)) \
+    CMD(system_img_flip_off, ALL, 0, bridge_cmd_system_img_flip, (0), \
+        B(0x01), B(0x04), B(0x66), B(0x03)) \
+    CMD(system_hphase_set, ALL, 0, bridge_cmd_system_hphase_set, (ONOFF(6)), \
+        B(0x01), B(0x7e), B(0x01), B(0x3e)) \
+    CMD(system_hphase_direct, ALL, 0, bridge_cmd_system_hphase_direct, (NIBBLES(6, 3)), \
+        B(0x01), B(0x7e), B(0x01), B(0x5b)) \
+    CMD(system_pan_reverse, ALL, 0, bridge_cmd_system_pan_reverse, (BYTE(6)), \
+        B(0x01), B(0x7e), B(0x01), B(0x06)) \
+    CMD(system_tilt_reverse, ALL, 0, bridge_cmd_system_tilt_reverse, (BYTE(6)), \
+        B(0x01), B(0x7e), B(0x01), B(0x09)) \
+    CMD(tarry_set, ALL, 0, bridge_cmd_tarry_set, (ONOFF(7)), \
+        B(0x01), B(0x7e), B(0x01), B(0x0a), 0, B(0x00)) \
+    CMD(tarry_tally_mode_off, ALL, 0, bridge_cmd_tarry_tally_mode, (0), \
+        B(0x01), B(0x7e), B(0x01), B(0x0a), 0, B(0x01), B(0x00)) \
+    CMD(tarry_tally_mode_on, ALL, 0, bridge_cmd_tarry_tally_mode, (1), \
+        B(0x01), B(0x7e), B(0x01), B(0x0a), 0, B(0x01), B(0x04)) \
+    CMD(tarry_tally_mode_auto, ALL, 0, bridge_cmd_tarry_tally_mode, (2), \
+        B(0x01), B(0x7e), B(0x01), B(0x0a), 0, B(0x01), B(0x05)) \
+    CMD(hdmi_video_format_change, ALL, 0, hdmi_video_format_change, (NIBBLES(5, 2)), \
+        B(0x01), B(0x7e), B(0x01), B(0x1e)) \
+    CMD(hdmi_color_space, ALL, 0, bridge_cmd_hdmi_color_space, (BYTE(6)), \
+        B(0x01), B(0x7e), B(0x01), B(0x03))
+
+#define VISCA_INQUIRIES(INQ, INQ_DATA) \
+    /* the two controllers name these after their own manuals */ \
+    INQ(focus_af_mode, RAW, 1, bridge_inq_focus_af_mode, B(0x09), B(0x04), B(0x38)) \
+    INQ(wb_mode, RAW, 1, bridge_inq_wb_mode, B(0x09), B(0x04), B(0x35)) \
+    INQ(r_gain, RAW, 4, bridge_inq_r_gain, B(0x09), B(0x04), B(0x43)) \
+    INQ(ae_mode, RAW, 1, bridge_inq_ae_mode, B(0x09), B(0x04), B(0x39)) \
+    INQ(shutter_pos, RAW, 4, bridge_inq_shutter_pos, B(0x09), B(0x04), B(0x4a)) \
+    INQ(iris_pos, RAW, 4, bridge_inq_iris_pos, B(0x09), B(0x04), B(0x4b)) \
+    INQ(exp_comp_mode, RAW, 1, bridge_inq_exp_comp_mode, B(0x09), B(0x04), B(0x3e)) \
+    INQ(exp_comp_pos, RAW, 4, bridge_inq_exp_comp_pos, B(0x09), B(0x04), B(0x4e)) \
+    INQ(backlight_mode, RAW, 1, bridge_inq_backlight_mode, B(0x09), B(0x04), B(0x33)) \
+    INQ(noise2_d_l, RAW, 1, bridge_inq_noise2_d_l, B(0x09), B(0x04), B(0x53)) \
+    INQ(aperture, RAW, 4, bridge_inq_aperture, B(0x09), B(0x04), B(0x42)) \
+    INQ(picture_flip, RAW, 1, bridge_inq_picture_flip, B(0x09), B(0x04), B(0x66)) \
+    INQ(color_gain, RAW, 4, bridge_inq_color_gain, B(0x09), B(0x04), B(0x49)) \
+    INQ(gain_limit, RAW, 1, bridge_inq_gain_limit, B(0x09), B(0x04), B(0x2c)) \
+    INQ(color_hue, RAW, 4, bridge_inq_color_hue, B(0x09), B(0x04), B(0x4f)) \
+    INQ(focus_mode, SONY, 1, bridge_inq_focus_mode, B(0x09), B(0x04), B(0x38)) \
+    INQ(color_white_balance_mode, SONY, 1, bridge_inq_color_white_balance_mode, \
+        B(0x09), B(0x04), B(0x35)) \
+    INQ(color_r_gain, SONY, 4, bridge_inq_color_r_gain, B(0x09), B(0x04), B(0x43)) \
+    INQ(exposure_mode, SONY, 1, bridge_inq_exposure_mode, B(0x09), B(0x04), B(0x39)) \
+    INQ(exposure_shutter, SONY, 4, bridge_inq_exposure_shutter, B(0x09), B(0x04), B(0x4a)) \
+    INQ(exposure_iris, SONY, 4, bridge_inq_exposure_iris, B(0x09), B(0x04), B(0x4b)) \
+    INQ(exposure_ex_comp_on, SONY, 1, bridge_inq_exposure_ex_comp_on, B(0x09), B(0x04), B(0x3e)) \
+    INQ(exposure_ex_comp_level, SONY, 4, bridge_inq_exposure_ex_comp_level, \
+        B(0x09), B(0x04), B(0x4e)) \
+    INQ(exposure_back_light, SONY, 1, bridge_inq_exposure_back_light, B(0x09), B(0x04), B(0x33)) \
+    INQ(noise_reduction_mode_level, SONY, 1, bridge_inq_noise_reduction_mode_level, \
+        B(0x09), B(0x04), B(0x53)) \
+    INQ(detail_level, SONY, 1, bridge_inq_detail_level, B(0x09), B(0x04), B(0x42)) \
+    INQ(system_img_flip, SONY, 1, bridge_inq_system_img_flip, B(0x09), B(0x04), B(0x66)) \
+    INQ(color_level, SONY, 4, bridge_inq_color_level, B(0x09), B(0x04), B(0x49)) \
+    INQ(exposure_gain_limit, SONY, 1, bridge_inq_exposure_gain_limit, B(0x09), B(0x04), B(0x2c)) \
+    INQ(color_phase, SONY, 4, bridge_inq_color_phase, B(0x09), B(0x04), B(0x4f)) \
+    /* camera */ \
+    INQ(power_on, ALL, 1, bridge_inq_power_on, B(0x09), B(0x04), B(0x00)) \
+    INQ(software_version, ALL, 7, bridge_inq_software_version, B(0x09), B(0x00), B(0x02)) \
+    INQ(bright_pos, ALL, 4, bridge_inq_bright_pos, B(0x09), B(0x04), B(0x4d)) \
+    INQ(exposure_gain, ALL, 4, bridge_inq_exposure_gain, B(0x09), B(0x04), B(0x4c)) \
+    INQ(exposure_ae_speed, ALL, 1, bridge_inq_exposure_ae_speed, B(0x09), B(0x04), B(0x5d)) \
+    INQ(exposure_spot_light, ALL, 1, bridge_inq_exposure_spot_light, B(0x09), B(0x04), B(0x3a)) \
+    INQ(exposure_vis_enh_on, ALL, 1, bridge_inq_exposure_vis_enh_on, B(0x09), B(0x04), B(0x3d)) \
+    INQ(exposure_vis_enh, ALL, 8, bridge_inq_exposure_vis_enh, B(0x09), B(0x04), B(0x2d)) \
+    INQ(exposure_nd_filter, SONY, 1, bridge_inq_exposure_nd_filter, B(0x01), B(0x7e), B(0x01)) \
+    INQ(exposure_gain_point_position, ALL, 1, bridge_inq_exposure_gain_point_position, \
+        B(0x09), B(0x05), B(0x4c)) \
+    INQ(exposure_max_shutter, ALL, 1, bridge_inq_exposure_max_shutter, \
+        B(0x09), B(0x05), B(0x2a), B(0x00)) \
+    INQ(exposure_min_shutter, ALL, 1, bridge_inq_exposure_min_shutter, B(0x09), B(0x05), B(0x2a)) \
+    INQ(exposure_low_light_basis_brightness_on, ALL, 1, \
+        bridge_inq_exposure_low_light_basis_brightness_on, B(0x09), B(0x05), B(0x39)) \
+    INQ(exposure_low_light_basis_brightness, ALL, 1, bridge_inq_exposure_low_light_basis_brightness, \
+        B(0x09), B(0x05), B(0x49)) \
+    INQ(ir_cut_filter, ALL, 1, bridge_inq_ir_cut_filter, B(0x09), B(0x04), B(0x01)) \
+    INQ(color_b_gain, ALL, 4, bridge_inq_color_b_gain, B(0x09), B(0x04), B(0x44)) \
+    INQ(color_speed, ALL, 1, bridge_inq_color_speed, B(0x09), B(0x04), B(0x56)) \
+    INQ(color_chroma_suppress, ALL, 1, bridge_inq_color_chroma_suppress, B(0x09), B(0x04), B(0x5f)) \
+    INQ(awb_sensitivity, ALL, 1, bridge_inq_awb_sensitivity, B(0x09), B(0x04), B(0xa9)) \
+    INQ(color_offset, ALL, 1, bridge_inq_color_offset, B(0x09), B(0x7e), B(0x01), B(0x2e)) \
+    INQ(color_matrix, ALL, 1, bridge_inq_color_matrix, B(0x09), B(0x7e), B(0x01), B(0x3d)) \
+    INQ(color_rg, ALL, 4, bridge_inq_color_rg, B(0x09), B(0x7e), B(0x01), B(0x7a)) \
+    INQ(color_rb, ALL, 4, bridge_inq_color_rb, B(0x09), B(0x7e), B(0x01), B(0x7b)) \
+    INQ(color_gr, ALL, 4, bridge_inq_color_gr, B(0x09), B(0x7e), B(0x01), B(0x7c)) \
+    INQ(color_gb, ALL, 4, bridge_inq_color_gb, B(0x09), B(0x7e), B(0x01), B(0x7d)) \
+    INQ(color_br, ALL, 4, bridge_inq_color_br, B(0x09), B(0x7e), B(0x01), B(0x7e)) \
+    INQ(color_bg, ALL, 4, bridge_inq_color_bg, B(0x09), B(0x7e), B(0x01), B(0x7f)) \
+    INQ(aperture_mode, ALL, 1, bridge_inq_aperture_mode, B(0x09), B(0x04), B(0x05)) \
+    INQ(detail_mode, ALL, 1, bridge_inq_detail_mode, B(0x09), B(0x05), B(0x42), B(0x01)) \
+    INQ(detail_bandwidth, ALL, 1, bridge_inq_detail_bandwidth, B(0x09), B(0x05), B(0x42), B(0x02)) \
+    INQ(detail_crispening, ALL, 1, bridge_inq_detail_crispening, B(0x09), B(0x05), B(0x42), B(0x03)) \
+    INQ(detail_hv_balance, ALL, 1, bridge_inq_detail_hv_balance, B(0x09), B(0x05), B(0x42), B(0x04)) \
+    INQ(detail_bw_balance, ALL, 1, bridge_inq_detail_bw_balance, B(0x09), B(0x05), B(0x42), B(0x05)) \
+    INQ(detail_limit, ALL, 1, bridge_inq_detail_limit, B(0x09), B(0x05), B(0x42), B(0x06)) \
+    INQ(detail_highlight_detail, ALL, 1, bridge_inq_detail_highlight_detail, \
+        B(0x09), B(0x05), B(0x42), B(0x07)) \
+    INQ(detail_superlow, ALL, 1, bridge_inq_detail_superlow, B(0x09), B(0x05), B(0x42), B(0x08)) \
+    INQ(knee_setting, ALL, 1, bridge_inq_knee_setting, B(0x09), B(0x7e), B(0x01), B(0x6d)) \
+    INQ(knee_mode, ALL, 1, bridge_inq_knee_mode, B(0x09), B(0x7e), B(0x01), B(0x54)) \
+    INQ(knee_slope, ALL, 4, bridge_inq_knee_slope, B(0x09), B(0x7e), B(0x01), B(0x6f)) \
+    INQ(knee_point, ALL, 4, bridge_inq_knee_point, B(0x09), B(0x7e), B(0x01), B(0x6e)) \
+    INQ(gamma_mode, ALL, 1, bridge_inq_gamma_mode, B(0x09), B(0x04), B(0x5b)) \
+    INQ(gamma_offset, ALL, 6, bridge_inq_gamma_offset, B(0x09), B(0x04), B(0x1e)) \
+    INQ(gamma_pattern, ALL, 3, bridge_inq_gamma_pattern, B(0x09), B(0x05), B(0x5b)) \
+    INQ(gamma_black_gamma_range, ALL, 1, bridge_inq_gamma_black_gamma_range, B(0x09), B(0x05), B(0x5c)) \
+    INQ(gamma_level, ALL, 4, bridge_inq_gamma_level, B(0x09), B(0x7e), B(0x01), B(0x71)) \
+    INQ(gamma_black_gamma_level, ALL, 4, bridge_inq_gamma_black_gamma_level, \
+        B(0x09), B(0x7e), B(0x01), B(0x72)) \
+    INQ(gamma_black_level, ALL, 2, bridge_inq_gamma_black_level, B(0x09), B(0x7e), B(0x04), B(0x45)) \
+    INQ(flicker_reduction_on, ALL, 1, bridge_inq_flicker_reduction_on, B(0x09), B(0x04), B(0x32)) \
+    INQ(flicker_mode, ALL, 1, bridge_inq_flicker_mode, B(0x09), B(0x04), B(0x55)) \
+    INQ(noise2_d_mode, ALL, 1, bridge_inq_noise2_d_mode, B(0x09), B(0x04), B(0x50)) \
+    INQ(noise3_d_l, ALL, 1, bridge_inq_noise3_d_l, B(0x09), B(0x04), B(0x54)) \
+    INQ(noise_reduction_manual_setting, ALL, 2, bridge_inq_noise_reduction_manual_setting, \
+        B(0x09), B(0x05), B(0x53)) \
+    INQ(picture_effect_mode, ALL, 1, bridge_inq_picture_effect_mode, B(0x09), B(0x04), B(0x63)) \
+    INQ(lr_reverse, ALL, 1, bridge_inq_lr_reverse, B(0x09), B(0x04), B(0x61)) \
+    INQ(flip, ALL, 1, bridge_inq_flip, B(0x09), B(0x04), B(0xa4)) \
+    /* zoom and focus */ \
+    INQ_DATA(zoom_position, ALL, bridge_inq_zoom_position, B(0x09), B(0x04), B(0x47)) \
+    INQ_DATA(focus_position, ALL, bridge_inq_focus_position, B(0x09), B(0x04), B(0x48)) \
+    INQ(focus_sensitivity, ALL, 1, bridge_inq_focus_sensitivity, B(0x09), B(0x04), B(0x58)) \
+    INQ(focus_near_limit, ALL, 4, bridge_inq_focus_near_limit, B(0x09), B(0x04), B(0x28)) \
+    INQ(focus_ir_correction, ALL, 1, bridge_inq_focus_ir_correction, B(0x09), B(0x04), B(0x11)) \
+    INQ(af_zone, ALL, 1, bridge_inq_af_zone, B(0x09), B(0x04), B(0xaa)) \
+    /* presets and pan tilt */ \
+    INQ(preset, ALL, 1, bridge_inq_preset, B(0x09), B(0x04), B(0x3f)) \
+    INQ(preset_mode, ALL, 1, bridge_inq_preset_mode, B(0x09), B(0x7e), B(0x04), B(0x3d)) \
+    INQ(preset_mode_short, SONY, 1, bridge_inq_preset_mode, B(0x01), B(0x7e), B(0x04)) \
+    INQ(preset_driven_speed, ALL, 1, bridge_inq_preset_driven_speed, B(0x09), B(0x7e), B(0x01), B(0x0b)) \
+    INQ_DATA(pan_tilt_position, ALL, bridge_inq_pan_tilt_position, B(0x09), B(0x06), B(0x12)) \
+    INQ(pan_tilt_status, ALL, 2, bridge_inq_pan_tilt_status, B(0x09), B(0x06), B(0x10)) \
+    INQ(pan_tilt_ramp_curve, ALL, 1, bridge_inq_pan_tilt_ramp_curve, B(0x09), B(0x06), B(0x31)) \
+    INQ(pan_tilt_slow_mode, ALL, 1, bridge_inq_pan_tilt_slow_mode, B(0x09), B(0x06), B(0x44)) \
+    INQ(pan_tilt_limit, SONY, 9, bridge_inq_pan_tilt_limit, B(0x01), B(0x06)) \
+    INQ(ptz_trace_status, ALL, 1, bridge_inq_ptz_trace_status, \
+        B(0x09), B(0x7e), B(0x04), B(0x20), B(0x03)) \
+    INQ(ptz_trace_record_status_bulk, ALL, 4, bridge_inq_ptz_trace_record_status_bulk, \
+        B(0x09), B(0x7e), B(0x04), B(0x20), B(0x10), B(0x00)) \
+    INQ(ptz_trace_record_status_individual, ALL, 1, bridge_inq_ptz_trace_record_status_individual, \
+        B(0x09), B(0x7e), B(0x04), B(0x20), B(0x10), B(0x01)) \
+    INQ(ptz_trace_playback_prep_status, ALL, 1, bridge_inq_ptz_trace_playback_prep_status, \
+        B(0x09), B(0x7e), B(0x04), B(0x20), B(0x01)) \
+    /* system */ \
+    INQ(system_ir_receive, ALL, 1, bridge_inq_system_ir_receive, B(0x09), B(0x06), B(0x08)) \
+    INQ(system_hphase, ALL, 4, bridge_inq_system_hphase, B(0x09), B(0x7e), B(0x01), B(0x3e)) \
+    INQ(system_pan_reverse, ALL, 1, bridge_inq_system_pan_reverse, B(0x09), B(0x7e), B(0x01), B(0x06)) \
+    INQ(system_tilt_reverse, ALL, 1, bridge_inq_system_tilt_reverse, B(0x09), B(0x7e), B(0x01), B(0x09)) \
+    INQ(tally_on, ALL, 1, bridge_inq_tally_on, B(0x09), B(0x7e), B(0x01), B(0x0a)) \
+    INQ(menu_display_status, ALL, 1, bridge_inq_menu_display_status, B(0x09), B(0x06), B(0x06)) \
+    INQ(hdmi_video_format, ALL, 1, bridge_inq_hdmi_video_format, B(0x09), B(0x06), B(0x23)) \
+    INQ(hdmi_color_space, ALL, 1, bridge_inq_hdmi_color_space, B(0x09), B(0x7e), B(0x01), B(0x03))
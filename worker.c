@@ -7,8 +7,12 @@
 #include "errors.h"
 #include "log.h"
 #include "socket.h"
-#include "visca.h"
-#include "sony_visca.h"
+#include "soap_async.h"
+#include "soap_global.h"
+#include "soap_thread.h"
+#include "timer_wheel.h"
+#include "udp_outbox.h"
+#include "visca_framing.h"
 #include "worker.h"
 #include <arpa/inet.h>
 #include <errno.h>
@@ -16,15 +20,17 @@
 #include <limits.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/inotify.h>
 #include <sys/signalfd.h>
 #include <sys/socket.h>
-#include <sys/timerfd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -32,16 +38,57 @@
 #define VOPROXYD_STRING_BUFFERS_EXTEND_LENGTH 4096
 #define VOPROXYD_MAX_EPOLL_EVENTS 128
 #define VOPROXYD_MAX_RX_MESSAGE_LENGTH 4096
+#define VOPROXYD_RX_BATCH 16
+#define VOPROXYD_RX_BUDGET 4
 #define VOPROXYD_SHELL_PATH "/bin/sh"
 #define VOPROXYD_PIPE_READ_BUFFER_LENGTH 8192
 #define VOPROXYD_STRING_BUFFERS_INITIAL_LENGTH 1024
+#define VOPROXYD_DISCOVERY_INTERVAL_MS 30000
 
-int g_current_event_fd;
+_Static_assert(UDP_OUTBOX_CAPACITY >= 2 * VOPROXYD_RX_BUDGET * VOPROXYD_RX_BATCH,
+        "an outbox must hold the replies of a full read turn");
 
-static struct ap_state state;
-static int signal_fd, inotify_fd, timer_fd;
+__thread int g_current_event_fd;
+
+/* fd handed to a shard by another thread, registered by the shard itself. with run set
+   it is a function the shard calls with data instead */
+struct shard_adoption
+{
+    int fd;
+    int type;
+    void *data;
+    void (*run)(void *data);
+    struct shard_adoption *next;
+};
+
+/* one event loop. shard 0 runs on the main thread and also owns signals, config
+   watching, the discovery timer and pipes, the others only serve their cameras */
+struct shard
+{
+    struct ap_state state;
+    pthread_t tid;
+    int wake_fd;
+    atomic_int stop;
+    pthread_mutex_t inbox_lock;
+    struct shard_adoption *inbox;
+};
+
+static struct shard *shards;
+static int next_shard;
+static __thread struct shard *current_shard;
+static int signal_fd, inotify_fd;
+static struct wheel_timer discovery_timer;
 static int can_do_discovery = 1;
 
+/* preallocated receive vector, every datagram of a batch keeps its own source address */
+static __thread struct
+{
+    struct mmsghdr msgs[VOPROXYD_RX_BATCH];
+    struct iovec iovecs[VOPROXYD_RX_BATCH];
+    struct sockaddr_in addrs[VOPROXYD_RX_BATCH];
+    uint8_t buffers[VOPROXYD_RX_BATCH][VOPROXYD_MAX_RX_MESSAGE_LENGTH];
+} rx_batch;
+
 static void string_ensure_fits_substring(char **hay, size_t *hay_buf_length, size_t needle_length)
 {
     size_t hay_length = strlen(*hay);
@@ -139,33 +186,6 @@ static int add_inotify(struct ap_state *state)
     return inotify_fd;
 }
 
-static int add_timer(struct ap_state *state)
-{
-    int timer_fd;
-    struct itimerspec new, old;
-    struct timespec ts;
-
-    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
-    if (timer_fd < 0)
-        die(ERR_TIMER, "failed to create timer fd: %s", strerror(errno));
-
-    memset(&new, 0, sizeof(struct itimerspec));
-    memset(&old, 0, sizeof(struct itimerspec));
-
-    ts.tv_sec = 30;
-    ts.tv_nsec = 0;
-
-    new.it_value = ts;
-    new.it_interval = ts;
-
-    if (timerfd_settime(timer_fd, 0, &new, &old) < 0)
-        die(ERR_TIMER, "failed to set timer interval");
-
-    epoll_add_fd(state, timer_fd, FDT_TIMER, 1);
-
-    return timer_fd;
-}
-
 static int handle_tcp_message(struct ap_state *state, const uint8_t *message, ssize_t length,
         int *close)
 {
@@ -180,45 +200,35 @@ static int handle_tcp_message(struct ap_state *state, const uint8_t *message, ss
 
 static int handle_udp_message(const struct ap_state *state, uint8_t *message, ssize_t length)
 {
-    buffer_t *message_buf = cons_buffer(length);
-
-    free(message_buf->data);
+    buffer_t message_buf = { length, message };
 
-    message_buf->data = message;
-
-    visca_handle_message(message_buf, state->current_event);
-    /* sony_visca_handle_message(message_buf, state->current_event); */
-
-    free(message_buf);
+    visca_framing_handle_message(&message_buf, state->current_event);
 
     return 0;
 }
 
-static int epoll_handle_read_queue_udp(struct ap_state *state)
+static void rx_batch_init()
 {
-    ssize_t message_length;
-    uint8_t rx_message[VOPROXYD_MAX_RX_MESSAGE_LENGTH];
-    struct sockaddr_in addr;
-    socklen_t addr_len = sizeof(addr);
-    int close = 0;
+    for (int i = 0; i < VOPROXYD_RX_BATCH; ++i) {
+        rx_batch.iovecs[i].iov_base = rx_batch.buffers[i];
+        rx_batch.iovecs[i].iov_len = VOPROXYD_MAX_RX_MESSAGE_LENGTH;
 
-    message_length = recvfrom(state->current, rx_message, sizeof(rx_message), MSG_DONTWAIT,
-            (struct sockaddr*)&addr, &addr_len);
+        rx_batch.msgs[i].msg_hdr.msg_iov = &rx_batch.iovecs[i];
+        rx_batch.msgs[i].msg_hdr.msg_iovlen = 1;
+        rx_batch.msgs[i].msg_hdr.msg_name = &rx_batch.addrs[i];
+    }
+}
 
-    state->current_event->addr = (struct sockaddr*)&addr;
-    state->current_event->addr_len = addr_len;
+static int epoll_handle_read_queue_udp(struct ap_state *state)
+{
+    int received;
 
-    if (!(message_length == -1 && errno == EAGAIN))
-        log("recvfrom fd = %d addr = %s:%d message_length = %zd", state->current,
-                inet_ntoa(addr.sin_addr), ntohs(addr.sin_port), message_length);
+    for (int i = 0; i < VOPROXYD_RX_BATCH; ++i)
+        rx_batch.msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
 
-    if (message_length == 0) {
-        log("close connection on socket fd = %d", state->current);
-        epoll_close_fd(state, state->current);
-        return 0;
-    }
+    received = recvmmsg(state->current, rx_batch.msgs, VOPROXYD_RX_BATCH, MSG_DONTWAIT, NULL);
 
-    if (message_length == -1) {
+    if (received == -1) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             errno = 0;
             return 0;
@@ -228,15 +238,83 @@ static int epoll_handle_read_queue_udp(struct ap_state *state)
         die(ERR_READ, "error reading on socket fd = %d: %s", state->current, strerror(errno));
     }
 
-    handle_udp_message(state, rx_message, message_length);
+    log("recvmmsg fd = %d datagrams = %d", state->current, received);
+
+    for (int i = 0; i < received; ++i) {
+        /* replies go back to the controller that sent this datagram */
+        state->current_event->addr = (struct sockaddr*)&rx_batch.addrs[i];
+        state->current_event->addr_len = rx_batch.msgs[i].msg_hdr.msg_namelen;
+
+        if (rx_batch.msgs[i].msg_len == 0) {
+            log("skip empty datagram from %s:%d", inet_ntoa(rx_batch.addrs[i].sin_addr),
+                    ntohs(rx_batch.addrs[i].sin_port));
+            continue;
+        }
+
+        handle_udp_message(state, rx_batch.buffers[i], rx_batch.msgs[i].msg_len);
+    }
 
-    if (close || state->close_after_read) {
+    if (state->close_after_read) {
         state->close_after_read = 0;
         epoll_close_fd(state, state->current);
         return 0;
     }
 
-    return 1;
+    /* a short batch means the socket queue was drained */
+    return received == VOPROXYD_RX_BATCH;
+}
+
+#ifdef VOPROXYD_URING
+static void handle_uring_datagram(struct ap_state *state, struct event_t *event,
+        struct sockaddr *addr, socklen_t addr_len, uint8_t *data, size_t length)
+{
+    state->current_event = event;
+    state->current = event->fd;
+    g_current_event_fd = event->fd;
+
+    event->addr = addr;
+    event->addr_len = addr_len;
+
+    if (length == 0)
+        return;
+
+    handle_udp_message(state, data, length);
+}
+#endif
+
+/* reads at most VOPROXYD_RX_BUDGET batches, a socket with data left goes to the back of the
+   ready list so one flooding controller can't starve the other fds */
+static void epoll_drain_udp(struct ap_state *state)
+{
+    int continue_reading = 1;
+
+    for (int i = 0; i < VOPROXYD_RX_BUDGET && continue_reading; ++i)
+        continue_reading = epoll_handle_read_queue_udp(state);
+
+    if (state->current_event->outbox != NULL)
+        udp_outbox_flush(state->current_event->outbox);
+
+    if (continue_reading)
+        epoll_push_ready(state, state->current_event);
+}
+
+/* one round over the sockets that were ready before it started */
+static void run_ready_list(struct ap_state *state)
+{
+    struct event_t *event;
+
+    for (size_t n = state->ready_count; n > 0; --n) {
+        event = epoll_pop_ready(state);
+        if (event == NULL)
+            break;
+
+        state->close_after_read = 0;
+        state->current_event = event;
+        state->current = event->fd;
+        g_current_event_fd = event->fd;
+
+        epoll_drain_udp(state);
+    }
 }
 
 static void epoll_handle_signal(int signal_fd, int *running)
@@ -360,6 +438,7 @@ static int get_waitpid_exit_code(int waitpid_status)
 
 static void run_command(struct ap_state *state, const char *command)
 {
+    struct event_t *event;
     int pipe_fds[2];
     pid_t pid;
 
@@ -385,21 +464,17 @@ static void run_command(struct ap_state *state, const char *command)
 
     close(pipe_fds[1]);
 
-    epoll_add_fd(state, pipe_fds[0], FDT_PIPE, 1);
+    event = epoll_add_fd(state, pipe_fds[0], FDT_PIPE, 1);
 
-    /* dumb */
-    for (struct tracking_ll_t *it = state->tracked_events; it != NULL; it = it->next)
-        if (it->event->type == FDT_PIPE && it->event->fd == pipe_fds[0]) {
-            it->event->child_pid = pid;
+    event->child_pid = pid;
 
-            it->event->command_output_len = VOPROXYD_STRING_BUFFERS_INITIAL_LENGTH;
+    event->command_output_len = VOPROXYD_STRING_BUFFERS_INITIAL_LENGTH;
 
-            it->event->command_output = malloc(it->event->command_output_len * sizeof(char));
-            if (!it->event->command_output)
-                die(ERR_NOMEM, "failed to malloc(%zd)", it->event->command_output_len);
+    event->command_output = malloc(event->command_output_len * sizeof(char));
+    if (!event->command_output)
+        die(ERR_NOMEM, "failed to malloc(%zd)", event->command_output_len);
 
-            it->event->command_output[0] = '\0';
-        }
+    event->command_output[0] = '\0';
 }
 
 static void epoll_handle_pipe(struct ap_state *state, int *continue_reading)
@@ -430,15 +505,7 @@ static void epoll_handle_pipe(struct ap_state *state, int *continue_reading)
 
 static void free_command(struct ap_state *state)
 {
-    free(state->current_event->command_output);
-
     epoll_close_fd(state, state->current);
-
-    for (struct tracking_ll_t *it = state->tracked_events; it != NULL; it = it->next)
-        if (it->event->type == FDT_PIPE && it->event->fd == state->current) {
-            ll_delete_node(&state->tracked_events, it);
-            break;
-        }
 }
 
 static void epoll_handle_pipe_queue(struct ap_state *state)
@@ -464,15 +531,13 @@ static void epoll_handle_pipe_queue(struct ap_state *state)
     log("read pipe buffer");
 }
 
-static void epoll_handle_timer(struct ap_state *state)
+static void discovery_tick(void *data)
 {
-    uint64_t value;
-
     log("timer tick");
     worker_do_external_discovery();
     print_mem_usage();
 
-    read(state->current, &value, 8);
+    timer_wheel_schedule(&discovery_timer, VOPROXYD_DISCOVERY_INTERVAL_MS);
 }
 
 static void epoll_handle_hangup(struct ap_state *state)
@@ -499,13 +564,55 @@ static void epoll_handle_hangup(struct ap_state *state)
     free_command(state);
 }
 
+static void adopt_fd(struct ap_state *state, int fd, int type, void *data)
+{
+    struct event_t *event = epoll_add_fd(state, fd, type, 1);
+
+    event->data = data;
+
+    if (type == FDT_UDP)
+        event->outbox = udp_outbox_create(state, event);
+}
+
+static void epoll_handle_wake(int *running)
+{
+    struct shard_adoption *it, *next;
+    uint64_t value;
+
+    if (read(current_shard->wake_fd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+        die(ERR_READ, "failed to read wake fd: %s", strerror(errno));
+
+    pthread_mutex_lock(&current_shard->inbox_lock);
+    it = current_shard->inbox;
+    current_shard->inbox = NULL;
+    pthread_mutex_unlock(&current_shard->inbox_lock);
+
+    for (; it != NULL; it = next) {
+        next = it->next;
+        if (it->run != NULL)
+            it->run(it->data);
+        else
+            adopt_fd(&current_shard->state, it->fd, it->type, it->data);
+        free(it);
+    }
+
+    if (atomic_load(&current_shard->stop))
+        *running = 0;
+}
+
 static void epoll_handle_event(struct ap_state *state, const struct epoll_event *event, int *running)
 {
-    int continue_reading = 1, client_fd;
+    int client_fd;
 
     if (state->current_event->type == FDT_INOTIFY)
         return;
 
+    /* onvif sockets report their own connect and hangup errors, so they skip the checks below */
+    if (state->current_event->type == FDT_SOAP) {
+        soap_async_handle_event(state->current_event, event->events);
+        return;
+    }
+
     log(" ");
     log("new event on fd = %d", state->current);
 
@@ -527,9 +634,13 @@ static void epoll_handle_event(struct ap_state *state, const struct epoll_event
             epoll_add_fd(state, client_fd, FDT_TCP, 1);
             break;
         case FDT_UDP:
-            while (continue_reading) {
-                continue_reading = epoll_handle_read_queue_udp(state);
-            }
+            if (event->events & (unsigned)EPOLLOUT)
+                udp_outbox_handle_writable(state->current_event->outbox);
+
+            if (!(event->events & (unsigned)EPOLLIN))
+                break;
+
+            epoll_drain_udp(state);
             break;
         case FDT_SIGNAL:
             epoll_handle_signal(state->current, running);
@@ -540,9 +651,17 @@ static void epoll_handle_event(struct ap_state *state, const struct epoll_event
         case FDT_PIPE:
             epoll_handle_pipe_queue(state);
             break;
-        case FDT_TIMER:
-            epoll_handle_timer(state);
+        case FDT_EVENTFD:
+            soap_thread_handle_completions(state->current_event);
+            break;
+        case FDT_WAKE:
+            epoll_handle_wake(running);
+            break;
+#ifdef VOPROXYD_URING
+        case FDT_URING:
+            uring_handle_completions(state, handle_uring_datagram);
             break;
+#endif
         default:
             die(ERR_EPOLL_EVENT, "epoll_handle_event: unknown event type %d",
                     state->current_event->type);
@@ -555,7 +674,8 @@ static void main_loop(struct ap_state *state)
     int num_events, ev_idx, running = 1;
 
     while (running) {
-        num_events = epoll_wait(state->epoll_fd, events, VOPROXYD_MAX_EPOLL_EVENTS, -1);
+        num_events = epoll_wait(state->epoll_fd, events, VOPROXYD_MAX_EPOLL_EVENTS,
+                state->ready_head != NULL ? 0 : timer_wheel_next_timeout());
 
         if (num_events == -1 && errno != EINTR) {
             die(ERR_EPOLL_WAIT, "epoll_wait() failed: %s", strerror(errno));
@@ -567,45 +687,221 @@ static void main_loop(struct ap_state *state)
             state->current = state->current_event->fd;
             epoll_handle_event(state, &events[ev_idx], &running);
         }
+
+        run_ready_list(state);
+
+        udp_outbox_flush_all();
+
+#ifdef VOPROXYD_URING
+        uring_submit(state);
+#endif
+
+        timer_wheel_run();
     }
 }
 
+static void shard_construct(struct shard *shard)
+{
+    memset(&shard->state, 0, sizeof(struct ap_state));
+
+    shard->state.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (shard->state.epoll_fd == -1)
+        die(ERR_EPOLL_CREATE, "epoll_create1() failed: %s", strerror(errno));
+
+    shard->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (shard->wake_fd == -1)
+        die(ERR_THREAD, "eventfd() failed: %s", strerror(errno));
+
+#ifdef VOPROXYD_URING
+    uring_construct(&shard->state);
+#endif
+
+    atomic_init(&shard->stop, 0);
+    pthread_mutex_init(&shard->inbox_lock, NULL);
+    shard->inbox = NULL;
+
+    epoll_add_fd(&shard->state, shard->wake_fd, FDT_WAKE, 1);
+}
+
+static void shard_destruct(struct shard *shard)
+{
+#ifdef VOPROXYD_URING
+    uring_destruct(&shard->state);
+#endif
+
+    epoll_free_events(&shard->state);
+
+    pthread_mutex_destroy(&shard->inbox_lock);
+
+    close(shard->wake_fd);
+    close(shard->state.epoll_fd);
+}
+
+static void shard_wake(struct shard *shard)
+{
+    uint64_t one = 1;
+
+    while (write(shard->wake_fd, &one, sizeof(one)) == -1 && errno == EINTR)
+        ;
+}
+
+static void* shard_main(void *arg)
+{
+    current_shard = arg;
+
+    soap_global_construct();
+    timer_wheel_init();
+    rx_batch_init();
+
+    main_loop(&current_shard->state);
+
+    shard_destruct(current_shard);
+    soap_global_destruct();
+
+    return NULL;
+}
+
 void worker_init()
 {
-    memset(&state, 0, sizeof(struct ap_state));
+    if (g_shards < 1)
+        die(ERR_INVALID_ARGS, "number of shards must be positive");
+
+    shards = calloc(g_shards, sizeof(struct shard));
+    if (shards == NULL)
+        die(ERR_NOMEM, "failed to calloc(%zd)", g_shards * sizeof(struct shard));
+
+    for (int i = 0; i < g_shards; ++i)
+        shard_construct(&shards[i]);
+
+    current_shard = &shards[0];
 
     g_current_event_fd = 0;
 
-    state.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
-    if (state.epoll_fd == -1)
-        die(ERR_EPOLL_CREATE, "epoll_create1() failed: %s", strerror(errno));
+    signal_fd = add_signal_handler(&current_shard->state);
+
+    inotify_fd = add_inotify(&current_shard->state);
 
-    signal_fd = add_signal_handler(&state);
+    timer_wheel_init();
 
-    inotify_fd = add_inotify(&state);
+    wheel_timer_init(&discovery_timer, discovery_tick, NULL);
+    timer_wheel_schedule(&discovery_timer, VOPROXYD_DISCOVERY_INTERVAL_MS);
 
-    timer_fd = add_timer(&state);
+    rx_batch_init();
 
-    log("epoll fd = %d sig fd = %d infy fd = %d", state.epoll_fd, signal_fd, inotify_fd);
+    log("epoll fd = %d sig fd = %d infy fd = %d shards = %d", current_shard->state.epoll_fd,
+            signal_fd, inotify_fd, g_shards);
     log(" ");
 }
 
 void worker_start()
 {
+    int err;
+
+    /* SIGINT is blocked by now, so only the signalfd of shard 0 sees it */
+    for (int i = 1; i < g_shards; ++i) {
+        err = pthread_create(&shards[i].tid, NULL, shard_main, &shards[i]);
+        if (err != 0)
+            die(ERR_THREAD, "pthread_create() failed: %s", strerror(err));
+    }
+
     log("start main loop");
-    main_loop(&state);
+    main_loop(&current_shard->state);
+
+    for (int i = 1; i < g_shards; ++i) {
+        atomic_store(&shards[i].stop, 1);
+        shard_wake(&shards[i]);
+        pthread_join(shards[i].tid, NULL);
+    }
 
-    ll_free_list(&state.tracked_events);
+    shard_destruct(&shards[0]);
 
-    close(timer_fd);
     close(inotify_fd);
     close(signal_fd);
-    close(state.epoll_fd);
+
+    free(shards);
+}
+
+/* cameras are spread over the shards round robin */
+int worker_pick_shard()
+{
+    int shard = next_shard;
+
+    next_shard = (next_shard + 1) % g_shards;
+
+    return shard;
+}
+
+static void post(struct shard *shard, int fd, int type, void *data, void (*run)(void *data))
+{
+    struct shard_adoption *adoption = malloc(sizeof(struct shard_adoption));
+    if (adoption == NULL)
+        die(ERR_NOMEM, "failed to malloc(%zd)", sizeof(struct shard_adoption));
+
+    adoption->fd = fd;
+    adoption->type = type;
+    adoption->data = data;
+    adoption->run = run;
+
+    pthread_mutex_lock(&shard->inbox_lock);
+    adoption->next = shard->inbox;
+    shard->inbox = adoption;
+    pthread_mutex_unlock(&shard->inbox_lock);
+
+    shard_wake(shard);
+}
+
+void worker_adopt_fd(int shard_idx, int fd, int type, void *data)
+{
+    struct shard *shard = &shards[shard_idx];
+
+    if (shard == current_shard) {
+        adopt_fd(&shard->state, fd, type, data);
+        return;
+    }
+
+    post(shard, fd, type, data, NULL);
+}
+
+/* runs fn on the event loop of the shard, for state only that shard may change */
+void worker_run_on_shard(int shard_idx, void (*fn)(void *data), void *data)
+{
+    struct shard *shard = &shards[shard_idx];
+
+    if (shard == current_shard) {
+        fn(data);
+        return;
+    }
+
+    post(shard, -1, 0, data, fn);
+}
+
+void worker_add_udp_fd(int fd, int shard)
+{
+    worker_adopt_fd(shard, fd, FDT_UDP, NULL);
+}
+
+struct event_t* worker_add_fd(int fd, int type, int in, void *data)
+{
+    struct event_t *event = epoll_add_fd(&current_shard->state, fd, type, in);
+
+    event->data = data;
+
+    return event;
+}
+
+void worker_watch_fd(struct event_t *event, int in)
+{
+    epoll_mod_fd(&current_shard->state, event, in);
+}
+
+void worker_want_write(struct event_t *event, int want)
+{
+    epoll_want_write(&current_shard->state, event, want);
 }
 
-void worker_add_udp_fd(int fd)
+void worker_forget_fd(struct event_t *event)
 {
-    epoll_add_fd(&state, fd, FDT_UDP, 1);
+    epoll_remove_event(&current_shard->state, event);
 }
 
 void worker_do_external_discovery()
@@ -614,6 +910,6 @@ void worker_do_external_discovery()
         return;
 
     log("starting external discovery...");
-    run_command(&state, "discover | grep 192 | cut -d' ' -f 3");
+    run_command(&current_shard->state, "discover | grep 192 | cut -d' ' -f 3");
 }
 
@@ -1,9 +1,19 @@
 #pragma once
 
-extern int g_current_event_fd;
+struct event_t;
+
+extern __thread int g_current_event_fd;
+extern int g_shards;
 
 void worker_init();
 void worker_start();
-void worker_add_udp_fd(int fd);
+int worker_pick_shard();
+void worker_adopt_fd(int shard, int fd, int type, void *data);
+void worker_run_on_shard(int shard, void (*fn)(void *data), void *data);
+void worker_add_udp_fd(int fd, int shard);
+struct event_t* worker_add_fd(int fd, int type, int in, void *data);
+void worker_watch_fd(struct event_t *event, int in);
+void worker_want_write(struct event_t *event, int want);
+void worker_forget_fd(struct event_t *event);
 void worker_do_external_discovery();
 